@@ -0,0 +1,194 @@
+/**
+ * Microbenchmark comparing the byte arena atom storage against the
+ * std::stringstream storage it replaced.
+ *
+ * Both implementations perform the same work as page::insert_object()
+ * and page::fetch_object(): append a value at the end of the atom and
+ * remember its offset, then read every value back by offset.
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <cell/cpp/byte_arena.h>
+
+namespace {
+
+typedef std::chrono::high_resolution_clock clock_type;
+
+const std::size_t k_iterations = 1000000;
+
+/**
+ * The atom data storage as it was implemented with iostreams.
+ */
+class stream_atom
+{
+   std::stringstream data;
+
+public:
+   stream_atom() :
+         data(std::stringstream::in | std::stringstream::out
+               | std::stringstream::binary)
+   {
+   }
+
+   template<typename T>
+   std::streampos insert(const T& value)
+   {
+      data.seekp(0, std::ios::end);
+      auto pos = data.tellp();
+      data.write(static_cast<const char*>(static_cast<const void*>(&value)),
+            sizeof(value));
+
+      return pos;
+   }
+
+   std::streampos insert(const std::string& value)
+   {
+      std::uint32_t size = value.size();
+      auto pos = insert(size);
+      data.write(value.c_str(), size);
+
+      return pos;
+   }
+
+   template<typename T>
+   void fetch(const std::streampos& pos, T& value)
+   {
+      data.seekg(pos);
+      data.read(static_cast<char*>(static_cast<void*>(&value)), sizeof(value));
+   }
+
+   void fetch(const std::streampos& pos, std::string& value)
+   {
+      std::uint32_t size = 0;
+      fetch(pos, size);
+
+      value.resize(size);
+      data.read(&value[0], size);
+   }
+};
+
+/**
+ * The atom data storage as it is implemented with a byte arena.
+ */
+class arena_atom
+{
+   lattice::cell::byte_arena data;
+
+public:
+   typedef lattice::cell::byte_arena::offset_type offset_type;
+
+   template<typename T>
+   offset_type insert(const T& value)
+   {
+      return data.append(&value, sizeof(value));
+   }
+
+   offset_type insert(const std::string& value)
+   {
+      std::uint32_t size = value.size();
+      auto pos = insert(size);
+      data.append(value.c_str(), size);
+
+      return pos;
+   }
+
+   template<typename T>
+   void fetch(offset_type pos, T& value)
+   {
+      std::memcpy(&value, data.at(pos), sizeof(value));
+   }
+
+   void fetch(offset_type pos, std::string& value)
+   {
+      std::uint32_t size = 0;
+      fetch(pos, size);
+
+      value.assign(
+            static_cast<const char*>(static_cast<const void*>(data.at(pos)
+                  + sizeof(size))), size);
+   }
+};
+
+std::size_t weigh(std::int64_t value)
+{
+   return value;
+}
+
+std::size_t weigh(const std::string& value)
+{
+   return value.size();
+}
+
+double elapsed_ms(const clock_type::time_point& start)
+{
+   return std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+}
+
+void report(const std::string& name, double ms)
+{
+   std::cout << name << ": " << ms << " ms ("
+         << (k_iterations / ms) * 1000.0 << " ops/s)" << std::endl;
+}
+
+template<typename Atom, typename T>
+void run(const std::string& name, const std::vector<T>& values)
+{
+   typedef decltype(std::declval<Atom>().insert(values[0])) offset_type;
+
+   Atom atom;
+   std::vector<offset_type> offsets;
+   offsets.reserve(values.size());
+
+   auto start = clock_type::now();
+   for (const auto& v : values)
+      {
+         offsets.push_back(atom.insert(v));
+      }
+   report(name + " insert", elapsed_ms(start));
+
+   T value;
+   std::size_t checksum = 0;
+
+   start = clock_type::now();
+   for (const auto& pos : offsets)
+      {
+         atom.fetch(pos, value);
+         checksum += weigh(value);
+      }
+   report(name + " fetch", elapsed_ms(start));
+
+   // Keep the compiler from discarding the fetch loop.
+   if (checksum == 0)
+      {
+         std::cout << std::endl;
+      }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+   std::vector<std::int64_t> ints;
+   std::vector<std::string> strings;
+
+   for (std::size_t i = 0; i < k_iterations; ++i)
+      {
+         ints.push_back(i * 7);
+         strings.push_back("value " + std::to_string(i));
+      }
+
+   run<stream_atom>("stream bigint", ints);
+   run<arena_atom>("arena  bigint", ints);
+
+   run<stream_atom>("stream varchar", strings);
+   run<arena_atom>("arena  varchar", strings);
+
+   return 0;
+}
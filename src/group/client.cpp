@@ -21,6 +21,25 @@ void manager::query_processor_thread()
          // We never reply to messages out of order. 0MQ doesn't allow
          // it, and that simplifies our life.
 
+         // The router hands each cell its part of the request on the
+         // cell's own thread and gathers the responses, so the cells work
+         // on a request in parallel. Requests are still taken one at a time.
+         cell::CommandRequest request;
+         cell::CommandResponse reply;
+         if (request.ParseFromArray(msg.data(), msg.size()))
+            {
+               // The router sends the request on to the cells that own
+               // the data.
+               reply = router.process(request);
+            }
+         else
+            {
+               reply.set_kind(cell::CommandResponse::ERROR);
+               reply.set_error("the request could not be parsed");
+            }
+
+         auto out = reply.SerializeAsString();
+         response.send(out.c_str(), out.size());
       }
 }
 
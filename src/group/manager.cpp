@@ -1,5 +1,6 @@
 #include <chrono>
 #include <mutex>
+#include <sstream>
 
 #include <apr-1/apr_signal.h>
 #include <log4cxx/logger.h>
@@ -41,17 +42,14 @@ void manager::start()
    apr_signal((int) SIGINT, manager::sig_term_handler);
    apr_signal((int) SIGTERM, manager::sig_term_handler);
 
-   // Start the cell processors.
-   for (auto i = 0; i < std::thread::hardware_concurrency(); ++i)
+   // Start a thread for each cell to listen to the control channel. The
+   // router runs each cell's share of a request on a thread of its own.
+   for (auto i = 0; i < router.size(); ++i)
       {
-         auto* processor = new cell::command_processor();
-         processors.push_back(processor);
-
          // Create a new thread.
          threads.push_back(
                new std::thread([&]
                   {
-                     auto* cp = processor;
                      zmq::socket_t control(ctx, ZMQ_SUB);
 
                      // Subscribe to the control channel.
@@ -14,7 +14,7 @@
 #include <zmq.hpp>
 
 #include <edge/cpp/discovery.h>
-#include <cell/cpp/command_processor.h>
+#include <cell/cpp/command_router.h>
 
 namespace lattice {
 namespace group {
@@ -22,7 +22,10 @@ namespace group {
 class manager
 {
    zmq::context_t &ctx;
-   std::vector<cell::command_processor*> processors;
+
+   /** Routes requests to the cells, one per hardware thread. */
+   cell::command_router router;
+
    std::vector<std::thread*> threads;
 
    bool continue_processing;
@@ -39,7 +42,8 @@ private:
 
 public:
    manager(zmq::context_t &_ctx) :
-         ctx(_ctx), continue_processing(true), disc(28001)
+         ctx(_ctx), router(std::thread::hardware_concurrency()),
+         continue_processing(true), disc(28001)
    {
    }
 
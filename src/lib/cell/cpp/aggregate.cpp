@@ -0,0 +1,226 @@
+#include <sstream>
+#include <tuple>
+
+#include <cell/cpp/aggregate.h>
+
+namespace lattice {
+namespace cell {
+
+/**
+ * Turns a value into a partial result of one value.
+ */
+static aggregate::partial to_partial(const data_value& v)
+{
+   typedef aggregate::partial::value_kind value_kind;
+
+   aggregate::partial p;
+
+   switch (v.get_type())
+      {
+      case column::data_type::smallint:
+      case column::data_type::integer:
+      case column::data_type::bigint:
+         p.set(1, value_kind::INTEGER, v.as_bigint().raw_int64_value(), 0,
+               std::string());
+      break;
+
+      case column::data_type::real:
+      case column::data_type::double_precision:
+         p.set(1, value_kind::REAL, 0,
+               v.as_double_precision().raw_double_value(), std::string());
+      break;
+
+      case column::data_type::varchar:
+         p.set(1, value_kind::TEXT, 0, 0, *v.raw_string_value());
+      break;
+
+      default:
+         p.add_rows(1);
+      break;
+      }
+
+   return p;
+}
+
+void aggregate::partial::add(function f, const data_value& v)
+{
+   merge(f, to_partial(v));
+}
+
+void aggregate::partial::merge(function f, const partial& o)
+{
+   count += o.count;
+
+   if (f == function::COUNT || o.kind == value_kind::NONE)
+      {
+         return;
+      }
+
+   if (kind == value_kind::NONE)
+      {
+         kind = o.kind;
+         int_value = o.int_value;
+         real_value = o.real_value;
+         text_value = o.text_value;
+         return;
+      }
+
+   // Text can only be compared.
+   bool less;
+   switch (kind)
+      {
+      case value_kind::INTEGER:
+         if (f == function::SUM || f == function::AVG)
+            {
+               int_value += o.int_value;
+               return;
+            }
+         less = o.int_value < int_value;
+      break;
+
+      case value_kind::REAL:
+         if (f == function::SUM || f == function::AVG)
+            {
+               real_value += o.real_value;
+               return;
+            }
+         less = o.real_value < real_value;
+      break;
+
+      case value_kind::TEXT:
+         if (f == function::SUM || f == function::AVG)
+            {
+               return;
+            }
+         less = o.text_value < text_value;
+      break;
+
+      default:
+         return;
+      }
+
+   if ((f == function::MIN) == less)
+      {
+         int_value = o.int_value;
+         real_value = o.real_value;
+         text_value = o.text_value;
+      }
+}
+
+aggregate::aggregate(term_list_type _terms,
+      std::vector<unsigned int> _group_by) :
+      terms(std::move(_terms)), group_by(std::move(_group_by))
+{
+   if (group_by.empty())
+      {
+         groups[group_key_type()].resize(terms.size());
+      }
+}
+
+std::vector<bool> aggregate::start(unsigned int number_of_columns)
+{
+   std::vector<bool> present(number_of_columns, false);
+
+   for (auto& t : terms)
+      {
+         if (t.column_number < number_of_columns)
+            {
+               present[t.column_number] = true;
+            }
+      }
+
+   for (auto column_number : group_by)
+      {
+         if (column_number < number_of_columns)
+            {
+               present[column_number] = true;
+            }
+      }
+
+   locations.assign(number_of_columns, location_type(nullptr, 0));
+   return present;
+}
+
+page* aggregate::find_value(unsigned int column_number,
+      const page::byte_type*& data)
+{
+   if (column_number >= locations.size())
+      {
+         return nullptr;
+      }
+
+   auto& location = locations[column_number];
+   if (location.first == nullptr || location.second == 0)
+      {
+         return nullptr;
+      }
+
+   auto found = location.first->get_data(location.second);
+   if (!std::get<0>(found))
+      {
+         return nullptr;
+      }
+
+   data = std::get<1>(found);
+   return location.first;
+}
+
+void aggregate::add_row()
+{
+   group_key_type key;
+   for (auto column_number : group_by)
+      {
+         const page::byte_type* data;
+         auto p = find_value(column_number, data);
+         if (p == nullptr)
+            {
+               key.emplace_back();
+               continue;
+            }
+
+         data_value v(p->get_column_definition()->type);
+         v.read(data);
+
+         std::stringstream out;
+         v.write(out);
+         key.push_back(out.str());
+      }
+
+   auto& partials = groups[key];
+   partials.resize(terms.size());
+
+   for (std::size_t i = 0; i < terms.size(); ++i)
+      {
+         auto& t = terms[i];
+         if (t.column_number == k_all_rows)
+            {
+               partials[i].add_rows(1);
+               continue;
+            }
+
+         // Nulls are not aggregated.
+         const page::byte_type* data;
+         auto p = find_value(t.column_number, data);
+         if (p != nullptr)
+            {
+               data_value v(p->get_column_definition()->type);
+               v.read(data);
+               partials[i].add(t.f, v);
+            }
+      }
+}
+
+void aggregate::merge(const group_key_type& key,
+      const partial_list_type& partials)
+{
+   auto& into = groups[key];
+   into.resize(terms.size());
+
+   for (std::size_t i = 0; i < terms.size() && i < partials.size(); ++i)
+      {
+         into[i].merge(terms[i].f, partials[i]);
+      }
+}
+
+} // namespace cell
+} // namespace lattice
@@ -0,0 +1,231 @@
+#ifndef __LATTICE_CELL_AGGREGATE_H__
+#define __LATTICE_CELL_AGGREGATE_H__
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <cell/cpp/data_value.h>
+#include <cell/cpp/page.h>
+
+namespace lattice {
+namespace cell {
+
+/**
+ * Computes aggregates over rows, grouped by the values of some columns.
+ *
+ * The results are partial: each cell aggregates its own rows, and the
+ * partial results are merged afterwards. AVG is kept as a sum and a
+ * count for this reason, and only divided once everything is merged.
+ */
+class aggregate
+{
+public:
+   /** The aggregate functions. */
+   enum class function
+   {
+      COUNT,
+      SUM,
+      MIN,
+      MAX,
+      AVG
+   };
+
+   /** The column number of COUNT(*), which counts rows. */
+   static const unsigned int k_all_rows =
+         std::numeric_limits<unsigned int>::max();
+
+   /** One aggregate to compute. */
+   typedef struct
+   {
+      function f;
+
+      // The column aggregated, or k_all_rows.
+      unsigned int column_number;
+   } term_type;
+
+   typedef std::vector<term_type> term_list_type;
+
+   /**
+    * The partial result of one term. Integers are summed and compared as
+    * 64 bit integers, and reals as doubles.
+    */
+   class partial
+   {
+   public:
+      /** Which of the values is set. */
+      enum class value_kind
+      {
+         NONE,
+         INTEGER,
+         REAL,
+         TEXT
+      };
+
+   private:
+      /** The number of rows, or of values for a column. */
+      std::uint64_t count;
+
+      value_kind kind;
+
+      std::int64_t int_value;
+      double real_value;
+      std::string text_value;
+
+   public:
+      partial() :
+            count(0), kind(value_kind::NONE), int_value(0), real_value(0)
+      {
+      }
+
+      /**
+       * Adds rows without looking at any values, as COUNT does.
+       */
+      void add_rows(std::uint64_t rows)
+      {
+         count += rows;
+      }
+
+      /**
+       * Adds a value.
+       *
+       * @param f: The function being computed.
+       * @param v: The value. Types that cannot be summed, compared or
+       *           counted are only counted.
+       */
+      void add(function f, const data_value& v);
+
+      /**
+       * Merges another partial result of the same term into this one.
+       */
+      void merge(function f, const partial& o);
+
+      /**
+       * Sets the result directly, as read back from a message.
+       */
+      void set(std::uint64_t _count, value_kind _kind, std::int64_t i,
+            double d, const std::string& s)
+      {
+         count = _count;
+         kind = _kind;
+         int_value = i;
+         real_value = d;
+         text_value = s;
+      }
+
+      std::uint64_t get_count() const
+      {
+         return count;
+      }
+
+      value_kind get_kind() const
+      {
+         return kind;
+      }
+
+      std::int64_t get_int_value() const
+      {
+         return int_value;
+      }
+
+      double get_real_value() const
+      {
+         return real_value;
+      }
+
+      const std::string& get_text_value() const
+      {
+         return text_value;
+      }
+   };
+
+   typedef std::vector<partial> partial_list_type;
+
+   /** The binary values of the grouping columns, empty for null. */
+   typedef std::vector<std::string> group_key_type;
+
+   typedef std::map<group_key_type, partial_list_type> group_map_type;
+
+   /** Where a column of the current row is stored. */
+   typedef std::pair<page*, page::object_id_type> location_type;
+
+private:
+   term_list_type terms;
+
+   std::vector<unsigned int> group_by;
+
+   group_map_type groups;
+
+   /** The columns of the row being added, by column number. */
+   std::vector<location_type> locations;
+
+   /**
+    * Finds the value of a column of the row being added.
+    *
+    * @param data: Receives the bytes of the value.
+    *
+    * @returns: The page holding the value, which gives its type, or
+    * nullptr if the row has no value for the column.
+    */
+   page* find_value(unsigned int column_number, const page::byte_type*& data);
+
+public:
+   /**
+    * @param _terms: The aggregates to compute.
+    * @param _group_by: The columns to group by. Without any, there is
+    *                   a single group, even if there are no rows.
+    */
+   aggregate(term_list_type _terms, std::vector<unsigned int> _group_by);
+
+   const term_list_type& get_terms() const
+   {
+      return terms;
+   }
+
+   const std::vector<unsigned int>& get_group_by() const
+   {
+      return group_by;
+   }
+
+   group_map_type& get_groups()
+   {
+      return groups;
+   }
+
+   /**
+    * Prepares to add rows from a table.
+    *
+    * @param number_of_columns: The number of columns in the table.
+    *
+    * @returns: The columns that need to be read from each row. If only
+    * rows are counted, there are none.
+    */
+   std::vector<bool> start(unsigned int number_of_columns);
+
+   /**
+    * Records where a column of the row being added is stored.
+    */
+   void locate(unsigned int column_number, page& p, page::object_id_type oid)
+   {
+      locations[column_number] = location_type(&p, oid);
+   }
+
+   /**
+    * Adds the row whose columns were located to its group.
+    */
+   void add_row();
+
+   /**
+    * Merges the partial results of a group, from another aggregate of
+    * the same terms.
+    */
+   void merge(const group_key_type& key, const partial_list_type& partials);
+};
+
+} // namespace cell
+} // namespace lattice
+
+#endif // __LATTICE_CELL_AGGREGATE_H__
@@ -0,0 +1,163 @@
+#ifndef __LATTICE_CELL_BYTE_ARENA_H__
+#define __LATTICE_CELL_BYTE_ARENA_H__
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace lattice {
+namespace cell {
+
+/**
+ * A contiguous, growable block of bytes. Objects are appended to the end
+ * of the arena and addressed by their byte offset from the start, so
+ * readers can work directly on raw memory instead of going through a
+ * stream.
+ *
+ * Pointers returned by the arena are only valid until the next call that
+ * may grow it. Offsets remain valid for the lifetime of the arena.
+ */
+class byte_arena
+{
+public:
+	/** The type of bytes stored in the arena. */
+	typedef unsigned char byte_type;
+
+	/** The type of an offset into the arena. */
+	typedef std::uint32_t offset_type;
+
+	/** The type for parameters indicating size. */
+	typedef std::size_t size_type;
+
+private:
+	/** The smallest allocation the arena will make. */
+	static const size_type k_min_capacity = 256;
+
+	/** The storage area. */
+	std::unique_ptr<byte_type[]> data;
+
+	/** The number of bytes written to the arena. */
+	size_type used;
+
+	/** The number of bytes allocated for the arena. */
+	size_type allocated;
+
+	/**
+	 * Grows the storage area so that at least 'needed' bytes fit. The
+	 * capacity is doubled to keep appends amortized constant time.
+	 */
+	void grow(size_type needed)
+	{
+		size_type new_capacity = k_min_capacity;
+		new_capacity = std::max(new_capacity, std::max(allocated * 2, needed));
+
+		std::unique_ptr<byte_type[]> new_data(new byte_type[new_capacity]);
+		if (used > 0)
+			{
+				std::memcpy(new_data.get(), data.get(), used);
+			}
+
+		data = std::move(new_data);
+		allocated = new_capacity;
+	}
+
+public:
+	byte_arena() :
+			used(0), allocated(0)
+	{
+	}
+
+	/**
+	 * The number of bytes written to the arena.
+	 */
+	size_type size() const
+	{
+		return used;
+	}
+
+	/**
+	 * The number of bytes the arena can hold before it must grow.
+	 */
+	size_type capacity() const
+	{
+		return allocated;
+	}
+
+	/**
+	 * Makes sure the arena can hold at least 'bytes' bytes without
+	 * growing.
+	 */
+	void reserve(size_type bytes)
+	{
+		if (bytes > allocated)
+			{
+				grow(bytes);
+			}
+	}
+
+	/**
+	 * Reserves space for 'bytes' bytes at the end of the arena.
+	 *
+	 * @param bytes: The number of bytes to reserve.
+	 *
+	 * @returns: A pointer to the reserved area. The caller must fill it
+	 *           in before the arena grows again.
+	 */
+	byte_type* allocate(size_type bytes)
+	{
+		if (used + bytes > allocated)
+			{
+				grow(used + bytes);
+			}
+
+		auto ptr = data.get() + used;
+		used += bytes;
+
+		return ptr;
+	}
+
+	/**
+	 * Copies 'bytes' bytes from 'src' to the end of the arena.
+	 *
+	 * @returns: The offset the data was written to.
+	 */
+	offset_type append(const void* src, size_type bytes)
+	{
+		offset_type offset = used;
+		std::memcpy(allocate(bytes), src, bytes);
+
+		return offset;
+	}
+
+	/**
+	 * Provides a pointer to the byte at the given offset.
+	 */
+	byte_type* at(offset_type offset)
+	{
+		return data.get() + offset;
+	}
+
+	/**
+	 * Provides a pointer to the byte at the given offset.
+	 */
+	const byte_type* at(offset_type offset) const
+	{
+		return data.get() + offset;
+	}
+
+	/**
+	 * Discards the contents of the arena and releases its memory.
+	 */
+	void clear()
+	{
+		data.reset();
+		used = 0;
+		allocated = 0;
+	}
+};
+
+} // end namespace cell
+} // end namespace lattice
+
+#endif //__LATTICE_CELL_BYTE_ARENA_H__
@@ -51,6 +51,11 @@ struct column {
    // The default value of the column, if one is not
    // provided.
    std::string default_value;
+
+   // If true, the values of a varchar column are stored as codes
+   // into a per-page dictionary of distinct values. This saves a lot
+   // of memory for columns with few distinct values.
+   bool dictionary_encoded;
 };
 
 typedef std::unique_ptr<column> column_handle_type;
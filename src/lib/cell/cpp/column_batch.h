@@ -0,0 +1,231 @@
+#ifndef __LATTICE_CELL_COLUMN_BATCH_H__
+#define __LATTICE_CELL_COLUMN_BATCH_H__
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <cell/cpp/column.h>
+
+namespace lattice {
+namespace cell {
+
+/**
+ * A batch of rows stored column by column, so a fetch can copy values
+ * straight out of the pages and a reader can pick out row i of a column
+ * without parsing the rows before it.
+ *
+ * Fixed width values are stored back to back, so row i starts at
+ * i * fixed_width(type). Varchar bytes are stored back to back, and row i
+ * is the bytes between offsets[i] and offsets[i + 1]. Rows without a
+ * value have their bit set in the null bitmap, and take up a zeroed slot
+ * or an empty string.
+ */
+class column_batch
+{
+public:
+   /** Varchar offsets, the same width as the length of a varchar. */
+   typedef std::uint32_t offset_type;
+
+   /** The values of one column. */
+   typedef struct
+   {
+      // The column number in the table.
+      unsigned int column_number;
+
+      column::data_type type;
+
+      std::string values;
+
+      // Varchar only, one more than the number of rows.
+      std::vector<offset_type> offsets;
+
+      // Bit i % 8 of byte i / 8 is set if row i has no value. Bytes past
+      // the end have no bits set.
+      std::string nulls;
+   } column_type;
+
+   typedef std::vector<column_type> column_list_type;
+
+private:
+   column_list_type columns;
+
+   /** The number of complete rows. */
+   std::uint32_t rows;
+
+public:
+   column_batch() :
+         rows(0)
+   {
+   }
+
+   /**
+    * The width of the values of a fixed width type, or 0 for a type that
+    * is stored with its length.
+    */
+   static std::size_t fixed_width(column::data_type type)
+   {
+      switch (type)
+         {
+         case column::data_type::smallint:
+            return sizeof(std::int16_t);
+         case column::data_type::integer:
+            return sizeof(std::int32_t);
+         case column::data_type::bigint:
+            return sizeof(std::int64_t);
+         case column::data_type::real:
+            return sizeof(float);
+         case column::data_type::double_precision:
+            return sizeof(double);
+         default:
+            return 0;
+         }
+   }
+
+   /**
+    * Adds a column. Columns are filled in the order they were added.
+    *
+    * @param column_number: The column number in the table.
+    * @param type: The type of the column.
+    */
+   column_type& add_column(unsigned int column_number, column::data_type type)
+   {
+      columns.push_back(column_type
+         {
+         column_number, type, std::string(),
+               std::vector<offset_type>(fixed_width(type) ? 0 : 1, 0),
+               std::string()
+         });
+
+      return columns.back();
+   }
+
+   /**
+    * Appends a value to a column of the row being built.
+    *
+    * @param k: The position of the column in the batch.
+    * @param data: The value, in the binary form the pages store.
+    */
+   void append_value(std::size_t k, const std::uint8_t* data)
+   {
+      auto& c = columns[k];
+      auto width = fixed_width(c.type);
+
+      if (width != 0)
+         {
+            c.values.append(static_cast<const char*>(
+                  static_cast<const void*>(data)), width);
+            return;
+         }
+
+      offset_type size;
+      std::memcpy(&size, data, sizeof(size));
+
+      c.values.append(static_cast<const char*>(
+            static_cast<const void*>(data + sizeof(size))), size);
+      c.offsets.push_back(c.values.size());
+   }
+
+   /**
+    * Marks a column of the row being built as having no value.
+    *
+    * @param k: The position of the column in the batch.
+    */
+   void append_null(std::size_t k)
+   {
+      auto& c = columns[k];
+      auto width = fixed_width(c.type);
+
+      if (width != 0)
+         {
+            c.values.append(width, '\0');
+         }
+      else
+         {
+            c.offsets.push_back(c.values.size());
+         }
+
+      auto byte = rows / 8;
+      if (c.nulls.size() <= byte)
+         {
+            c.nulls.resize(byte + 1, '\0');
+         }
+
+      c.nulls[byte] |= 1 << (rows % 8);
+   }
+
+   /**
+    * Completes the row being built. Every column must have had a value
+    * or a null appended.
+    */
+   void end_row()
+   {
+      ++rows;
+   }
+
+   /**
+    * Drops whatever was appended to the row being built, so the batch
+    * holds only complete rows again.
+    */
+   void discard_row()
+   {
+      for (auto& c : columns)
+         {
+            auto width = fixed_width(c.type);
+            if (width != 0)
+               {
+                  c.values.resize(rows * width);
+               }
+            else
+               {
+                  c.offsets.resize(rows + 1);
+                  c.values.resize(c.offsets.back());
+               }
+
+            auto byte = rows / 8;
+            if (byte < c.nulls.size())
+               {
+                  c.nulls[byte] &= ~(1 << (rows % 8));
+               }
+         }
+   }
+
+   /**
+    * Sets the number of rows of a batch whose columns were filled in
+    * directly, a column at a time.
+    */
+   void set_row_count(std::uint32_t _rows)
+   {
+      rows = _rows;
+   }
+
+   /**
+    * Indicates whether a row of a column has no value.
+    */
+   static bool is_null(const column_type& c, std::uint32_t row)
+   {
+      auto byte = row / 8;
+      return byte < c.nulls.size() && (c.nulls[byte] & (1 << (row % 8)));
+   }
+
+   std::uint32_t get_row_count() const
+   {
+      return rows;
+   }
+
+   column_list_type& get_columns()
+   {
+      return columns;
+   }
+
+   const column_list_type& get_columns() const
+   {
+      return columns;
+   }
+};
+
+} // namespace cell
+} // namespace lattice
+
+#endif // __LATTICE_CELL_COLUMN_BATCH_H__
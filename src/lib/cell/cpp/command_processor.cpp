@@ -3,20 +3,120 @@
 
 #include <cell/cpp/command_processor.h>
 #include <cell/cpp/data_value.h>
+#include <cell/cpp/list_predicate.h>
+#include <cell/cpp/scalar_predicate.h>
 
 namespace lattice {
 namespace cell {
 
 page::object_id_type command_processor::create_transaction(
-      isolation_level level)
+      isolation_level level, bool read_only)
 {
+   // Decide before this transaction is counted among the others.
+   auto safe = read_only && !has_serializable_writers();
+
    auto txn_id = ++next_transaction_id;
-   auto results = transactions.insert(std::make_pair(txn_id, transaction()));
+   auto results = transactions.insert(
+         std::make_pair(txn_id,
+               transaction(transaction_id::from_uint64(txn_id), clock.now())));
+
+   auto& txn = results.first->second;
+   txn.set_isolation_level(level);
+   if (read_only)
+      {
+         txn.set_read_only(safe);
+      }
 
-   results.first->second.set_isolation_level(level);
    return txn_id;
 }
 
+static bool is_serializable_writer(const transaction& txn)
+{
+   return txn.get_isolation_level() == isolation_level::SERIALIZABLE
+         && !txn.is_read_only();
+}
+
+bool command_processor::has_serializable_writers() const
+{
+   for (auto& txn : transactions)
+      {
+         if (is_serializable_writer(txn.second))
+            {
+               return true;
+            }
+      }
+
+   // Queued commits have not been given a commit time yet, so they are
+   // still concurrent with any snapshot taken now.
+   for (auto& txn : pending_commits)
+      {
+         if (is_serializable_writer(txn))
+            {
+               return true;
+            }
+      }
+
+   return false;
+}
+
+bool command_processor::commit_transaction(page::object_id_type txn_id)
+{
+   if (!queue_commit(txn_id))
+      {
+         return false;
+      }
+
+   commit_group();
+   return true;
+}
+
+bool command_processor::queue_commit(page::object_id_type txn_id)
+{
+   auto pos = transactions.find(txn_id);
+   if (pos == transactions.end())
+      {
+         return false;
+      }
+
+   pending_commits.push_back(std::move(pos->second));
+   transactions.erase(pos);
+
+   return true;
+}
+
+std::size_t command_processor::commit_group()
+{
+   if (pending_commits.empty())
+      {
+         return 0;
+      }
+
+   // Everyone in the group commits at the same time, so the clock only
+   // moves once.
+   auto ts = clock.tick();
+   for (auto& txn : pending_commits)
+      {
+         txn.commit(ts);
+      }
+
+   auto committed = pending_commits.size();
+   pending_commits.clear();
+
+   return committed;
+}
+
+commit_timestamp_type command_processor::get_low_watermark() const
+{
+   if (transactions.empty())
+      {
+         return clock.now();
+      }
+
+   // Snapshots are taken in transaction id order, so the first has the
+   // earliest.
+   return transactions.begin()->second.get_snapshot();
+}
+
 page::object_id_type command_processor::create_cursor(
       page::object_id_type txn_id, page::object_id_type table_id)
 {
@@ -31,6 +131,10 @@ page::object_id_type command_processor::create_cursor(
 
    // Get the table
    auto t = db.get_table(table_id);
+   if (!t)
+      {
+         return 0;
+      }
 
    // Create a cursor on the table.
    return txn.create_cursor(t);
@@ -48,19 +152,17 @@ std::string command_processor::fetch_columns(page::object_id_type txn_id,
    // Get transaction
    auto& txn = pos->second;
 
+   if (!txn.has_cursor(cursor_id))
+      {
+         return std::string();
+      }
+
    // Get cursor
    auto& cursor = txn.get_cursor(cursor_id);
 
    std::string data;
-   std::vector<bool> present;
-
-   present.assign(cursor.t->get_number_of_columns(), false);
-   for (auto index : column_indexes)
-      {
-         present[index] = true;
-      }
-
-   txn.fetch_columns(cursor, data, present);
+   txn.fetch_columns(cursor, data,
+         to_present(column_indexes, cursor.t->get_number_of_columns()));
    return data;
 }
 
@@ -76,16 +178,350 @@ bool command_processor::insert_columns(page::object_id_type txn_id,
 
    auto& txn = pos->second;           // Get transaction
    auto t = db.get_table(table_id);   // Get table
+   if (!t)
+      {
+         return false;
+      }
+
+   return txn.insert_columns(t, data,
+         to_present(column_indexes, t->get_number_of_columns()));
+}
+
+bool command_processor::insert_rows(page::object_id_type txn_id,
+      page::object_id_type table_id, const column_batch& batch)
+{
+   auto pos = transactions.find(txn_id);
+   if (pos == transactions.end())
+      {
+         return false;
+      }
+
+   auto t = db.get_table(table_id);
+   if (!t)
+      {
+         return false;
+      }
 
-   std::vector<bool> present;
+   return pos->second.insert_rows(t, batch);
+}
+
+std::vector<bool> command_processor::to_present(
+      const std::vector<int>& column_indexes, std::size_t number_of_columns)
+{
+   std::vector<bool> present(number_of_columns, false);
 
-   present.assign(t->get_number_of_columns(), false);
    for (auto index : column_indexes)
       {
-         present[index] = true;
+         if (index >= 0 && index < number_of_columns)
+            {
+               present[index] = true;
+            }
+      }
+
+   return present;
+}
+
+std::vector<bool> command_processor::to_present(std::uint64_t column_mask,
+      std::size_t number_of_columns)
+{
+   std::vector<bool> present(number_of_columns, false);
+
+   for (std::size_t i = 0; i < number_of_columns && i < 64; ++i)
+      {
+         present[i] = (column_mask >> i) & 1;
+      }
+
+   return present;
+}
+
+bool command_processor::to_row_filter(const Predicate& msg, table& t,
+      row_filter& filter)
+{
+   if (msg.kind() == Predicate::AND || msg.kind() == Predicate::OR)
+      {
+         row_filter::children_type children(msg.children_size());
+         for (auto i = 0; i < msg.children_size(); ++i)
+            {
+               if (!to_row_filter(msg.children(i), t, children[i]))
+                  {
+                     return false;
+                  }
+            }
+
+         filter = row_filter(msg.kind() == Predicate::AND ?
+               row_filter::kind::AND : row_filter::kind::OR,
+               std::move(children));
+         return true;
+      }
+
+   auto* c = t.get_column_definition(msg.column());
+   if (c == nullptr)
+      {
+         return false;
+      }
+
+   if (msg.kind() == Predicate::IN_LIST)
+      {
+         auto pred = std::make_shared<list_predicate>();
+         for (auto& value : msg.values())
+            {
+               pred->add_value(c->type, value);
+            }
+
+         filter = row_filter(msg.column(), pred);
+         return true;
+      }
+
+   auto pred = std::make_shared<scalar_predicate>();
+   if (msg.comparison() == Predicate::BETWEEN)
+      {
+         if (msg.values_size() != 2)
+            {
+               return false;
+            }
+
+         pred->set_range(c->type, msg.values(0), msg.values(1));
+      }
+   else
+      {
+         if (msg.values_size() != 1)
+            {
+               return false;
+            }
+
+         pred->set_value(c->type, msg.values(0));
+
+         switch (msg.comparison())
+            {
+            default:
+               pred->set_comparison(scalar_predicate::comparison::EQUAL);
+            break;
+
+            case Predicate::NOT_EQUAL:
+               pred->set_comparison(scalar_predicate::comparison::NOT_EQUAL);
+            break;
+
+            case Predicate::LESS:
+               pred->set_comparison(scalar_predicate::comparison::LESS);
+            break;
+
+            case Predicate::LESS_EQUAL:
+               pred->set_comparison(scalar_predicate::comparison::LESS_EQUAL);
+            break;
+
+            case Predicate::GREATER:
+               pred->set_comparison(scalar_predicate::comparison::GREATER);
+            break;
+
+            case Predicate::GREATER_EQUAL:
+               pred->set_comparison(
+                     scalar_predicate::comparison::GREATER_EQUAL);
+            break;
+            }
+      }
+
+   filter = row_filter(msg.column(), pred);
+   return true;
+}
+
+void command_processor::to_message(column_batch& batch, ColumnBatch& msg)
+{
+   msg.set_row_count(batch.get_row_count());
+
+   // The buffers are handed over rather than copied.
+   for (auto& c : batch.get_columns())
+      {
+         auto* col = msg.add_columns();
+
+         col->set_column(c.column_number);
+         col->mutable_values()->swap(c.values);
+
+         col->mutable_offsets()->Reserve(c.offsets.size());
+         for (auto offset : c.offsets)
+            {
+               col->add_offsets(offset);
+            }
+
+         if (!c.nulls.empty())
+            {
+               col->mutable_nulls()->swap(c.nulls);
+            }
+      }
+}
+
+bool command_processor::to_column_batch(const ColumnBatch& msg, table& t,
+      column_batch& batch)
+{
+   for (auto& col : msg.columns())
+      {
+         auto* definition = t.get_column_definition(col.column());
+         if (definition == nullptr)
+            {
+               return false;
+            }
+
+         auto& c = batch.add_column(col.column(), definition->type);
+         c.values = col.values();
+         c.offsets.assign(col.offsets().begin(), col.offsets().end());
+         c.nulls = col.nulls();
+      }
+
+   batch.set_row_count(msg.row_count());
+   return true;
+}
+
+aggregate command_processor::to_aggregate(
+      const CommandRequest::Aggregate& msg)
+{
+   aggregate::term_list_type terms;
+   for (auto& term : msg.terms())
+      {
+         aggregate::function f;
+         switch (term.function())
+            {
+            default:
+               f = aggregate::function::COUNT;
+            break;
+
+            case CommandRequest::Aggregate::SUM:
+               f = aggregate::function::SUM;
+            break;
+
+            case CommandRequest::Aggregate::MIN:
+               f = aggregate::function::MIN;
+            break;
+
+            case CommandRequest::Aggregate::MAX:
+               f = aggregate::function::MAX;
+            break;
+
+            case CommandRequest::Aggregate::AVG:
+               f = aggregate::function::AVG;
+            break;
+            }
+
+         terms.push_back(aggregate::term_type
+            {
+            f, term.has_column() ? term.column() : aggregate::k_all_rows
+            });
       }
 
-   txn.insert_columns(t, data, present);
+   return aggregate(terms, std::vector<unsigned int>(msg.group_by().begin(),
+         msg.group_by().end()));
+}
+
+void command_processor::to_message(aggregate& agg,
+      CommandResponse::Aggregate& msg)
+{
+   typedef aggregate::partial::value_kind value_kind;
+
+   for (auto& g : agg.get_groups())
+      {
+         auto* group = msg.add_groups();
+
+         for (auto& key : g.first)
+            {
+               group->add_key(key);
+            }
+
+         for (auto& p : g.second)
+            {
+               auto* partial = group->add_partials();
+
+               partial->set_count(p.get_count());
+               switch (p.get_kind())
+                  {
+                  case value_kind::INTEGER:
+                     partial->set_int_value(p.get_int_value());
+                  break;
+
+                  case value_kind::REAL:
+                     partial->set_real_value(p.get_real_value());
+                  break;
+
+                  case value_kind::TEXT:
+                     partial->set_text_value(p.get_text_value());
+                  break;
+
+                  default:
+                  break;
+                  }
+            }
+      }
+}
+
+void command_processor::merge_message(const CommandResponse::Aggregate& msg,
+      aggregate& agg)
+{
+   typedef aggregate::partial::value_kind value_kind;
+
+   for (auto& group : msg.groups())
+      {
+         aggregate::group_key_type key(group.key().begin(), group.key().end());
+         aggregate::partial_list_type partials(group.partials_size());
+
+         for (auto i = 0; i < group.partials_size(); ++i)
+            {
+               auto& p = group.partials(i);
+
+               auto kind = value_kind::NONE;
+               if (p.has_int_value())
+                  {
+                     kind = value_kind::INTEGER;
+                  }
+               else if (p.has_real_value())
+                  {
+                     kind = value_kind::REAL;
+                  }
+               else if (p.has_text_value())
+                  {
+                     kind = value_kind::TEXT;
+                  }
+
+               partials[i].set(p.count(), kind, p.int_value(), p.real_value(),
+                     p.text_value());
+            }
+
+         agg.merge(key, partials);
+      }
+}
+
+bool command_processor::is_valid(const CommandRequest::Aggregate& msg,
+      table& t)
+{
+   for (auto& term : msg.terms())
+      {
+         if (!term.has_column())
+            {
+               // Only rows can be counted without a column.
+               if (term.function() != CommandRequest::Aggregate::COUNT)
+                  {
+                     return false;
+                  }
+               continue;
+            }
+
+         auto* c = t.get_column_definition(term.column());
+         if (c == nullptr)
+            {
+               return false;
+            }
+
+         if ((term.function() == CommandRequest::Aggregate::SUM
+               || term.function() == CommandRequest::Aggregate::AVG)
+               && column_batch::fixed_width(c->type) == 0)
+            {
+               return false;
+            }
+      }
+
+   for (auto column_number : msg.group_by())
+      {
+         if (t.get_column_definition(column_number) == nullptr)
+            {
+               return false;
+            }
+      }
 
    return true;
 }
@@ -105,26 +541,45 @@ CommandResponse command_processor::insert(const CommandRequest& request,
    auto txn_id = msg.transaction_id();
    auto tbl_id = msg.table_id();
 
-   auto column_mask = msg.column_mask();
-   std::vector<int> column_indexes;
+   insert_response->set_transaction_id(txn_id);
+   insert_response->set_row_count(0);
+
+   auto pos = transactions.find(txn_id);
+   auto t = db.get_table(tbl_id);
+   if (pos == transactions.end() || !t)
+      {
+         return resp;
+      }
+
+   auto& txn = pos->second;
 
-   // Optimization note: check how many columns exist instead
-   // of checking all 64 bits each time.
-   for (auto b = 0; b < 64; ++b)
+   // A columnar batch goes in a column at a time.
+   if (msg.has_rows())
       {
-         column_indexes.push_back(b);
+         column_batch batch;
+         if (to_column_batch(msg.rows(), *t, batch)
+               && txn.insert_rows(t, batch))
+            {
+               insert_response->set_row_count(batch.get_row_count());
+            }
+
+         return resp;
       }
 
-   insert_response->set_transaction_id(txn_id);
+   // Every row has the same columns, so work them out once.
+   auto present = to_present(msg.column_mask(), t->get_number_of_columns());
 
    // Loop over the data packets for this insert.
+   std::uint64_t row_count = 0;
    for (auto j = 0; j < msg.data_size(); ++j)
       {
-         insert_columns(txn_id, tbl_id, column_indexes, msg.data(j));
+         if (txn.insert_columns(t, msg.data(j), present))
+            {
+               ++row_count;
+            }
       }
 
-   // In the future, actually check to see if this worked.
-   insert_response->set_row_count(msg.data_size());
+   insert_response->set_row_count(row_count);
 
    return resp;
 }
@@ -138,36 +593,141 @@ CommandResponse command_processor::fetch(const CommandRequest& request,
 
    auto& msg = request.fetch();
    auto txn_id = msg.transaction_id();
+   auto pos = transactions.find(txn_id);
 
    for (auto i = 0; i < msg.cursors_size(); ++i)
       {
          auto cursor_id = msg.cursors(i);
          auto batch_size = msg.batch_size(i);
-         auto column_mask = msg.column_mask(i);
 
-         std::vector<int> column_indexes;
+         fetch_response->add_cursors(cursor_id);
 
-         // Optimization note: check how many columns exist instead
-         // of checking all 64 bits each time.
-         for (auto b = 0; b < 64; ++b)
+         if (pos == transactions.end() || !pos->second.has_cursor(cursor_id))
             {
-               column_indexes.push_back(b);
+               fetch_response->add_batch_size(0);
+               continue;
             }
 
-         // Fetch the batch for this cursor.
-         fetch_response->add_cursors(cursor_id);
-         for (auto j = 0; j < batch_size; ++j)
+         auto& txn = pos->second;
+         auto& cursor = txn.get_cursor(cursor_id);
+
+         // Only the columns asked for are read out of the pages.
+         auto present = to_present(msg.column_mask(i),
+               cursor.t->get_number_of_columns());
+
+         // Rows that do not match the filter never leave the cell.
+         row_filter filter;
+         const row_filter* filter_ptr = nullptr;
+         if (i < msg.filter_size())
             {
-               fetch_response->add_data(
-                     fetch_columns(txn_id, cursor_id, column_indexes));
+               if (!to_row_filter(msg.filter(i), *cursor.t, filter))
+                  {
+                     fetch_response->add_batch_size(0);
+                     continue;
+                  }
+
+               filter_ptr = &filter;
             }
 
-         fetch_response->add_batch_size(batch_size);
+         // Fetch the batch for this cursor, stopping at the end of the
+         // table.
+         std::uint32_t fetched = 0;
+         if (msg.has_columnar() && msg.columnar())
+            {
+               column_batch batch;
+               cursor.t->start_batch(present, batch);
+
+               while (fetched < batch_size
+                     && txn.fetch_columns(cursor, batch, present, filter_ptr))
+                  {
+                     ++fetched;
+                  }
+
+               auto* batch_msg = fetch_response->add_batches();
+               batch_msg->set_cursor(cursor_id);
+               to_message(batch, *batch_msg);
+               fetch_response->add_batch_size(fetched);
+               continue;
+            }
+
+         for (; fetched < batch_size; ++fetched)
+            {
+               std::string data;
+               if (!txn.fetch_columns(cursor, data, present, filter_ptr))
+                  {
+                     break;
+                  }
+
+               fetch_response->add_data(data);
+            }
+
+         fetch_response->add_batch_size(fetched);
       }
 
    return resp;
 }
 
+CommandResponse command_processor::commit(const CommandRequest& request,
+      CommandResponse& resp)
+{
+   auto* commit_response = resp.mutable_commit();
+
+   resp.set_kind(CommandResponse::COMMIT);
+
+   auto txn_id = request.commit().transaction_id();
+
+   commit_response->set_transaction_id(txn_id);
+   commit_response->set_committed(queue_commit(txn_id));
+
+   return resp;
+}
+
+CommandResponse command_processor::aggregate_rows(
+      const CommandRequest& request, CommandResponse& resp)
+{
+   auto* aggregate_response = resp.mutable_aggregate();
+
+   resp.set_kind(CommandResponse::AGGREGATE);
+
+   auto& msg = request.aggregate();
+   auto txn_id = msg.transaction_id();
+   auto cursor_id = msg.cursor();
+
+   aggregate_response->set_transaction_id(txn_id);
+
+   auto pos = transactions.find(txn_id);
+   if (pos == transactions.end() || !pos->second.has_cursor(cursor_id))
+      {
+         return resp;
+      }
+
+   auto& txn = pos->second;
+   auto& cursor = txn.get_cursor(cursor_id);
+
+   if (!is_valid(msg, *cursor.t))
+      {
+         return resp;
+      }
+
+   row_filter filter;
+   const row_filter* filter_ptr = nullptr;
+   if (msg.has_filter())
+      {
+         if (!to_row_filter(msg.filter(), *cursor.t, filter))
+            {
+               return resp;
+            }
+
+         filter_ptr = &filter;
+      }
+
+   auto agg = to_aggregate(msg);
+   txn.aggregate_columns(cursor, agg, filter_ptr);
+   to_message(agg, *aggregate_response);
+
+   return resp;
+}
+
 CommandResponse command_processor::prepare(const CommandRequest& request,
       CommandResponse& resp)
 {
@@ -207,7 +767,8 @@ CommandResponse command_processor::prepare(const CommandRequest& request,
                   break;
                   }
             }
-         txn_id = create_transaction(level);
+         txn_id = create_transaction(level,
+               msg.has_read_only() && msg.read_only());
          prepare_response->set_transaction_id(txn_id);
       }
    else
@@ -226,26 +787,64 @@ CommandResponse command_processor::prepare(const CommandRequest& request,
    return resp;
 }
 
-CommandResponse command_processor::process(const CommandRequest& request)
+void command_processor::execute(const CommandRequest& request,
+      CommandResponse& resp)
 {
-   CommandResponse resp;
-
    switch (request.kind())
       {
       case CommandRequest::PREPARE:
-         return prepare(request, resp);
+         prepare(request, resp);
       break;
       case CommandRequest::FETCH:
-         return fetch(request, resp);
+         fetch(request, resp);
       break;
       case CommandRequest::INSERT:
-         return insert(request, resp);
+         insert(request, resp);
+      break;
+      case CommandRequest::COMMIT:
+         commit(request, resp);
+      break;
+      case CommandRequest::AGGREGATE:
+         aggregate_rows(request, resp);
       break;
       }
+}
+
+void command_processor::clean_up()
+{
+   db.vacuum(get_low_watermark(), k_vacuum_budget);
+   db.compact(k_compaction_budget);
+}
+
+CommandResponse command_processor::process(const CommandRequest& request)
+{
+   CommandResponse resp;
+
+   execute(request, resp);
+   commit_group();
+   clean_up();
 
    return resp;
 }
 
+std::vector<CommandResponse> command_processor::process(
+      const std::vector<CommandRequest>& requests)
+{
+   std::vector<CommandResponse> responses(requests.size());
+
+   for (std::size_t i = 0; i < requests.size(); ++i)
+      {
+         execute(requests[i], responses[i]);
+      }
+
+   // Nothing has been reported committed yet, so the whole batch can
+   // commit together.
+   commit_group();
+   clean_up();
+
+   return responses;
+}
+
 } // namespace cell
 } // namespace lattice
 
@@ -1,6 +1,10 @@
 #ifndef __LATTICE_CELL_COMMAND_PROCESSOR_H__
 #define __LATTICE_CELL_COMMAND_PROCESSOR_H__
 
+#include <cstdint>
+#include <map>
+#include <vector>
+
 #include <cell/cpp/database.h>
 #include <cell/cpp/transaction.h>
 #include <processor/proto/row.pb.h>
@@ -18,7 +22,26 @@ namespace cell {
  */
 class command_processor
 {
-   typedef std::unordered_map<page::object_id_type, transaction> txn_map_type;
+   /**
+    * Open transactions, ordered by id so that the oldest comes first.
+    */
+   typedef std::map<page::object_id_type, transaction> txn_map_type;
+
+   /**
+    * Transactions waiting to commit together.
+    */
+   typedef std::vector<transaction> commit_group_type;
+
+   /**
+    * The number of bytes compaction may copy after each request. This
+    * keeps the cost added to any one request small.
+    */
+   static const page::size_type k_compaction_budget = 64 * 1024;
+
+   /**
+    * The number of rows vacuum may look at after each request.
+    */
+   static const std::size_t k_vacuum_budget = 1024;
 
 private:
    /** The one and only database object in the command processor. There
@@ -35,13 +58,47 @@ private:
     */
    page::object_id_type next_transaction_id;
 
+   /**
+    * Orders commits. Transactions take their snapshot from it when they
+    * begin and stamp their rows with it when they commit.
+    */
+   commit_clock clock;
+
+   /**
+    * Transactions that asked to commit since the last group was
+    * committed.
+    */
+   commit_group_type pending_commits;
+
 private:
    CommandResponse prepare(const CommandRequest& req, CommandResponse& resp);
    CommandResponse fetch(const CommandRequest& req, CommandResponse& resp);
    CommandResponse insert(const CommandRequest& req, CommandResponse& resp);
+   CommandResponse commit(const CommandRequest& req, CommandResponse& resp);
+   CommandResponse aggregate_rows(const CommandRequest& req,
+         CommandResponse& resp);
+
+   /**
+    * Checks that an aggregate request only names columns the table has,
+    * and only sums or averages numbers.
+    */
+   static bool is_valid(const CommandRequest::Aggregate& msg, table& t);
+
+   /**
+    * Carries out a request, without committing the group or cleaning up
+    * afterwards.
+    */
+   void execute(const CommandRequest& req, CommandResponse& resp);
+
+   /**
+    * Removes row versions nobody can see, then reclaims some of the space
+    * left behind by deleted objects. Runs between requests.
+    */
+   void clean_up();
 
 public:
-   command_processor()
+   command_processor() :
+         next_transaction_id(0)
    {
    }
    ;
@@ -70,11 +127,56 @@ public:
    /**
     * Creates a new transaction.
     *
+    * @param level: The isolation level of the transaction.
+    * @param read_only: If true, the transaction may not write. A read only
+    *                   SERIALIZABLE transaction that starts while no
+    *                   read-write SERIALIZABLE transaction is open has a
+    *                   safe snapshot, and its reads are not tracked.
+    *
     * @returns: A new transaction id. This transaction id is local to the
     * cell, and needs to be used when corresponding with this cell.
     */
    page::object_id_type create_transaction(isolation_level level =
-         isolation_level::READ_COMMITTED);
+         isolation_level::READ_COMMITTED, bool read_only = false);
+
+   /**
+    * Indicates whether a read-write SERIALIZABLE transaction is open, or
+    * waiting in the pending group to commit.
+    */
+   bool has_serializable_writers() const;
+
+   /**
+    * Commits a transaction and forgets it.
+    *
+    * @param txn_id: The id of the transaction to commit.
+    *
+    * @returns: true if it worked, false if there is no such transaction.
+    */
+   bool commit_transaction(page::object_id_type txn_id);
+
+   /**
+    * Adds a transaction to the group that commits next, and forgets it.
+    * Its changes become visible when commit_group() is called.
+    *
+    * @param txn_id: The id of the transaction to commit.
+    *
+    * @returns: true if it worked, false if there is no such transaction.
+    */
+   bool queue_commit(page::object_id_type txn_id);
+
+   /**
+    * Commits every queued transaction with a single commit timestamp.
+    *
+    * @returns: The number of transactions committed.
+    */
+   std::size_t commit_group();
+
+   /**
+    * Provides the time the oldest transaction still running began. Row
+    * versions deleted at or before it can no longer be seen by anyone.
+    * If nothing is running, this is the time of the last commit.
+    */
+   commit_timestamp_type get_low_watermark() const;
 
    /**
     * Creates a new cursor.
@@ -99,6 +201,79 @@ public:
    std::string fetch_columns(page::object_id_type txn_id,
          page::object_id_type cursor_id, std::vector<int> column_indexes);
 
+   /**
+    * Turns a list of column indexes into a present vector. Indexes past
+    * the last column are ignored.
+    *
+    * @param column_indexes: The columns that are present.
+    * @param number_of_columns: The number of columns in the table.
+    */
+   static std::vector<bool> to_present(const std::vector<int>& column_indexes,
+         std::size_t number_of_columns);
+
+   /**
+    * Turns a column mask from a request into a present vector. Bit i
+    * selects column i, and bits past the last column are ignored.
+    *
+    * @param column_mask: The column mask.
+    * @param number_of_columns: The number of columns in the table.
+    */
+   static std::vector<bool> to_present(std::uint64_t column_mask,
+         std::size_t number_of_columns);
+
+   /**
+    * Builds a row filter from a predicate in a request.
+    *
+    * @param msg: The predicate.
+    * @param t: The table the filter is for, which gives the types the
+    *           values are read as.
+    * @param filter: Receives the filter.
+    *
+    * @returns: false if the predicate names a column the table does not
+    * have, or has the wrong number of values.
+    */
+   static bool to_row_filter(const Predicate& msg, table& t,
+         row_filter& filter);
+
+   /**
+    * Moves a column batch into a response message. The cursor is left
+    * for the caller to set.
+    *
+    * @param batch: The batch. Its buffers are taken.
+    * @param msg: Receives the rows.
+    */
+   static void to_message(column_batch& batch, ColumnBatch& msg);
+
+   /**
+    * Copies the rows of a message into a column batch, to be inserted.
+    *
+    * @param msg: The rows.
+    * @param t: The table they are for, which gives the column types.
+    * @param batch: Receives the rows.
+    *
+    * @returns: false if the message names a column the table does not
+    * have.
+    */
+   static bool to_column_batch(const ColumnBatch& msg, table& t,
+         column_batch& batch);
+
+   /**
+    * Builds an aggregate for the terms and grouping of a request.
+    */
+   static aggregate to_aggregate(const CommandRequest::Aggregate& msg);
+
+   /**
+    * Writes the partial results of an aggregate into a response message.
+    */
+   static void to_message(aggregate& agg, CommandResponse::Aggregate& msg);
+
+   /**
+    * Merges partial results from a response message into an aggregate of
+    * the same terms.
+    */
+   static void merge_message(const CommandResponse::Aggregate& msg,
+         aggregate& agg);
+
    /**
     * Inserts a list of columns.
     *
@@ -107,11 +282,25 @@ public:
     * @param column_indexes: The list of column indexes to return. They will
     *                        be returned in the order specified.
     * @param data: The actual data to insert.
+    *
+    * @returns: true if the row was inserted, false otherwise.
     */
    bool insert_columns(page::object_id_type txn_id,
          page::object_id_type table_id, std::vector<int> column_indexes,
          const std::string& data);
 
+   /**
+    * Inserts a batch of rows, a column at a time.
+    *
+    * @param txn_id: The transaction id being used.
+    * @param table_id: The table to insert the rows into.
+    * @param batch: The rows.
+    *
+    * @returns: true if the rows were inserted, false otherwise.
+    */
+   bool insert_rows(page::object_id_type txn_id,
+         page::object_id_type table_id, const column_batch& batch);
+
    /**
     * Process the command request and provide an equivalent
     * command response.
@@ -122,6 +311,18 @@ public:
     **/
    CommandResponse process(const CommandRequest& request);
 
+   /**
+    * Process a batch of command requests. Commits requested in the batch
+    * are made as one group once every request has been carried out, and
+    * the responses are only provided after that.
+    *
+    * @param requests: The command requests to process, in order.
+    *
+    * @returns: A command response for each request.
+    **/
+   std::vector<CommandResponse> process(
+         const std::vector<CommandRequest>& requests);
+
 };
 
 } // namespace cell
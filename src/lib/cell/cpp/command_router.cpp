@@ -0,0 +1,642 @@
+#include <functional>
+
+#include <cell/cpp/command_router.h>
+
+namespace lattice {
+namespace cell {
+
+command_router::command_router(size_type number_of_cells) :
+      last_transaction_id(0), next_batch_cell(0)
+{
+   if (number_of_cells == 0)
+      {
+         number_of_cells = 1;
+      }
+
+   for (size_type i = 0; i < number_of_cells; ++i)
+      {
+         cells.emplace_back(new cell_type());
+         cells.back()->thread = std::thread(&command_router::run,
+               cells.back().get());
+      }
+}
+
+command_router::~command_router()
+{
+   for (auto& c : cells)
+      {
+            {
+               std::lock_guard<std::mutex> lock(c->lock);
+               c->stopping = true;
+            }
+
+         c->ready.notify_one();
+         c->thread.join();
+      }
+}
+
+void command_router::run(cell_type* c)
+{
+   for (;;)
+      {
+         std::function<void()> work;
+            {
+               std::unique_lock<std::mutex> lock(c->lock);
+               c->ready.wait(lock, [c]()
+                  {
+                     return c->stopping || !c->work.empty();
+                  });
+
+               // Work sent before the stop is still done.
+               if (c->work.empty())
+                  {
+                     return;
+                  }
+
+               work = std::move(c->work.front());
+               c->work.pop_front();
+            }
+
+         work();
+      }
+}
+
+command_router::size_type command_router::partition(
+      const std::string& data) const
+{
+   return std::hash<std::string>()(data) % cells.size();
+}
+
+bool command_router::create_table(const std::string& name,
+      std::vector<column*> columns)
+{
+   bool created = true;
+
+   for (size_type i = 0; i < cells.size(); ++i)
+      {
+         // The first cell takes the definitions it was given, the others
+         // get copies.
+         std::vector<column*> definitions;
+         for (auto* col : columns)
+            {
+               definitions.push_back(i == 0 ? col : new column(*col));
+            }
+
+         with_cell(i, [&](command_processor& cp)
+            {
+               created = cp.create_table(name, definitions) && created;
+            });
+      }
+
+   return created;
+}
+
+page::object_id_type command_router::get_table_id(const std::string& name)
+{
+   page::object_id_type table_id = 0;
+
+   with_cell(0, [&](command_processor& cp)
+      {
+         table_id = cp.get_database().get_table_id(name);
+      });
+
+   return table_id;
+}
+
+std::future<CommandResponse> command_router::send(size_type cell_number,
+      const CommandRequest& req)
+{
+   auto* r = &req;
+
+   return post(cell_number, [r](command_processor& cp)
+      {
+         return cp.process(*r);
+      });
+}
+
+std::vector<page::object_id_type> command_router::get_cell_ids(
+      page::object_id_type txn_id)
+{
+   std::lock_guard<std::mutex> lock(state_lock);
+
+   auto pos = transactions.find(txn_id);
+   if (pos == transactions.end())
+      {
+         return std::vector<page::object_id_type>();
+      }
+
+   return pos->second.ids;
+}
+
+//                                                                           //
+// ============------------ Command Processing -------------================ //
+//                                                                           //
+
+CommandResponse command_router::prepare(const CommandRequest& request,
+      CommandResponse& resp)
+{
+   auto* prepare_response = resp.mutable_prepare();
+
+   resp.set_kind(CommandResponse::PREPARE);
+
+   auto& msg = request.prepare();
+   auto create = msg.has_create_transaction() && msg.create_transaction();
+
+   // Adding cursors to a transaction needs its id in each cell.
+   std::vector<page::object_id_type> ids;
+   if (!create)
+      {
+         ids = get_cell_ids(msg.transaction_id());
+         if (ids.empty())
+            {
+               return resp;
+            }
+      }
+
+   // Every cell opens the transaction and cursors itself, all at once.
+   std::vector<CommandRequest> cell_requests(cells.size(), request);
+   std::vector<std::future<CommandResponse>> pending;
+   for (size_type i = 0; i < cells.size(); ++i)
+      {
+         if (!create)
+            {
+               cell_requests[i].mutable_prepare()->set_transaction_id(ids[i]);
+            }
+
+         pending.push_back(send(i, cell_requests[i]));
+      }
+
+   std::vector<CommandResponse> responses;
+   for (auto& p : pending)
+      {
+         responses.push_back(p.get());
+      }
+
+   std::lock_guard<std::mutex> lock(state_lock);
+
+   page::object_id_type txn_id;
+   if (create)
+      {
+         txn_id = ++last_transaction_id;
+
+         auto& txn = transactions[txn_id];
+         txn.last_cursor_id = 0;
+         for (auto& r : responses)
+            {
+               txn.ids.push_back(r.prepare().transaction_id());
+            }
+
+         prepare_response->set_transaction_id(txn_id);
+      }
+   else
+      {
+         txn_id = msg.transaction_id();
+      }
+
+   auto pos = transactions.find(txn_id);
+   if (pos == transactions.end())
+      {
+         // Committed while we were busy.
+         return resp;
+      }
+
+   auto& txn = pos->second;
+   for (auto i = 0; i < msg.cursors_size(); ++i)
+      {
+         auto cursor_id = ++txn.last_cursor_id;
+         auto& cursor = txn.cursors[cursor_id];
+
+         cursor.current = 0;
+         for (auto& r : responses)
+            {
+               cursor.ids.push_back(r.prepare().cursor_ids(i));
+            }
+
+         prepare_response->add_cursor_ids(cursor_id);
+      }
+
+   return resp;
+}
+
+CommandResponse command_router::fetch(const CommandRequest& request,
+      CommandResponse& resp)
+{
+   auto* fetch_response = resp.mutable_fetch();
+
+   resp.set_kind(CommandResponse::FETCH);
+
+   auto& msg = request.fetch();
+   auto txn_id = msg.transaction_id();
+
+   fetch_response->set_transaction_id(txn_id);
+
+   // A scan walks the cells of its cursor in turn, so only the different
+   // cursors of the request can be advanced in parallel.
+   typedef struct
+   {
+      // The cell ids of the transaction, or none if the cursor is unknown.
+      std::vector<page::object_id_type> ids;
+
+      // A copy of the cursor, so the cells can be asked without holding
+      // up everyone else.
+      cursor_type cursor;
+
+      std::uint32_t wanted;
+      std::uint32_t fetched;
+
+      // The request sent to the cell the cursor is in, and the rows
+      // gathered from the cells so far.
+      CommandRequest cell_request;
+      CommandResponse rows;
+   } scan_type;
+
+   std::vector<scan_type> scans(msg.cursors_size());
+
+      {
+         std::lock_guard<std::mutex> lock(state_lock);
+
+         auto pos = transactions.find(txn_id);
+         for (auto i = 0; i < msg.cursors_size(); ++i)
+            {
+               auto& scan = scans[i];
+               scan.wanted = msg.batch_size(i);
+               scan.fetched = 0;
+
+               if (pos != transactions.end())
+                  {
+                     auto c = pos->second.cursors.find(msg.cursors(i));
+                     if (c != pos->second.cursors.end())
+                        {
+                           scan.ids = pos->second.ids;
+                           scan.cursor = c->second;
+                        }
+                  }
+            }
+      }
+
+   // Each round asks the cell every unfinished cursor is in for the rest
+   // of its rows, and a cursor moves on when its cell runs out.
+   for (;;)
+      {
+         std::vector<std::future<CommandResponse>> pending(scans.size());
+         std::vector<std::uint32_t> asked(scans.size());
+
+         for (std::size_t i = 0; i < scans.size(); ++i)
+            {
+               auto& scan = scans[i];
+               if (scan.ids.empty() || scan.fetched >= scan.wanted
+                     || scan.cursor.current >= cells.size())
+                  {
+                     continue;
+                  }
+
+               asked[i] = scan.wanted - scan.fetched;
+
+               auto& cell_request = scan.cell_request;
+               cell_request.Clear();
+               cell_request.set_kind(CommandRequest::FETCH);
+
+               auto* cell_msg = cell_request.mutable_fetch();
+               cell_msg->set_transaction_id(scan.ids[scan.cursor.current]);
+               cell_msg->add_cursors(scan.cursor.ids[scan.cursor.current]);
+               cell_msg->add_batch_size(asked[i]);
+               cell_msg->add_column_mask(msg.column_mask(i));
+               if (int(i) < msg.filter_size())
+                  {
+                     *cell_msg->add_filter() = msg.filter(i);
+                  }
+               cell_msg->set_columnar(msg.has_columnar() && msg.columnar());
+
+               pending[i] = send(scan.cursor.current, cell_request);
+            }
+
+         auto sent = false;
+         for (std::size_t i = 0; i < scans.size(); ++i)
+            {
+               if (!pending[i].valid())
+                  {
+                     continue;
+                  }
+
+               sent = true;
+
+               auto& scan = scans[i];
+               auto cell_resp = pending[i].get();
+               auto* cell_fetch = cell_resp.mutable_fetch();
+               auto* rows = scan.rows.mutable_fetch();
+
+               std::uint32_t count = 0;
+               if (cell_fetch->batch_size_size() > 0)
+                  {
+                     count = cell_fetch->batch_size(0);
+                  }
+
+               // Each cell's rows come back as a batch of their own.
+               for (auto& batch : *cell_fetch->mutable_batches())
+                  {
+                     if (batch.row_count() > 0)
+                        {
+                           batch.set_cursor(msg.cursors(i));
+                           rows->add_batches()->Swap(&batch);
+                        }
+                  }
+
+               for (auto& data : *cell_fetch->mutable_data())
+                  {
+                     rows->add_data()->swap(data);
+                  }
+
+               scan.fetched += count;
+               if (count < asked[i])
+                  {
+                     ++scan.cursor.current;
+                  }
+            }
+
+         if (!sent)
+            {
+               break;
+            }
+      }
+
+   // The rows go back in the order the cursors were asked for.
+   for (std::size_t i = 0; i < scans.size(); ++i)
+      {
+         auto& scan = scans[i];
+         auto* rows = scan.rows.mutable_fetch();
+
+         fetch_response->add_cursors(msg.cursors(i));
+         fetch_response->add_batch_size(scan.fetched);
+
+         for (auto& batch : *rows->mutable_batches())
+            {
+               fetch_response->add_batches()->Swap(&batch);
+            }
+
+         for (auto& data : *rows->mutable_data())
+            {
+               fetch_response->add_data()->swap(data);
+            }
+      }
+
+   std::lock_guard<std::mutex> lock(state_lock);
+
+   auto pos = transactions.find(txn_id);
+   if (pos != transactions.end())
+      {
+         for (std::size_t i = 0; i < scans.size(); ++i)
+            {
+               auto c = pos->second.cursors.find(msg.cursors(i));
+               if (!scans[i].ids.empty() && c != pos->second.cursors.end())
+                  {
+                     c->second.current = scans[i].cursor.current;
+                  }
+            }
+      }
+
+   return resp;
+}
+
+CommandResponse command_router::insert(const CommandRequest& request,
+      CommandResponse& resp)
+{
+   auto* insert_response = resp.mutable_insert();
+
+   resp.set_kind(CommandResponse::INSERT);
+
+   auto& msg = request.insert();
+   auto txn_id = msg.transaction_id();
+
+   insert_response->set_transaction_id(txn_id);
+   insert_response->set_row_count(0);
+
+   auto ids = get_cell_ids(txn_id);
+   if (ids.empty())
+      {
+         return resp;
+      }
+
+   // Splitting a batch row by row would undo the point of sending it a
+   // column at a time, so it is kept whole.
+   if (msg.has_rows())
+      {
+         size_type i;
+            {
+               std::lock_guard<std::mutex> lock(state_lock);
+               i = next_batch_cell;
+               next_batch_cell = (next_batch_cell + 1) % cells.size();
+            }
+
+         CommandRequest cell_request;
+         cell_request.set_kind(CommandRequest::INSERT);
+
+         auto* cell_msg = cell_request.mutable_insert();
+         cell_msg->set_transaction_id(ids[i]);
+         cell_msg->set_table_id(msg.table_id());
+         cell_msg->set_column_mask(msg.column_mask());
+         *cell_msg->mutable_rows() = msg.rows();
+
+         insert_response->set_row_count(
+               send(i, cell_request).get().insert().row_count());
+         return resp;
+      }
+
+   // Sort the rows into one insert per cell.
+   std::vector<CommandRequest> cell_requests(cells.size());
+   for (size_type i = 0; i < cells.size(); ++i)
+      {
+         cell_requests[i].set_kind(CommandRequest::INSERT);
+
+         auto* cell_msg = cell_requests[i].mutable_insert();
+         cell_msg->set_transaction_id(ids[i]);
+         cell_msg->set_table_id(msg.table_id());
+         cell_msg->set_column_mask(msg.column_mask());
+      }
+
+   for (auto& data : msg.data())
+      {
+         cell_requests[partition(data)].mutable_insert()->add_data(data);
+      }
+
+   // The cells insert their rows at the same time.
+   std::vector<std::future<CommandResponse>> pending(cells.size());
+   for (size_type i = 0; i < cells.size(); ++i)
+      {
+         if (cell_requests[i].insert().data_size() > 0)
+            {
+               pending[i] = send(i, cell_requests[i]);
+            }
+      }
+
+   std::uint64_t row_count = 0;
+   for (auto& p : pending)
+      {
+         if (p.valid())
+            {
+               row_count += p.get().insert().row_count();
+            }
+      }
+
+   insert_response->set_row_count(row_count);
+
+   return resp;
+}
+
+CommandResponse command_router::commit(const CommandRequest& request,
+      CommandResponse& resp)
+{
+   auto* commit_response = resp.mutable_commit();
+
+   resp.set_kind(CommandResponse::COMMIT);
+
+   auto txn_id = request.commit().transaction_id();
+   commit_response->set_transaction_id(txn_id);
+
+   std::vector<page::object_id_type> ids;
+      {
+         std::lock_guard<std::mutex> lock(state_lock);
+
+         auto pos = transactions.find(txn_id);
+         if (pos != transactions.end())
+            {
+               ids = pos->second.ids;
+               transactions.erase(pos);
+            }
+      }
+
+   // Each cell commits on its own. There is no two phase commit, so a
+   // failure part way leaves the cells that committed committed.
+   std::vector<CommandRequest> cell_requests(ids.size());
+   std::vector<std::future<CommandResponse>> pending;
+   for (size_type i = 0; i < ids.size(); ++i)
+      {
+         cell_requests[i].set_kind(CommandRequest::COMMIT);
+         cell_requests[i].mutable_commit()->set_transaction_id(ids[i]);
+
+         pending.push_back(send(i, cell_requests[i]));
+      }
+
+   auto committed = !ids.empty();
+   for (auto& p : pending)
+      {
+         committed = p.get().commit().committed() && committed;
+      }
+
+   commit_response->set_committed(committed);
+
+   return resp;
+}
+
+CommandResponse command_router::aggregate_rows(const CommandRequest& request,
+      CommandResponse& resp)
+{
+   auto* aggregate_response = resp.mutable_aggregate();
+
+   resp.set_kind(CommandResponse::AGGREGATE);
+
+   auto& msg = request.aggregate();
+   auto txn_id = msg.transaction_id();
+   auto cursor_id = msg.cursor();
+
+   aggregate_response->set_transaction_id(txn_id);
+
+   std::vector<page::object_id_type> ids;
+   cursor_type cursor;
+      {
+         std::lock_guard<std::mutex> lock(state_lock);
+
+         auto pos = transactions.find(txn_id);
+         if (pos != transactions.end())
+            {
+               auto c = pos->second.cursors.find(cursor_id);
+               if (c != pos->second.cursors.end())
+                  {
+                     ids = pos->second.ids;
+                     cursor = c->second;
+                  }
+            }
+      }
+
+   if (ids.empty())
+      {
+         return resp;
+      }
+
+   // The cells before the one the cursor is in have no rows left. The
+   // rest compute their partial results at the same time.
+   std::vector<CommandRequest> cell_requests(cells.size(), request);
+   std::vector<std::future<CommandResponse>> pending;
+   for (auto i = cursor.current; i < cells.size(); ++i)
+      {
+         auto* cell_msg = cell_requests[i].mutable_aggregate();
+         cell_msg->set_transaction_id(ids[i]);
+         cell_msg->set_cursor(cursor.ids[i]);
+
+         pending.push_back(send(i, cell_requests[i]));
+      }
+
+   std::vector<CommandResponse> responses;
+   for (auto& p : pending)
+      {
+         responses.push_back(p.get());
+      }
+
+   auto agg = command_processor::to_aggregate(msg);
+   for (auto& cell_resp : responses)
+      {
+         // Without grouping, a cell only returns no groups if the request
+         // was not valid.
+         if (msg.group_by_size() == 0
+               && cell_resp.aggregate().groups_size() == 0)
+            {
+               return resp;
+            }
+
+         command_processor::merge_message(cell_resp.aggregate(), agg);
+      }
+
+   command_processor::to_message(agg, *aggregate_response);
+
+   std::lock_guard<std::mutex> lock(state_lock);
+
+   auto pos = transactions.find(txn_id);
+   if (pos != transactions.end())
+      {
+         auto c = pos->second.cursors.find(cursor_id);
+         if (c != pos->second.cursors.end())
+            {
+               c->second.current = cells.size();
+            }
+      }
+
+   return resp;
+}
+
+CommandResponse command_router::process(const CommandRequest& request)
+{
+   CommandResponse resp;
+
+   switch (request.kind())
+      {
+      case CommandRequest::PREPARE:
+         prepare(request, resp);
+      break;
+      case CommandRequest::FETCH:
+         fetch(request, resp);
+      break;
+      case CommandRequest::INSERT:
+         insert(request, resp);
+      break;
+      case CommandRequest::COMMIT:
+         commit(request, resp);
+      break;
+      case CommandRequest::AGGREGATE:
+         aggregate_rows(request, resp);
+      break;
+      }
+
+   return resp;
+}
+
+} // namespace cell
+} // namespace lattice
@@ -0,0 +1,253 @@
+#ifndef __LATTICE_CELL_COMMAND_ROUTER_H__
+#define __LATTICE_CELL_COMMAND_ROUTER_H__
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <cell/cpp/command_processor.h>
+
+namespace lattice {
+namespace cell {
+
+/**
+ * Spreads the rows of every table across a number of cells, each with a
+ * command processor owning its own database shard, and routes commands
+ * to them.
+ *
+ * Cells share nothing, and each runs on a thread of its own, taking work
+ * from a queue in the order it was sent. A request is split into one
+ * request per cell, which are all sent before any response is waited for,
+ * so the cells work on them in parallel. Rows are hash partitioned on
+ * their data as they are inserted, except for columnar batches, which go
+ * whole to one cell and to each cell in turn. Transactions and cursors
+ * are opened in every cell. A scan walks the cells one after the other,
+ * but the cursors of one fetch are advanced together. Aggregates are
+ * computed by every cell and the partial results merged here.
+ *
+ * The router hands out its own transaction and cursor ids, which are
+ * mapped to the ids each cell uses.
+ */
+class command_router
+{
+public:
+   /** The type for cell numbers and counts. */
+   typedef std::size_t size_type;
+
+private:
+   /** A cell, and the thread that runs its work. */
+   typedef struct cell
+   {
+      command_processor processor;
+
+      // Work not yet run, oldest first.
+      std::deque<std::function<void()>> work;
+
+      // Guards the work queue and the stopping flag.
+      std::mutex lock;
+
+      // Signalled when work is queued or the cell is stopping.
+      std::condition_variable ready;
+
+      // Set to make the thread exit once the queue is empty.
+      bool stopping;
+
+      std::thread thread;
+
+      cell() :
+            stopping(false)
+      {
+      }
+   } cell_type;
+
+   /** A cursor open in every cell. */
+   typedef struct
+   {
+      // The cursor id in each cell.
+      std::vector<page::object_id_type> ids;
+
+      // The cell the scan has got to.
+      size_type current;
+   } cursor_type;
+
+   /** A transaction open in every cell. */
+   typedef struct
+   {
+      // The transaction id in each cell.
+      std::vector<page::object_id_type> ids;
+
+      // The cursors, by router cursor id.
+      std::unordered_map<page::object_id_type, cursor_type> cursors;
+
+      // The last router cursor id handed out.
+      page::object_id_type last_cursor_id;
+   } txn_type;
+
+   /** Open transactions, by router transaction id. */
+   typedef std::map<page::object_id_type, txn_type> txn_map_type;
+
+   /** The cells. */
+   std::vector<std::unique_ptr<cell_type>> cells;
+
+   /** Guards the transactions and ids below. */
+   std::mutex state_lock;
+
+   /** Open transactions. */
+   txn_map_type transactions;
+
+   /** The last router transaction id handed out. */
+   page::object_id_type last_transaction_id;
+
+   /** The cell the next columnar batch is inserted into. */
+   size_type next_batch_cell;
+
+   CommandResponse prepare(const CommandRequest& req, CommandResponse& resp);
+   CommandResponse fetch(const CommandRequest& req, CommandResponse& resp);
+   CommandResponse insert(const CommandRequest& req, CommandResponse& resp);
+   CommandResponse commit(const CommandRequest& req, CommandResponse& resp);
+   CommandResponse aggregate_rows(const CommandRequest& req,
+         CommandResponse& resp);
+
+   /**
+    * Runs queued work for a cell until it is stopped.
+    */
+   static void run(cell_type* c);
+
+   /**
+    * Sends a request to one cell, without waiting for it to be processed.
+    * The request must stay alive until the response has been collected.
+    */
+   std::future<CommandResponse> send(size_type cell_number,
+         const CommandRequest& req);
+
+   /**
+    * Provides the cell ids of a transaction, or an empty list if there is
+    * no such transaction.
+    */
+   std::vector<page::object_id_type> get_cell_ids(
+         page::object_id_type txn_id);
+
+public:
+   /**
+    * @param number_of_cells: The number of cells to spread rows over,
+    *                         usually one per core. At least one is made.
+    */
+   explicit command_router(size_type number_of_cells);
+
+   /**
+    * Finishes the work already sent to the cells and stops their threads.
+    */
+   ~command_router();
+
+   /**
+    * The number of cells.
+    */
+   size_type size() const
+   {
+      return cells.size();
+   }
+
+   /**
+    * Provides the cell that owns a row.
+    *
+    * @param data: The row, in binary form.
+    */
+   size_type partition(const std::string& data) const;
+
+   /**
+    * Queues a function to run against the command processor of one cell,
+    * on the cell's thread.
+    *
+    * @param cell_number: The cell.
+    * @param f: The function, called with a command_processor&. Anything
+    *           it refers to must stay alive until the result is collected.
+    *
+    * @returns: A future for the function's result.
+    */
+   template<typename Function>
+   std::future<typename std::result_of<Function(command_processor&)>::type>
+   post(size_type cell_number, Function f)
+   {
+      typedef typename std::result_of<Function(command_processor&)>::type
+            result_type;
+
+      auto& c = *cells[cell_number];
+      auto processor = &c.processor;
+
+      // std::function must be copyable, and a packaged_task is not.
+      auto task = std::make_shared<std::packaged_task<result_type()>>(
+            [processor, f]()
+               {
+                  return f(*processor);
+               });
+      auto result = task->get_future();
+
+         {
+            std::lock_guard<std::mutex> lock(c.lock);
+            c.work.push_back([task]()
+               {
+                  (*task)();
+               });
+         }
+
+      c.ready.notify_one();
+      return result;
+   }
+
+   /**
+    * Runs a function against the command processor of one cell, on the
+    * cell's thread, and waits for it to finish.
+    *
+    * @param cell_number: The cell.
+    * @param f: The function, called with a command_processor&.
+    */
+   template<typename Function>
+   void with_cell(size_type cell_number, Function f)
+   {
+      post(cell_number, [&f](command_processor& cp)
+         {
+            f(cp);
+         }).get();
+   }
+
+   /**
+    * Create a table in every cell.
+    *
+    * @param name: The name of the table.
+    * @param columns: The column definitions for the table. Each cell gets
+    *                 its own copy.
+    *
+    * @returns: true if it worked, false otherwise.
+    */
+   bool create_table(const std::string& name, std::vector<column*> columns);
+
+   /**
+    * Provides the id of a table, which is the same in every cell.
+    */
+   page::object_id_type get_table_id(const std::string& name);
+
+   /**
+    * Process the command request and provide an equivalent
+    * command response. The request may come from any thread.
+    *
+    * @param request: The command request to process.
+    *
+    * @returns: A new command response.
+    **/
+   CommandResponse process(const CommandRequest& request);
+};
+
+} // namespace cell
+} // namespace lattice
+
+#endif // __LATTICE_CELL_COMMAND_ROUTER_H__
@@ -0,0 +1,64 @@
+#ifndef __LATTICE_CELL_COMMIT_CLOCK_H__
+#define __LATTICE_CELL_COMMIT_CLOCK_H__
+
+#include <cstdint>
+#include <limits>
+
+namespace lattice {
+namespace cell {
+
+/**
+ * A point in commit order. Rows are stamped with the time they were
+ * committed and deleted, and transactions read as of the time they began.
+ */
+typedef std::uint64_t commit_timestamp_type;
+
+/**
+ * Hands out commit timestamps. Every commit gets a later timestamp than
+ * the one before it, so a transaction that began at time T sees exactly
+ * the rows committed at or before T, no matter in which order the
+ * transactions that wrote them began.
+ */
+class commit_clock
+{
+public:
+   /** The time of something that has not happened: a row that is not
+    * committed, or not deleted, yet. */
+   static const commit_timestamp_type k_never =
+         std::numeric_limits<commit_timestamp_type>::max();
+
+   /** A snapshot that sees every committed row. */
+   static const commit_timestamp_type k_latest = k_never - 1;
+
+private:
+   /** The time of the last commit. */
+   commit_timestamp_type last;
+
+public:
+   commit_clock() :
+         last(0)
+   {
+   }
+
+   /**
+    * Provides the time of the last commit. A transaction beginning now
+    * reads as of this time.
+    */
+   commit_timestamp_type now() const
+   {
+      return last;
+   }
+
+   /**
+    * Provides the timestamp for a new commit.
+    */
+   commit_timestamp_type tick()
+   {
+      return ++last;
+   }
+};
+
+} // namespace cell
+} // namespace lattice
+
+#endif // __LATTICE_CELL_COMMIT_CLOCK_H__
@@ -44,18 +44,21 @@ static int cmp(const T& value1, const T& value2)
          (value1) >  (value2) ? 1 : -1;
 }
 
+// The buffer may not be aligned for T, so it is copied out.
 template<typename T>
 static int cmp(const T& value, const std::uint8_t *buffer) {
-  return cmp(value, static_cast<const T*>(static_cast<const void*>(buffer)));
+  T value2;
+  std::memcpy(&value2, buffer, sizeof(value2));
+
+  return cmp(value, value2);
 }
 
 template<>
 int cmp<>(const std::string &value, const std::uint8_t *buffer)
 {
   std::uint32_t size1 = value.size();
-  std::uint32_t size2 = *static_cast<const std::uint32_t *>(
-      static_cast<const void*>(buffer)
-      );
+  std::uint32_t size2;
+  std::memcpy(&size2, buffer, sizeof(size2));
 
   // Find the minimum size.
   auto size = std::min(size1, size2);
@@ -0,0 +1,425 @@
+#include <cell/cpp/compare_kernels.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LATTICE_HAS_X86_KERNELS 1
+#include <emmintrin.h>
+#endif
+
+#include <cell/cpp/compare_kernels_impl.h>
+
+namespace lattice {
+namespace cell {
+
+#ifdef LATTICE_HAS_X86_KERNELS
+
+namespace {
+
+//
+// SSE2 is part of every x86-64 processor, so these are compiled for the
+// default target.
+//
+
+struct sse2_base
+{
+	static std::uint64_t present(const std::uint8_t* references)
+	{
+		auto zero = _mm_setzero_si128();
+		std::uint64_t word = 0;
+
+		for (std::size_t i = 0; i < 64; i += 16)
+			{
+				auto v = _mm_loadu_si128(
+						static_cast<const __m128i*>(static_cast<const void*>(references
+								+ i)));
+				std::uint64_t empty = _mm_movemask_epi8(_mm_cmpeq_epi8(v, zero));
+				word |= (~empty & 0xFFFF) << i;
+			}
+
+		return word;
+	}
+};
+
+struct sse2_int16: sse2_base
+{
+	typedef std::int16_t value_type;
+	typedef __m128i vector_type;
+
+	static const std::size_t k_lanes = 8;
+	static const unsigned k_all = 0xFF;
+
+	static vector_type load(const value_type* p)
+	{
+		return _mm_loadu_si128(static_cast<const __m128i*>(static_cast<const void*>(p)));
+	}
+
+	static vector_type broadcast(value_type v)
+	{
+		return _mm_set1_epi16(v);
+	}
+
+	static unsigned mask(vector_type m)
+	{
+		return _mm_movemask_epi8(_mm_packs_epi16(m, _mm_setzero_si128())) & k_all;
+	}
+
+	static unsigned equal(vector_type a, vector_type b)
+	{
+		return mask(_mm_cmpeq_epi16(a, b));
+	}
+
+	static unsigned not_equal(vector_type a, vector_type b)
+	{
+		return ~equal(a, b) & k_all;
+	}
+
+	static unsigned less(vector_type a, vector_type b)
+	{
+		return mask(_mm_cmpgt_epi16(b, a));
+	}
+
+	static unsigned less_equal(vector_type a, vector_type b)
+	{
+		return ~greater(a, b) & k_all;
+	}
+
+	static unsigned greater(vector_type a, vector_type b)
+	{
+		return mask(_mm_cmpgt_epi16(a, b));
+	}
+
+	static unsigned greater_equal(vector_type a, vector_type b)
+	{
+		return ~less(a, b) & k_all;
+	}
+};
+
+struct sse2_int32: sse2_base
+{
+	typedef std::int32_t value_type;
+	typedef __m128i vector_type;
+
+	static const std::size_t k_lanes = 4;
+	static const unsigned k_all = 0xF;
+
+	static vector_type load(const value_type* p)
+	{
+		return _mm_loadu_si128(static_cast<const __m128i*>(static_cast<const void*>(p)));
+	}
+
+	static vector_type broadcast(value_type v)
+	{
+		return _mm_set1_epi32(v);
+	}
+
+	static unsigned mask(vector_type m)
+	{
+		return _mm_movemask_ps(_mm_castsi128_ps(m));
+	}
+
+	static unsigned equal(vector_type a, vector_type b)
+	{
+		return mask(_mm_cmpeq_epi32(a, b));
+	}
+
+	static unsigned not_equal(vector_type a, vector_type b)
+	{
+		return ~equal(a, b) & k_all;
+	}
+
+	static unsigned less(vector_type a, vector_type b)
+	{
+		return mask(_mm_cmpgt_epi32(b, a));
+	}
+
+	static unsigned less_equal(vector_type a, vector_type b)
+	{
+		return ~greater(a, b) & k_all;
+	}
+
+	static unsigned greater(vector_type a, vector_type b)
+	{
+		return mask(_mm_cmpgt_epi32(a, b));
+	}
+
+	static unsigned greater_equal(vector_type a, vector_type b)
+	{
+		return ~less(a, b) & k_all;
+	}
+};
+
+struct sse2_float: sse2_base
+{
+	typedef float value_type;
+	typedef __m128 vector_type;
+
+	static const std::size_t k_lanes = 4;
+
+	static vector_type load(const value_type* p)
+	{
+		return _mm_loadu_ps(p);
+	}
+
+	static vector_type broadcast(value_type v)
+	{
+		return _mm_set1_ps(v);
+	}
+
+	static unsigned equal(vector_type a, vector_type b)
+	{
+		return _mm_movemask_ps(_mm_cmpeq_ps(a, b));
+	}
+
+	static unsigned not_equal(vector_type a, vector_type b)
+	{
+		return _mm_movemask_ps(_mm_cmpneq_ps(a, b));
+	}
+
+	static unsigned less(vector_type a, vector_type b)
+	{
+		return _mm_movemask_ps(_mm_cmplt_ps(a, b));
+	}
+
+	static unsigned less_equal(vector_type a, vector_type b)
+	{
+		return _mm_movemask_ps(_mm_cmple_ps(a, b));
+	}
+
+	static unsigned greater(vector_type a, vector_type b)
+	{
+		return _mm_movemask_ps(_mm_cmpgt_ps(a, b));
+	}
+
+	static unsigned greater_equal(vector_type a, vector_type b)
+	{
+		return _mm_movemask_ps(_mm_cmpge_ps(a, b));
+	}
+};
+
+struct sse2_double: sse2_base
+{
+	typedef double value_type;
+	typedef __m128d vector_type;
+
+	static const std::size_t k_lanes = 2;
+
+	static vector_type load(const value_type* p)
+	{
+		return _mm_loadu_pd(p);
+	}
+
+	static vector_type broadcast(value_type v)
+	{
+		return _mm_set1_pd(v);
+	}
+
+	static unsigned equal(vector_type a, vector_type b)
+	{
+		return _mm_movemask_pd(_mm_cmpeq_pd(a, b));
+	}
+
+	static unsigned not_equal(vector_type a, vector_type b)
+	{
+		return _mm_movemask_pd(_mm_cmpneq_pd(a, b));
+	}
+
+	static unsigned less(vector_type a, vector_type b)
+	{
+		return _mm_movemask_pd(_mm_cmplt_pd(a, b));
+	}
+
+	static unsigned less_equal(vector_type a, vector_type b)
+	{
+		return _mm_movemask_pd(_mm_cmple_pd(a, b));
+	}
+
+	static unsigned greater(vector_type a, vector_type b)
+	{
+		return _mm_movemask_pd(_mm_cmpgt_pd(a, b));
+	}
+
+	static unsigned greater_equal(vector_type a, vector_type b)
+	{
+		return _mm_movemask_pd(_mm_cmpge_pd(a, b));
+	}
+};
+
+} // end anonymous namespace
+
+namespace sse2 {
+
+LATTICE_COMPARE_KERNEL_ENTRY(std::int16_t)
+{
+	compare_dispatch<sse2_int16>(op, values, references, n, low, high, out);
+}
+
+LATTICE_COMPARE_KERNEL_ENTRY(std::int32_t)
+{
+	compare_dispatch<sse2_int32>(op, values, references, n, low, high, out);
+}
+
+LATTICE_COMPARE_KERNEL_ENTRY(float)
+{
+	compare_dispatch<sse2_float>(op, values, references, n, low, high, out);
+}
+
+LATTICE_COMPARE_KERNEL_ENTRY(double)
+{
+	compare_dispatch<sse2_double>(op, values, references, n, low, high, out);
+}
+
+} // end namespace sse2
+
+#endif // LATTICE_HAS_X86_KERNELS
+
+//==----------------------------------------------------------==//
+//                    Run time dispatch
+//==----------------------------------------------------------==//
+
+/**
+ * Finds the best instruction set the processor supports.
+ */
+static simd_level detect_simd_level()
+{
+#ifdef LATTICE_HAS_X86_KERNELS
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		{
+			return simd_level::AVX2;
+		}
+
+	return simd_level::SSE2;
+#else
+	return simd_level::SCALAR;
+#endif
+}
+
+/**
+ * The instruction set in use.
+ */
+static simd_level& current_simd_level()
+{
+	static simd_level level = detect_simd_level();
+	return level;
+}
+
+simd_level get_simd_level()
+{
+	return current_simd_level();
+}
+
+simd_level set_simd_level(simd_level level)
+{
+	auto best = detect_simd_level();
+	if (static_cast<int>(level) > static_cast<int>(best))
+		{
+			level = best;
+		}
+
+	current_simd_level() = level;
+	return level;
+}
+
+void compare_values(compare_op op, const std::int16_t* values,
+		const std::uint8_t* references, std::size_t n, std::int16_t low,
+		std::int16_t high, std::uint64_t* out)
+{
+	switch (current_simd_level())
+		{
+#ifdef LATTICE_HAS_X86_KERNELS
+		case simd_level::AVX2:
+			avx2::compare_values(op, values, references, n, low, high, out);
+			return;
+
+		case simd_level::SSE2:
+			sse2::compare_values(op, values, references, n, low, high, out);
+			return;
+#endif
+		default:
+			compare_dispatch<scalar_traits<std::int16_t>>(op, values, references,
+					n, low, high, out);
+		}
+}
+
+void compare_values(compare_op op, const std::int32_t* values,
+		const std::uint8_t* references, std::size_t n, std::int32_t low,
+		std::int32_t high, std::uint64_t* out)
+{
+	switch (current_simd_level())
+		{
+#ifdef LATTICE_HAS_X86_KERNELS
+		case simd_level::AVX2:
+			avx2::compare_values(op, values, references, n, low, high, out);
+			return;
+
+		case simd_level::SSE2:
+			sse2::compare_values(op, values, references, n, low, high, out);
+			return;
+#endif
+		default:
+			compare_dispatch<scalar_traits<std::int32_t>>(op, values, references,
+					n, low, high, out);
+		}
+}
+
+void compare_values(compare_op op, const std::int64_t* values,
+		const std::uint8_t* references, std::size_t n, std::int64_t low,
+		std::int64_t high, std::uint64_t* out)
+{
+	switch (current_simd_level())
+		{
+#ifdef LATTICE_HAS_X86_KERNELS
+		case simd_level::AVX2:
+			avx2::compare_values(op, values, references, n, low, high, out);
+			return;
+#endif
+		default:
+			// SSE2 has no 64 bit integer comparisons.
+			compare_dispatch<scalar_traits<std::int64_t>>(op, values, references,
+					n, low, high, out);
+		}
+}
+
+void compare_values(compare_op op, const float* values,
+		const std::uint8_t* references, std::size_t n, float low, float high,
+		std::uint64_t* out)
+{
+	switch (current_simd_level())
+		{
+#ifdef LATTICE_HAS_X86_KERNELS
+		case simd_level::AVX2:
+			avx2::compare_values(op, values, references, n, low, high, out);
+			return;
+
+		case simd_level::SSE2:
+			sse2::compare_values(op, values, references, n, low, high, out);
+			return;
+#endif
+		default:
+			compare_dispatch<scalar_traits<float>>(op, values, references, n, low,
+					high, out);
+		}
+}
+
+void compare_values(compare_op op, const double* values,
+		const std::uint8_t* references, std::size_t n, double low, double high,
+		std::uint64_t* out)
+{
+	switch (current_simd_level())
+		{
+#ifdef LATTICE_HAS_X86_KERNELS
+		case simd_level::AVX2:
+			avx2::compare_values(op, values, references, n, low, high, out);
+			return;
+
+		case simd_level::SSE2:
+			sse2::compare_values(op, values, references, n, low, high, out);
+			return;
+#endif
+		default:
+			compare_dispatch<scalar_traits<double>>(op, values, references, n, low,
+					high, out);
+		}
+}
+
+} // end namespace cell
+} // end namespace lattice
@@ -0,0 +1,85 @@
+#ifndef __LATTICE_CELL_COMPARE_KERNELS_H__
+#define __LATTICE_CELL_COMPARE_KERNELS_H__
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lattice {
+namespace cell {
+
+/**
+ * The comparisons the kernels can run. Each compares a value x with the
+ * bounds given to compare_values().
+ */
+enum class compare_op
+{
+	EQUAL,          // x == low
+	NOT_EQUAL,      // x != low
+	LESS,           // x < low
+	LESS_EQUAL,     // x <= low
+	GREATER,        // x > low
+	GREATER_EQUAL,  // x >= low
+	BETWEEN         // low <= x <= high
+};
+
+/**
+ * The instruction sets the kernels can use.
+ */
+enum class simd_level
+{
+	SCALAR, SSE2, AVX2
+};
+
+/**
+ * The instruction set compare_values() uses.
+ */
+simd_level get_simd_level();
+
+/**
+ * Changes the instruction set compare_values() uses. Levels the processor
+ * does not support are lowered to the best one it does.
+ *
+ * @returns: The level now in use.
+ */
+simd_level set_simd_level(simd_level level);
+
+/**
+ * Compares an array of values with a constant, producing a bitmask.
+ *
+ * Bit i of 'out' is set when 'references[i]' is non-zero and 'values[i]'
+ * satisfies the comparison. The best instruction set the processor
+ * supports is picked at run time.
+ *
+ * @param op: The comparison to run.
+ * @param values: The values to compare.
+ * @param references: The reference count of each value. Zero means that
+ *                    there is no object.
+ * @param n: The number of values.
+ * @param low: The constant, or the lower bound for BETWEEN.
+ * @param high: The upper bound for BETWEEN, otherwise ignored.
+ * @param out: Room for (n + 63) / 64 words, which are overwritten.
+ */
+void compare_values(compare_op op, const std::int16_t* values,
+		const std::uint8_t* references, std::size_t n, std::int16_t low,
+		std::int16_t high, std::uint64_t* out);
+
+void compare_values(compare_op op, const std::int32_t* values,
+		const std::uint8_t* references, std::size_t n, std::int32_t low,
+		std::int32_t high, std::uint64_t* out);
+
+void compare_values(compare_op op, const std::int64_t* values,
+		const std::uint8_t* references, std::size_t n, std::int64_t low,
+		std::int64_t high, std::uint64_t* out);
+
+void compare_values(compare_op op, const float* values,
+		const std::uint8_t* references, std::size_t n, float low, float high,
+		std::uint64_t* out);
+
+void compare_values(compare_op op, const double* values,
+		const std::uint8_t* references, std::size_t n, double low, double high,
+		std::uint64_t* out);
+
+} // end namespace cell
+} // end namespace lattice
+
+#endif //__LATTICE_CELL_COMPARE_KERNELS_H__
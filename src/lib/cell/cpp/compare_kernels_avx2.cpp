@@ -0,0 +1,352 @@
+//
+// The AVX2 comparison kernels. Only this file is compiled for AVX2, and its
+// kernels are only called once the processor is known to support it.
+//
+
+#include <cstddef>
+#include <cstdint>
+
+#include <cell/cpp/compare_kernels.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+// Everything after this point may use AVX2.
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to=function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+#include <cell/cpp/compare_kernels_impl.h>
+
+namespace lattice {
+namespace cell {
+namespace {
+
+struct avx2_base
+{
+	static std::uint64_t present(const std::uint8_t* references)
+	{
+		auto zero = _mm256_setzero_si256();
+		auto p = static_cast<const __m256i*>(static_cast<const void*>(references));
+
+		std::uint64_t low = std::uint32_t(
+				_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(p), zero)));
+		std::uint64_t high = std::uint32_t(
+				_mm256_movemask_epi8(
+						_mm256_cmpeq_epi8(_mm256_loadu_si256(p + 1), zero)));
+
+		return ~(low | (high << 32));
+	}
+
+	static __m256i load_integers(const void* p)
+	{
+		return _mm256_loadu_si256(static_cast<const __m256i*>(p));
+	}
+};
+
+struct avx2_int16: avx2_base
+{
+	typedef std::int16_t value_type;
+	typedef __m256i vector_type;
+
+	static const std::size_t k_lanes = 16;
+	static const unsigned k_all = 0xFFFF;
+
+	static vector_type load(const value_type* p)
+	{
+		return load_integers(p);
+	}
+
+	static vector_type broadcast(value_type v)
+	{
+		return _mm256_set1_epi16(v);
+	}
+
+	static unsigned mask(vector_type m)
+	{
+		// Packing works within each half, so put the halves back in order.
+		auto packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(m, m), 0xD8);
+		return _mm256_movemask_epi8(packed) & k_all;
+	}
+
+	static unsigned equal(vector_type a, vector_type b)
+	{
+		return mask(_mm256_cmpeq_epi16(a, b));
+	}
+
+	static unsigned not_equal(vector_type a, vector_type b)
+	{
+		return ~equal(a, b) & k_all;
+	}
+
+	static unsigned less(vector_type a, vector_type b)
+	{
+		return mask(_mm256_cmpgt_epi16(b, a));
+	}
+
+	static unsigned less_equal(vector_type a, vector_type b)
+	{
+		return ~greater(a, b) & k_all;
+	}
+
+	static unsigned greater(vector_type a, vector_type b)
+	{
+		return mask(_mm256_cmpgt_epi16(a, b));
+	}
+
+	static unsigned greater_equal(vector_type a, vector_type b)
+	{
+		return ~less(a, b) & k_all;
+	}
+};
+
+struct avx2_int32: avx2_base
+{
+	typedef std::int32_t value_type;
+	typedef __m256i vector_type;
+
+	static const std::size_t k_lanes = 8;
+	static const unsigned k_all = 0xFF;
+
+	static vector_type load(const value_type* p)
+	{
+		return load_integers(p);
+	}
+
+	static vector_type broadcast(value_type v)
+	{
+		return _mm256_set1_epi32(v);
+	}
+
+	static unsigned mask(vector_type m)
+	{
+		return _mm256_movemask_ps(_mm256_castsi256_ps(m));
+	}
+
+	static unsigned equal(vector_type a, vector_type b)
+	{
+		return mask(_mm256_cmpeq_epi32(a, b));
+	}
+
+	static unsigned not_equal(vector_type a, vector_type b)
+	{
+		return ~equal(a, b) & k_all;
+	}
+
+	static unsigned less(vector_type a, vector_type b)
+	{
+		return mask(_mm256_cmpgt_epi32(b, a));
+	}
+
+	static unsigned less_equal(vector_type a, vector_type b)
+	{
+		return ~greater(a, b) & k_all;
+	}
+
+	static unsigned greater(vector_type a, vector_type b)
+	{
+		return mask(_mm256_cmpgt_epi32(a, b));
+	}
+
+	static unsigned greater_equal(vector_type a, vector_type b)
+	{
+		return ~less(a, b) & k_all;
+	}
+};
+
+struct avx2_int64: avx2_base
+{
+	typedef std::int64_t value_type;
+	typedef __m256i vector_type;
+
+	static const std::size_t k_lanes = 4;
+	static const unsigned k_all = 0xF;
+
+	static vector_type load(const value_type* p)
+	{
+		return load_integers(p);
+	}
+
+	static vector_type broadcast(value_type v)
+	{
+		return _mm256_set1_epi64x(v);
+	}
+
+	static unsigned mask(vector_type m)
+	{
+		return _mm256_movemask_pd(_mm256_castsi256_pd(m));
+	}
+
+	static unsigned equal(vector_type a, vector_type b)
+	{
+		return mask(_mm256_cmpeq_epi64(a, b));
+	}
+
+	static unsigned not_equal(vector_type a, vector_type b)
+	{
+		return ~equal(a, b) & k_all;
+	}
+
+	static unsigned less(vector_type a, vector_type b)
+	{
+		return mask(_mm256_cmpgt_epi64(b, a));
+	}
+
+	static unsigned less_equal(vector_type a, vector_type b)
+	{
+		return ~greater(a, b) & k_all;
+	}
+
+	static unsigned greater(vector_type a, vector_type b)
+	{
+		return mask(_mm256_cmpgt_epi64(a, b));
+	}
+
+	static unsigned greater_equal(vector_type a, vector_type b)
+	{
+		return ~less(a, b) & k_all;
+	}
+};
+
+struct avx2_float: avx2_base
+{
+	typedef float value_type;
+	typedef __m256 vector_type;
+
+	static const std::size_t k_lanes = 8;
+
+	static vector_type load(const value_type* p)
+	{
+		return _mm256_loadu_ps(p);
+	}
+
+	static vector_type broadcast(value_type v)
+	{
+		return _mm256_set1_ps(v);
+	}
+
+	static unsigned equal(vector_type a, vector_type b)
+	{
+		return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ));
+	}
+
+	static unsigned not_equal(vector_type a, vector_type b)
+	{
+		// Unordered, so that NaN is not equal to anything, as with !=.
+		return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_NEQ_UQ));
+	}
+
+	static unsigned less(vector_type a, vector_type b)
+	{
+		return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LT_OQ));
+	}
+
+	static unsigned less_equal(vector_type a, vector_type b)
+	{
+		return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LE_OQ));
+	}
+
+	static unsigned greater(vector_type a, vector_type b)
+	{
+		return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_GT_OQ));
+	}
+
+	static unsigned greater_equal(vector_type a, vector_type b)
+	{
+		return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_GE_OQ));
+	}
+};
+
+struct avx2_double: avx2_base
+{
+	typedef double value_type;
+	typedef __m256d vector_type;
+
+	static const std::size_t k_lanes = 4;
+
+	static vector_type load(const value_type* p)
+	{
+		return _mm256_loadu_pd(p);
+	}
+
+	static vector_type broadcast(value_type v)
+	{
+		return _mm256_set1_pd(v);
+	}
+
+	static unsigned equal(vector_type a, vector_type b)
+	{
+		return _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_EQ_OQ));
+	}
+
+	static unsigned not_equal(vector_type a, vector_type b)
+	{
+		return _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_NEQ_UQ));
+	}
+
+	static unsigned less(vector_type a, vector_type b)
+	{
+		return _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_LT_OQ));
+	}
+
+	static unsigned less_equal(vector_type a, vector_type b)
+	{
+		return _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_LE_OQ));
+	}
+
+	static unsigned greater(vector_type a, vector_type b)
+	{
+		return _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_GT_OQ));
+	}
+
+	static unsigned greater_equal(vector_type a, vector_type b)
+	{
+		return _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_GE_OQ));
+	}
+};
+
+} // end anonymous namespace
+
+namespace avx2 {
+
+LATTICE_COMPARE_KERNEL_ENTRY(std::int16_t)
+{
+	compare_dispatch<avx2_int16>(op, values, references, n, low, high, out);
+}
+
+LATTICE_COMPARE_KERNEL_ENTRY(std::int32_t)
+{
+	compare_dispatch<avx2_int32>(op, values, references, n, low, high, out);
+}
+
+LATTICE_COMPARE_KERNEL_ENTRY(std::int64_t)
+{
+	compare_dispatch<avx2_int64>(op, values, references, n, low, high, out);
+}
+
+LATTICE_COMPARE_KERNEL_ENTRY(float)
+{
+	compare_dispatch<avx2_float>(op, values, references, n, low, high, out);
+}
+
+LATTICE_COMPARE_KERNEL_ENTRY(double)
+{
+	compare_dispatch<avx2_double>(op, values, references, n, low, high, out);
+}
+
+} // end namespace avx2
+
+} // end namespace cell
+} // end namespace lattice
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+#endif
@@ -0,0 +1,282 @@
+#ifndef __LATTICE_CELL_COMPARE_KERNELS_IMPL_H__
+#define __LATTICE_CELL_COMPARE_KERNELS_IMPL_H__
+
+//
+// The parts of the comparison kernels shared by every instruction set.
+//
+// This is included by each kernel translation unit after it has selected
+// its target instruction set, so that the templates below are compiled for
+// that instruction set. Everything is kept in an anonymous namespace so
+// that code built for one instruction set can never be linked in place of
+// another. Do not include other headers from here for the same reason.
+//
+
+#include <cstddef>
+#include <cstdint>
+
+#include <cell/cpp/compare_kernels.h>
+
+namespace lattice {
+namespace cell {
+namespace {
+
+/**
+ * Traits for comparing one value at a time, used where there is no
+ * vector instruction for a type and for the end of an array.
+ *
+ * Vector traits provide the same members, with each comparison returning
+ * one bit per lane.
+ */
+template<typename T>
+struct scalar_traits
+{
+	typedef T value_type;
+	typedef T vector_type;
+
+	static const std::size_t k_lanes = 1;
+
+	static vector_type load(const value_type* p)
+	{
+		return *p;
+	}
+
+	static vector_type broadcast(value_type v)
+	{
+		return v;
+	}
+
+	static unsigned equal(vector_type a, vector_type b)
+	{
+		return a == b;
+	}
+
+	static unsigned not_equal(vector_type a, vector_type b)
+	{
+		return a != b;
+	}
+
+	static unsigned less(vector_type a, vector_type b)
+	{
+		return a < b;
+	}
+
+	static unsigned less_equal(vector_type a, vector_type b)
+	{
+		return a <= b;
+	}
+
+	static unsigned greater(vector_type a, vector_type b)
+	{
+		return a > b;
+	}
+
+	static unsigned greater_equal(vector_type a, vector_type b)
+	{
+		return a >= b;
+	}
+
+	/**
+	 * One bit per reference count, set if it is non-zero.
+	 */
+	static std::uint64_t present(const std::uint8_t* references)
+	{
+		std::uint64_t word = 0;
+		for (std::size_t i = 0; i < 64; ++i)
+			{
+				word |= std::uint64_t(references[i] != 0) << i;
+			}
+
+		return word;
+	}
+};
+
+//
+// The comparisons, written once for every set of traits.
+//
+
+struct op_equal
+{
+	template<typename V>
+	static unsigned apply(typename V::vector_type x,
+			typename V::vector_type low, typename V::vector_type)
+	{
+		return V::equal(x, low);
+	}
+};
+
+struct op_not_equal
+{
+	template<typename V>
+	static unsigned apply(typename V::vector_type x,
+			typename V::vector_type low, typename V::vector_type)
+	{
+		return V::not_equal(x, low);
+	}
+};
+
+struct op_less
+{
+	template<typename V>
+	static unsigned apply(typename V::vector_type x,
+			typename V::vector_type low, typename V::vector_type)
+	{
+		return V::less(x, low);
+	}
+};
+
+struct op_less_equal
+{
+	template<typename V>
+	static unsigned apply(typename V::vector_type x,
+			typename V::vector_type low, typename V::vector_type)
+	{
+		return V::less_equal(x, low);
+	}
+};
+
+struct op_greater
+{
+	template<typename V>
+	static unsigned apply(typename V::vector_type x,
+			typename V::vector_type low, typename V::vector_type)
+	{
+		return V::greater(x, low);
+	}
+};
+
+struct op_greater_equal
+{
+	template<typename V>
+	static unsigned apply(typename V::vector_type x,
+			typename V::vector_type low, typename V::vector_type)
+	{
+		return V::greater_equal(x, low);
+	}
+};
+
+struct op_between
+{
+	template<typename V>
+	static unsigned apply(typename V::vector_type x,
+			typename V::vector_type low, typename V::vector_type high)
+	{
+		return V::greater_equal(x, low) & V::less_equal(x, high);
+	}
+};
+
+/**
+ * Runs one comparison over an array, 64 values to an output word.
+ */
+template<typename V, typename Op>
+void compare_block(const typename V::value_type* values,
+		const std::uint8_t* references, std::size_t n,
+		typename V::value_type low, typename V::value_type high,
+		std::uint64_t* out)
+{
+	typedef scalar_traits<typename V::value_type> S;
+
+	auto low_vector = V::broadcast(low);
+	auto high_vector = V::broadcast(high);
+
+	std::size_t i = 0;
+	for (; i + 64 <= n; i += 64)
+		{
+			std::uint64_t word = 0;
+			for (std::size_t j = 0; j < 64; j += V::k_lanes)
+				{
+					std::uint64_t bits = Op::template apply<V>(
+							V::load(values + i + j), low_vector, high_vector);
+					word |= bits << j;
+				}
+
+			out[i / 64] = word & V::present(references + i);
+		}
+
+	// The rest of the array does not fill a word.
+	if (i < n)
+		{
+			std::uint64_t word = 0;
+			for (std::size_t j = 0; i + j < n; ++j)
+				{
+					std::uint64_t bit = Op::template apply<S>(values[i + j], low, high)
+							& (references[i + j] != 0);
+					word |= bit << j;
+				}
+
+			out[i / 64] = word;
+		}
+}
+
+/**
+ * Runs a comparison over an array with the given traits.
+ */
+template<typename V>
+void compare_dispatch(compare_op op, const typename V::value_type* values,
+		const std::uint8_t* references, std::size_t n,
+		typename V::value_type low, typename V::value_type high,
+		std::uint64_t* out)
+{
+	switch (op)
+		{
+		case compare_op::EQUAL:
+			compare_block<V, op_equal>(values, references, n, low, high, out);
+		break;
+
+		case compare_op::NOT_EQUAL:
+			compare_block<V, op_not_equal>(values, references, n, low, high, out);
+		break;
+
+		case compare_op::LESS:
+			compare_block<V, op_less>(values, references, n, low, high, out);
+		break;
+
+		case compare_op::LESS_EQUAL:
+			compare_block<V, op_less_equal>(values, references, n, low, high, out);
+		break;
+
+		case compare_op::GREATER:
+			compare_block<V, op_greater>(values, references, n, low, high, out);
+		break;
+
+		case compare_op::GREATER_EQUAL:
+			compare_block<V, op_greater_equal>(values, references, n, low, high,
+					out);
+		break;
+
+		case compare_op::BETWEEN:
+			compare_block<V, op_between>(values, references, n, low, high, out);
+		break;
+		}
+}
+
+} // end anonymous namespace
+
+//
+// Entry points for each instruction set, defined in their own
+// translation units.
+//
+
+#define LATTICE_COMPARE_KERNEL_ENTRY(T) \
+	void compare_values(compare_op op, const T* values, \
+			const std::uint8_t* references, std::size_t n, T low, T high, \
+			std::uint64_t* out)
+
+namespace sse2 {
+LATTICE_COMPARE_KERNEL_ENTRY(std::int16_t);
+LATTICE_COMPARE_KERNEL_ENTRY(std::int32_t);
+LATTICE_COMPARE_KERNEL_ENTRY(float);
+LATTICE_COMPARE_KERNEL_ENTRY(double);
+} // end namespace sse2
+
+namespace avx2 {
+LATTICE_COMPARE_KERNEL_ENTRY(std::int16_t);
+LATTICE_COMPARE_KERNEL_ENTRY(std::int32_t);
+LATTICE_COMPARE_KERNEL_ENTRY(std::int64_t);
+LATTICE_COMPARE_KERNEL_ENTRY(float);
+LATTICE_COMPARE_KERNEL_ENTRY(double);
+} // end namespace avx2
+
+} // end namespace cell
+} // end namespace lattice
+
+#endif //__LATTICE_CELL_COMPARE_KERNELS_IMPL_H__
@@ -1,3 +1,4 @@
+#include <cstring>
 #include <stdexcept>
 #include <string>
 #include <cell/cpp/data_value.h>
@@ -218,27 +219,29 @@ std::size_t data_value::write(std::uint8_t* buffer)
 }
 
 template<typename T>
-static std::size_t _read(T& value, std::uint8_t* buffer)
+static std::size_t _read(T& value, const std::uint8_t* buffer)
 {
-	T* ptr = static_cast<T*>(static_cast<void*>(buffer));
-	value = *ptr;
+	// Values are packed back to back in the pages, so 'buffer' need not
+	// be aligned for T.
+	std::memcpy(&value, buffer, sizeof(value));
 
 	return sizeof(value);
 }
 
 template<>
-std::size_t _read<>(std::string& value, std::uint8_t* buffer)
+std::size_t _read<>(std::string& value, const std::uint8_t* buffer)
 {
 	varchar_size_type size = 0;
 	_read(size, buffer);
 
-	value.assign(static_cast<char*>(static_cast<void*>(buffer + sizeof(size))),
-			size);
+	value.assign(
+			static_cast<const char*>(static_cast<const void*>(buffer
+					+ sizeof(size))), size);
 
 	return size + sizeof(size);
 }
 
-std::size_t data_value::read(std::uint8_t* buffer)
+std::size_t data_value::read(const std::uint8_t* buffer)
 {
 	set_on_exit f(has_value);
 
@@ -402,6 +405,52 @@ std::size_t data_value::copy(std::istream& in_buffer, std::ostream& out_buffer)
 		}
 }
 
+std::size_t data_value::copy(const std::uint8_t* in_buffer,
+		std::ostream& out_buffer)
+{
+	switch (type)
+		{
+	case column::data_type::smallint:
+		out_buffer.write(static_cast<const char*>(static_cast<const void*>(in_buffer)),
+				sizeof(value.i16));
+		return sizeof(value.i16);
+
+	case column::data_type::integer:
+		out_buffer.write(static_cast<const char*>(static_cast<const void*>(in_buffer)),
+				sizeof(value.i32));
+		return sizeof(value.i32);
+
+	case column::data_type::bigint:
+		out_buffer.write(static_cast<const char*>(static_cast<const void*>(in_buffer)),
+				sizeof(value.i64));
+		return sizeof(value.i64);
+
+	case column::data_type::real:
+		out_buffer.write(static_cast<const char*>(static_cast<const void*>(in_buffer)),
+				sizeof(value.f32));
+		return sizeof(value.f32);
+
+	case column::data_type::double_precision:
+		out_buffer.write(static_cast<const char*>(static_cast<const void*>(in_buffer)),
+				sizeof(value.f64));
+		return sizeof(value.f64);
+
+	case column::data_type::varchar:
+		{
+			varchar_size_type size;
+			_read(size, in_buffer);
+
+			// The length prefix and the characters are contiguous, so
+			// they can be copied in one go.
+			out_buffer.write(static_cast<const char*>(static_cast<const void*>(in_buffer)),
+					size + sizeof(size));
+
+			return size + sizeof(size);
+		}
+		}
+
+	return 0;
+}
 
 data_value data_value::as_smallint() const
 {
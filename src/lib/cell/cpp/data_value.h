@@ -216,7 +216,7 @@ public:
 	 *
 	 * @param buffer: The buffer to read from.
 	 */
-	std::size_t read(std::uint8_t* buffer);
+	std::size_t read(const std::uint8_t* buffer);
 
 	/**
 	 * Write this data value into a buffer.
@@ -242,6 +242,16 @@ public:
 	 */
 	std::size_t copy(std::istream& in_buffer, std::ostream& out_buffer);
 
+	/**
+	 * Copies the data from in_buffer to out_buffer.
+	 *
+	 * @param in_buffer:   The memory to read from.
+	 * @param out_buffer:  The buffer to write to;
+	 *
+	 * @returns: Number of bytes copied.
+	 */
+	std::size_t copy(const std::uint8_t* in_buffer, std::ostream& out_buffer);
+
 	/**
 	 * Compares the data value with the current value
 	 * pointed to by the cursor.
@@ -87,10 +87,66 @@ public:
    * Get the table that corresponds to the given table id.
    *
    * @param table_id: The object id of the table.
+   *
+   * @returns: The table, or an empty handle if there is no such table.
    */
   table_handle_type get_table(page::object_id_type table_id)
   {
-	  return tables[table_id];
+	  auto pos = tables.find(table_id);
+	  if (pos == tables.end())
+	    {
+	      return table_handle_type();
+	    }
+
+	  return pos->second;
+  }
+
+  /**
+   * Removes row versions no transaction can see any more, a little at a
+   * time. See table::vacuum().
+   *
+   * @param horizon: The time the oldest transaction still running began.
+   * @param max_rows: The most rows to look at, shared by all tables.
+   *
+   * @returns: The number of rows removed.
+   */
+  std::size_t vacuum(commit_timestamp_type horizon, std::size_t max_rows)
+  {
+    std::size_t removed = 0;
+    std::size_t share = tables.empty() ? 0 : max_rows / tables.size() + 1;
+
+    for (auto& t : tables)
+      {
+        if (t.second)
+          {
+            removed += t.second->vacuum(horizon, share);
+          }
+      }
+
+    return removed;
+  }
+
+  /**
+   * Reclaims space held by deleted objects, a little at a time.
+   *
+   * @param max_bytes: The number of bytes that may be copied, shared by
+   *                   all tables.
+   *
+   * @returns: The number of bytes copied.
+   */
+  page::size_type compact(page::size_type max_bytes)
+  {
+    page::size_type moved = 0;
+
+    for (auto& t : tables)
+      {
+        if (t.second && moved < max_bytes)
+          {
+            moved += t.second->compact(max_bytes - moved);
+          }
+      }
+
+    return moved;
   }
 
 };
@@ -0,0 +1,345 @@
+#ifndef __LATTICE_CELL_DICTIONARY_PAGE_H__
+#define __LATTICE_CELL_DICTIONARY_PAGE_H__
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include <cell/cpp/byte_arena.h>
+#include <cell/cpp/column.h>
+#include <cell/cpp/fixed_page.h>
+#include <cell/cpp/page.h>
+
+namespace lattice {
+namespace cell {
+
+/**
+ * A page for varchar columns with few distinct values.
+ *
+ * Every distinct value is stored once in the page's dictionary and
+ * assigned a code. Objects only store the code of their value, in a
+ * fixed_page, so that equality tests, IN lists and grouping can work on
+ * integer codes instead of strings.
+ *
+ * Dictionary entries are never removed, even when no object refers to
+ * them any more.
+ *
+ * The variable length storage inherited from page is not used.
+ */
+class dictionary_page: public page
+{
+public:
+	/** The type of a dictionary code. */
+	typedef std::uint32_t code_type;
+
+	/** The type of the page holding the codes of each object. */
+	typedef fixed_page<code_type> code_page_type;
+
+private:
+	typedef std::unordered_map<std::string, code_type> code_map_type;
+
+	/**
+	 * The code of every object.
+	 */
+	code_page_type codes;
+
+	/**
+	 * The distinct values, in the same length prefixed format used by
+	 * the variable length page.
+	 */
+	byte_arena values;
+
+	/**
+	 * Maps a code to the offset of its value.
+	 */
+	std::vector<atom_offset_type> value_offsets;
+
+	/**
+	 * Maps a value to its code.
+	 */
+	code_map_type value_codes;
+
+	/**
+	 * Provides the code for a value, adding it to the dictionary if it is
+	 * not already there.
+	 */
+	code_type encode(const std::string& data)
+	{
+		auto pos = value_codes.find(data);
+		if (pos != value_codes.end())
+			{
+				return pos->second;
+			}
+
+		code_type code = value_offsets.size();
+
+		std::uint32_t size = data.size();
+		value_offsets.push_back(values.append(&size, sizeof(size)));
+		values.append(data.c_str(), size);
+
+		value_codes.insert(std::make_pair(data, code));
+
+		return code;
+	}
+
+public:
+	dictionary_page() :
+			page(nullptr)
+	{
+	}
+
+	dictionary_page(cell::column *col) :
+			page(col)
+	{
+	}
+
+	//==----------------------------------------------------------==//
+	//                          API
+	//==----------------------------------------------------------==//
+
+	/**
+	 * Provides this page if it is dictionary encoded.
+	 */
+	virtual dictionary_page* get_dictionary_page()
+	{
+		return this;
+	}
+
+	/**
+	 * Counts how much data is stored in this page, including the
+	 * dictionary, and returns the value.
+	 */
+	virtual std::uint64_t size()
+	{
+		return codes.size() + values.size();
+	}
+
+	/**
+	 * Writes a new object into the page.
+	 *
+	 * @param object_id: The object to associate with the data.
+	 * @param data: The data to write.
+	 *
+	 * @returns: The number of bytes in the value.
+	 */
+	size_type insert_object(object_id_type object_id, const std::string& data)
+	{
+		codes.insert_object(object_id, encode(data));
+
+		return data.size() + sizeof(std::uint32_t);
+	}
+
+	/**
+	 * Reads an existing object from the page.
+	 *
+	 * @param object_id: The object to associate with the data.
+	 * @param data: The data to read.
+	 *
+	 * @returns: A tuple of (result, bytes read).
+	 */
+	std::tuple<bool, size_type> fetch_object(object_id_type object_id,
+			std::string& data)
+	{
+		auto location = get_data(object_id);
+		if (!std::get<0>(location))
+			{
+				return std::make_tuple(false, 0);
+			}
+
+		return std::make_tuple(true, _fetch_object(std::get<1>(location), data));
+	}
+
+	/**
+	 * Writes a new object into the page, reading it from a row buffer.
+	 *
+	 * @param object_id: The object to associate with the data.
+	 * @param buffer: The data to read the object from.
+	 * @param available: The number of bytes available in 'buffer'.
+	 *
+	 * @returns: The number of bytes consumed from 'buffer', or zero if
+	 *           'buffer' did not contain a whole object.
+	 */
+	virtual size_type insert_value(object_id_type object_id,
+			const byte_type* buffer, size_type available)
+	{
+		std::uint32_t size = 0;
+		if (available < sizeof(size))
+			{
+				return 0;
+			}
+
+		std::memcpy(&size, buffer, sizeof(size));
+		if (available - sizeof(size) < size)
+			{
+				return 0;
+			}
+
+		std::string data(
+				static_cast<const char*>(static_cast<const void*>(buffer
+						+ sizeof(size))), size);
+
+		return insert_object(object_id, data);
+	}
+
+	/**
+	 * Deletes the given object from this page.
+	 *
+	 * @param object_id: The object id to look for.
+	 */
+	virtual void delete_object(object_id_type object_id)
+	{
+		codes.delete_object(object_id);
+	}
+
+	/**
+	 * Acquires a reference count to this object.
+	 *
+	 * @param object_id: The object id to acquire.
+	 */
+	virtual bool acquire_object(object_id_type object_id)
+	{
+		return codes.acquire_object(object_id);
+	}
+
+	/**
+	 * Provides direct access to the value of an object. The value is
+	 * shared with every other object that has the same value.
+	 *
+	 * @param object_id: The object id to find.
+	 */
+	virtual std::tuple<bool, const byte_type*> get_data(
+			object_id_type object_id)
+	{
+		code_type code;
+		if (!std::get<0>(codes.fetch_object(object_id, code)))
+			{
+				return std::make_tuple(false, nullptr);
+			}
+
+		return std::make_tuple(true, get_value(code));
+	}
+
+	/**
+	 * Finds the first object whose id is at least 'object_id'.
+	 *
+	 * @param object_id: The object id to start looking at.
+	 */
+	virtual std::tuple<bool, object_id_type> next_object(
+			object_id_type object_id)
+	{
+		return codes.next_object(object_id);
+	}
+
+	/**
+	 * Reads a block of objects in object id order. The codes are read
+	 * first, and the values they refer to are prefetched.
+	 *
+	 * @param object_id: The object id to start looking at.
+	 * @param max: The most objects to read.
+	 * @param oids: Room for 'max' object ids.
+	 * @param data: Room for 'max' pointers to the values.
+	 * @param scratch: At least max * k_scratch_size bytes.
+	 */
+	virtual size_type read_block(object_id_type object_id, size_type max,
+			object_id_type* oids, const byte_type** data, byte_type* scratch)
+	{
+		auto n = codes.read_block(object_id, max, oids, data, scratch);
+
+		for (size_type i = 0; i < n; ++i)
+			{
+				code_type code;
+				std::memcpy(&code, data[i], sizeof(code));
+
+				data[i] = get_value(code);
+				__builtin_prefetch(data[i]);
+			}
+
+		return n;
+	}
+
+	/**
+	 * Reports how much of the code page's space is taken up by empty
+	 * slots. The dictionary itself is counted as live.
+	 */
+	virtual fragmentation_stats_type get_fragmentation()
+	{
+		auto stats = codes.get_fragmentation();
+		stats.bytes += values.size();
+		stats.live_bytes += values.size();
+
+		return stats;
+	}
+
+	//==----------------------------------------------------------==//
+	//                        Dictionary
+	//==----------------------------------------------------------==//
+
+	/**
+	 * The number of distinct values in the dictionary.
+	 */
+	size_type get_dictionary_size() const
+	{
+		return value_offsets.size();
+	}
+
+	/**
+	 * Provides the code of an object.
+	 *
+	 * @param object_id: The object id to find.
+	 *
+	 * @returns: A tuple of (result, code).
+	 */
+	std::tuple<bool, code_type> get_code(object_id_type object_id)
+	{
+		code_type code = 0;
+		auto result = std::get<0>(codes.fetch_object(object_id, code));
+
+		return std::make_tuple(result, code);
+	}
+
+	/**
+	 * Looks a value up in the dictionary.
+	 *
+	 * @param data: The value to look for.
+	 *
+	 * @returns: A tuple of (result, code). If result is false, no object
+	 *           in this page has the value.
+	 */
+	std::tuple<bool, code_type> find_code(const std::string& data) const
+	{
+		auto pos = value_codes.find(data);
+		if (pos == value_codes.end())
+			{
+				return std::make_tuple(false, 0);
+			}
+
+		return std::make_tuple(true, pos->second);
+	}
+
+	/**
+	 * Provides the value for a code, in length prefixed format.
+	 *
+	 * @param code: A code returned by this page.
+	 */
+	const byte_type* get_value(code_type code) const
+	{
+		return values.at(value_offsets[code]);
+	}
+
+	/**
+	 * Provides the page holding the code of every object, so that scans
+	 * can work directly on the code arrays.
+	 */
+	const code_page_type& get_codes() const
+	{
+		return codes;
+	}
+};
+
+} // end namespace cell
+} // end namespace lattice
+
+#endif //__LATTICE_CELL_DICTIONARY_PAGE_H__
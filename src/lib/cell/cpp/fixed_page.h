@@ -0,0 +1,970 @@
+#ifndef __LATTICE_CELL_FIXED_PAGE_H__
+#define __LATTICE_CELL_FIXED_PAGE_H__
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include <cell/cpp/column.h>
+#include <cell/cpp/data_value.h>
+#include <cell/cpp/integer_encoding.h>
+#include <cell/cpp/page.h>
+#include <cell/cpp/predicate.h>
+
+namespace lattice {
+namespace cell {
+
+/**
+ * Converts a zone map bound into a data_value, so that predicates can
+ * check it.
+ *
+ * @returns: false if the type has no matching column type.
+ */
+template<typename T>
+static bool _zone_value(const T& data, data_value& out)
+{
+	return false;
+}
+
+static inline bool _zone_value(const std::int16_t& data, data_value& out)
+{
+	out.set_value(column::data_type::smallint, data);
+	return true;
+}
+
+static inline bool _zone_value(const std::int32_t& data, data_value& out)
+{
+	out.set_value(column::data_type::integer, data);
+	return true;
+}
+
+static inline bool _zone_value(const std::int64_t& data, data_value& out)
+{
+	out.set_value(column::data_type::bigint, data);
+	return true;
+}
+
+static inline bool _zone_value(const float& data, data_value& out)
+{
+	out.set_value(column::data_type::real, data);
+	return true;
+}
+
+static inline bool _zone_value(const double& data, data_value& out)
+{
+	out.set_value(column::data_type::double_precision, data);
+	return true;
+}
+
+/**
+ * A page for a column whose values all have the same width.
+ *
+ * Values are kept in dense arrays of T, one array per atom, and an object
+ * lives in the slot given by its object id. Object ids are handed out
+ * sequentially by get_next_oid(), so the arrays stay densely packed and can
+ * be scanned directly without decoding anything.
+ *
+ * Object ids only grow, so once inserts move on to the next atom the
+ * previous one is sealed: integer values are re-encoded with whichever of
+ * frame of reference, delta or run length encoding suits them best, and
+ * the plain array is released. Reference counts are never encoded. A
+ * later insert into a sealed atom decodes it again.
+ *
+ * Every atom keeps a zone map, the smallest and largest value inserted
+ * into it, so that scans can skip atoms a predicate cannot match. Deletes
+ * do not shrink the zone map until the atom is sealed.
+ *
+ * The variable length storage inherited from page is not used.
+ */
+template<typename T>
+class fixed_page: public page
+{
+public:
+	/** The type of values stored in this page. */
+	typedef T value_type;
+
+	/** The number of value slots in one atom. */
+	static const object_id_type k_slots_per_atom = 16384;
+
+	/** The type of the values of a sealed atom. */
+	typedef encoded_integers<value_type> encoded_values_type;
+
+	/** The type of a fixed width atom. */
+	typedef struct fixed_atom
+	{
+		// The values, indexed by slot. Empty if the atom is encoded.
+		std::unique_ptr<value_type[]> values;
+
+		// The encoded values, if the atom has been sealed and an
+		// encoding was worth using.
+		std::unique_ptr<encoded_values_type> encoded;
+
+		// The reference count for each slot. Zero means that
+		// the slot is empty.
+		std::unique_ptr<reference_count_type[]> ref_counts;
+
+		// The number of objects in this atom.
+		size_type count;
+
+		// The zone map: no live value is outside [low, high].
+		value_type low;
+		value_type high;
+
+		fixed_atom() :
+				values(new value_type[k_slots_per_atom]), ref_counts(
+						new reference_count_type[k_slots_per_atom]()), count(0), low(), high()
+		{
+		}
+		;
+
+	} fixed_atom_type;
+
+	/** A handle to a fixed width atom. */
+	typedef std::unique_ptr<fixed_atom_type> fixed_atom_handle_type;
+
+	/** A list of fixed width atom handles. */
+	typedef std::vector<fixed_atom_handle_type> fixed_atom_list_type;
+
+private:
+	/**
+	 * This is the list of atoms. An entry is empty if none of the
+	 * slots it covers hold an object.
+	 */
+	fixed_atom_list_type slots;
+
+	/**
+	 * The atom inserts are currently going to. Atoms before it are sealed.
+	 */
+	size_type open_atom;
+
+	/**
+	 * Holds a value decoded by get_data().
+	 */
+	value_type decoded_value;
+
+	/** The number of values of an encoded atom decoded at a time. */
+	static const size_type k_decode_run = encoded_values_type::k_delta_block_size;
+
+	/**
+	 * The run of encoded values decoded last for reading objects, so that
+	 * reading a sealed atom in order decodes each run once, instead of
+	 * walking the deltas again for every value.
+	 */
+	const encoded_values_type* run_source;
+	size_type run_first;
+	size_type run_count;
+	value_type run_values[k_decode_run];
+
+	/**
+	 * Reads the value in a slot of an encoded atom, through the decoded
+	 * run.
+	 */
+	value_type read_encoded(const encoded_values_type& encoded,
+			object_id_type slot)
+	{
+		if (run_source != &encoded || slot < run_first
+				|| slot >= run_first + run_count)
+			{
+				run_first = slot - slot % k_decode_run;
+				run_count = std::min(size_type(k_decode_run),
+						encoded.get_count() - run_first);
+				encoded.decode(run_first, run_count, run_values);
+				run_source = &encoded;
+			}
+
+		return run_values[slot - run_first];
+	}
+
+	/**
+	 * Forgets the decoded run, before the encoded values it came from are
+	 * freed.
+	 */
+	void forget_decoded_run()
+	{
+		run_source = nullptr;
+	}
+
+	/**
+	 * Finds the atom and slot of an object.
+	 *
+	 * @param object_id: The object id to find.
+	 *
+	 * @returns: A tuple of (atom, slot). The atom is nullptr if the object
+	 *           does not exist.
+	 */
+	std::tuple<fixed_atom_type*, object_id_type> find_slot(
+			object_id_type object_id)
+	{
+		auto index = object_id / k_slots_per_atom;
+		auto slot = object_id % k_slots_per_atom;
+
+		if (index >= slots.size() || !slots[index]
+				|| slots[index]->ref_counts[slot] == 0)
+			{
+				return std::make_tuple(nullptr, slot);
+			}
+
+		return std::make_tuple(slots[index].get(), slot);
+	}
+
+	/**
+	 * Reads the value in a slot of an atom.
+	 */
+	static value_type read_slot(const fixed_atom_type* atom,
+			object_id_type slot)
+	{
+		return atom->encoded ? atom->encoded->get(slot) : atom->values[slot];
+	}
+
+	/**
+	 * Encodes the values of an atom, if that makes it smaller.
+	 *
+	 * @param index: The atom to seal.
+	 */
+	void seal_atom(size_type index)
+	{
+		auto atom = slots[index].get();
+		if (atom == nullptr || atom->encoded)
+			{
+				return;
+			}
+
+		// Empty slots hold garbage. Give them the value of their
+		// neighbour so they do not get in the way of the encoding.
+		object_id_type first = 0;
+		while (atom->ref_counts[first] == 0)
+			{
+				++first;
+			}
+
+		// The zone map is rebuilt from the live values on the way.
+		auto value = atom->values[first];
+		atom->low = atom->high = value;
+		for (object_id_type slot = 0; slot < k_slots_per_atom; ++slot)
+			{
+				if (atom->ref_counts[slot] == 0)
+					{
+						atom->values[slot] = value;
+					}
+				else
+					{
+						value = atom->values[slot];
+						atom->low = std::min(atom->low, value);
+						atom->high = std::max(atom->high, value);
+					}
+			}
+
+		std::unique_ptr<encoded_values_type> encoded(new encoded_values_type());
+		if (encoded->encode(atom->values.get(), k_slots_per_atom))
+			{
+				forget_decoded_run();
+				atom->encoded = std::move(encoded);
+				atom->values.reset();
+			}
+	}
+
+	/**
+	 * Provides an atom to insert into, creating it if needed and
+	 * sealing the atoms before it.
+	 *
+	 * @param index: The atom.
+	 */
+	fixed_atom_type* open_atom_for(size_type index)
+	{
+		if (index >= slots.size())
+			{
+				slots.resize(index + 1);
+			}
+
+		if (!slots[index])
+			{
+				slots[index] = fixed_atom_handle_type(new fixed_atom_type());
+			}
+
+		// Inserts have moved on, nothing more will be added to the
+		// atoms before this one.
+		for (; open_atom < index; ++open_atom)
+			{
+				seal_atom(open_atom);
+			}
+
+		auto atom = slots[index].get();
+		unseal_atom(atom);
+		return atom;
+	}
+
+	/**
+	 * Decodes the values of a sealed atom so that it can be written to.
+	 *
+	 * @param atom: The atom to unseal.
+	 */
+	void unseal_atom(fixed_atom_type* atom)
+	{
+		if (!atom->encoded)
+			{
+				return;
+			}
+
+		atom->values.reset(new value_type[k_slots_per_atom]);
+		atom->encoded->decode(atom->values.get());
+
+		forget_decoded_run();
+		atom->encoded.reset();
+	}
+
+public:
+	fixed_page() :
+			page(nullptr), open_atom(0), decoded_value(), run_source(nullptr),
+					run_first(0), run_count(0)
+	{
+	}
+
+	fixed_page(cell::column *col) :
+			page(col), open_atom(0), decoded_value(), run_source(nullptr),
+					run_first(0), run_count(0)
+	{
+	}
+
+	//==----------------------------------------------------------==//
+	//                          API
+	//==----------------------------------------------------------==//
+
+	/**
+	 * Counts how much data is stored in this page,
+	 * and returns the value.
+	 */
+	virtual std::uint64_t size()
+	{
+		std::uint64_t total_size = 0;
+
+		for (auto& atom : slots)
+			{
+				if (atom && atom->encoded)
+					{
+						total_size += atom->encoded->size();
+					}
+				else if (atom)
+					{
+						total_size += atom->count * sizeof(value_type);
+					}
+			}
+
+		return total_size;
+	}
+
+	/**
+	 * Writes a new object into the page.
+	 *
+	 * @param object_id: The object to associate with the data.
+	 * @param data: The data to write.
+	 *
+	 * @returns: The number of bytes written.
+	 */
+	size_type insert_object(object_id_type object_id, const value_type& data)
+	{
+		auto slot = object_id % k_slots_per_atom;
+		auto atom = open_atom_for(object_id / k_slots_per_atom);
+
+		if (atom->ref_counts[slot] == 0)
+			{
+				atom->count++;
+			}
+
+		if (atom->count == 1)
+			{
+				atom->low = atom->high = data;
+			}
+		else
+			{
+				atom->low = std::min(atom->low, data);
+				atom->high = std::max(atom->high, data);
+			}
+
+		atom->values[slot] = data;
+		atom->ref_counts[slot] = 1;
+
+		return sizeof(value_type);
+	}
+
+	/**
+	 * Reads an existing object from the page.
+	 *
+	 * @param object_id: The object to associate with the data.
+	 * @param data: The data to read.
+	 *
+	 * @returns: A tuple of (result, bytes read).
+	 */
+	std::tuple<bool, size_type> fetch_object(object_id_type object_id,
+			value_type& data)
+	{
+		fixed_atom_type* atom;
+		object_id_type slot;
+
+		std::tie(atom, slot) = find_slot(object_id);
+		if (atom == nullptr)
+			{
+				return std::make_tuple(false, 0);
+			}
+
+		data = read_slot(atom, slot);
+		return std::make_tuple(true, sizeof(value_type));
+	}
+
+	/**
+	 * Writes a new object into the page, reading it from a row buffer.
+	 *
+	 * @param object_id: The object to associate with the data.
+	 * @param buffer: The data to read the object from.
+	 * @param available: The number of bytes available in 'buffer'.
+	 *
+	 * @returns: The number of bytes consumed from 'buffer', or zero if
+	 *           'buffer' did not contain a whole object.
+	 */
+	virtual size_type insert_value(object_id_type object_id,
+			const byte_type* buffer, size_type available)
+	{
+		if (available < sizeof(value_type))
+			{
+				return 0;
+			}
+
+		value_type data;
+		std::memcpy(&data, buffer, sizeof(data));
+
+		return insert_object(object_id, data);
+	}
+
+	/**
+	 * Writes a run of new objects with consecutive object ids. The values
+	 * are copied into each atom in one go, and the zone map is updated
+	 * once per atom.
+	 *
+	 * @param first: The object id of the first object.
+	 * @param count: The number of objects.
+	 * @param buffer: The values, back to back.
+	 * @param available: The number of bytes available in 'buffer'.
+	 *
+	 * @returns: The number of bytes consumed from 'buffer', or zero if
+	 *           'buffer' did not contain 'count' values.
+	 */
+	virtual size_type insert_values(object_id_type first, size_type count,
+			const byte_type* buffer, size_type available)
+	{
+		if (available / sizeof(value_type) < count)
+			{
+				return 0;
+			}
+
+		size_type done = 0;
+		while (done < count)
+			{
+				auto object_id = first + done;
+				auto slot = object_id % k_slots_per_atom;
+				auto run = std::min<size_type>(count - done,
+						k_slots_per_atom - slot);
+
+				auto atom = open_atom_for(object_id / k_slots_per_atom);
+				auto* values = atom->values.get() + slot;
+
+				std::memcpy(values, buffer + done * sizeof(value_type),
+						run * sizeof(value_type));
+
+				auto low = values[0];
+				auto high = values[0];
+				for (size_type i = 0; i < run; ++i)
+					{
+						low = std::min(low, values[i]);
+						high = std::max(high, values[i]);
+
+						if (atom->ref_counts[slot + i] == 0)
+							{
+								atom->count++;
+							}
+						atom->ref_counts[slot + i] = 1;
+					}
+
+				if (atom->count == run)
+					{
+						atom->low = low;
+						atom->high = high;
+					}
+				else
+					{
+						atom->low = std::min(atom->low, low);
+						atom->high = std::max(atom->high, high);
+					}
+
+				done += run;
+			}
+
+		return count * sizeof(value_type);
+	}
+
+	/**
+	 * Deletes the given object from this page. The atom is released once
+	 * all of its objects are gone.
+	 *
+	 * @param object_id: The object id to look for.
+	 */
+	virtual void delete_object(object_id_type object_id)
+	{
+		fixed_atom_type* atom;
+		object_id_type slot;
+
+		std::tie(atom, slot) = find_slot(object_id);
+		if (atom == nullptr)
+			{
+				return;
+			}
+
+		atom->ref_counts[slot]--;
+		if (atom->ref_counts[slot] == 0)
+			{
+				atom->count--;
+				if (atom->count == 0)
+					{
+						forget_decoded_run();
+						slots[object_id / k_slots_per_atom].reset();
+					}
+			}
+	}
+
+	/**
+	 * Acquires a reference count to this object.
+	 *
+	 * @param object_id: The object id to acquire.
+	 *
+	 * @returns: false if there is no such object, or if its count is
+	 *           already at the maximum.
+	 */
+	virtual bool acquire_object(object_id_type object_id)
+	{
+		fixed_atom_type* atom;
+		object_id_type slot;
+
+		std::tie(atom, slot) = find_slot(object_id);
+		if (atom == nullptr
+				|| atom->ref_counts[slot]
+						== std::numeric_limits<reference_count_type>::max())
+			{
+				return false;
+			}
+
+		atom->ref_counts[slot]++;
+		return true;
+	}
+
+	/**
+	 * Provides direct access to the bytes of an object so that it
+	 * may be read in place. Values in a sealed atom are decoded into a
+	 * buffer owned by the page, which is overwritten by the next call.
+	 *
+	 * @param object_id: The object id to find.
+	 */
+	virtual std::tuple<bool, const byte_type*> get_data(
+			object_id_type object_id)
+	{
+		return read_data(object_id,
+				static_cast<byte_type*>(static_cast<void*>(&decoded_value)));
+	}
+
+	/**
+	 * Provides the bytes of an object, decoding values in a sealed atom
+	 * into 'scratch'.
+	 *
+	 * @param object_id: The object id to find.
+	 * @param scratch: At least k_scratch_size bytes.
+	 */
+	virtual std::tuple<bool, const byte_type*> read_data(
+			object_id_type object_id, byte_type* scratch)
+	{
+		fixed_atom_type* atom;
+		object_id_type slot;
+
+		std::tie(atom, slot) = find_slot(object_id);
+		if (atom == nullptr)
+			{
+				return std::make_tuple(false, nullptr);
+			}
+
+		if (atom->encoded)
+			{
+				value_type value = read_encoded(*atom->encoded, slot);
+				std::memcpy(scratch, &value, sizeof(value));
+
+				return std::make_tuple(true,
+						static_cast<const byte_type*>(scratch));
+			}
+
+		return std::make_tuple(true,
+				static_cast<const byte_type*>(static_cast<const void*>(&atom->values[slot])));
+	}
+
+	/**
+	 * Finds the first object whose id is at least 'object_id'.
+	 *
+	 * @param object_id: The object id to start looking at.
+	 */
+	virtual std::tuple<bool, object_id_type> next_object(
+			object_id_type object_id)
+	{
+		auto last = slots.size() * k_slots_per_atom;
+
+		for (; object_id < last; ++object_id)
+			{
+				auto& atom = slots[object_id / k_slots_per_atom];
+				if (!atom)
+					{
+						// Skip the whole atom, there is nothing in it.
+						object_id += k_slots_per_atom
+								- (object_id % k_slots_per_atom) - 1;
+						continue;
+					}
+
+				if (atom->ref_counts[object_id % k_slots_per_atom] > 0)
+					{
+						return std::make_tuple(true, object_id);
+					}
+			}
+
+		return std::make_tuple(false, object_id);
+	}
+
+	/**
+	 * Reads a block of objects in object id order. Values in sealed atoms
+	 * are decoded into 'scratch', the rest are read in place. Values are
+	 * laid out one after another, so no prefetching is needed.
+	 *
+	 * @param object_id: The object id to start looking at.
+	 * @param max: The most objects to read.
+	 * @param oids: Room for 'max' object ids.
+	 * @param data: Room for 'max' pointers to the values.
+	 * @param scratch: At least max * k_scratch_size bytes.
+	 */
+	virtual size_type read_block(object_id_type object_id, size_type max,
+			object_id_type* oids, const byte_type** data, byte_type* scratch)
+	{
+		auto last = slots.size() * k_slots_per_atom;
+		size_type n = 0;
+
+		for (; n < max && object_id < last; ++object_id)
+			{
+				auto& atom = slots[object_id / k_slots_per_atom];
+				if (!atom)
+					{
+						object_id += k_slots_per_atom
+								- (object_id % k_slots_per_atom) - 1;
+						continue;
+					}
+
+				auto slot = object_id % k_slots_per_atom;
+				if (atom->ref_counts[slot] == 0)
+					{
+						continue;
+					}
+
+				if (atom->encoded)
+					{
+						value_type value = read_encoded(*atom->encoded, slot);
+						auto location = scratch + n * k_scratch_size;
+						std::memcpy(location, &value, sizeof(value));
+						data[n] = location;
+					}
+				else
+					{
+						data[n] = static_cast<const byte_type*>(
+								static_cast<const void*>(&atom->values[slot]));
+					}
+
+				oids[n] = object_id;
+				++n;
+			}
+
+		return n;
+	}
+
+	/**
+	 * Finds the next atom at or after 'object_id' whose zone map does not
+	 * rule out the predicate.
+	 *
+	 * @param object_id: The object id to start looking at.
+	 * @param pred: The predicate to check the zone maps against.
+	 *
+	 * @returns: A tuple of (result, first object id, end object id).
+	 */
+	virtual std::tuple<bool, object_id_type, object_id_type> next_zone(
+			object_id_type object_id, predicate& pred)
+	{
+		data_value low, high;
+
+		for (auto index = object_id / k_slots_per_atom; index < slots.size();
+				++index)
+			{
+				auto& atom = slots[index];
+				if (!atom)
+					{
+						continue;
+					}
+
+				if (!_zone_value(atom->low, low) || !_zone_value(atom->high, high)
+						|| pred.may_match(low, high))
+					{
+						auto base = get_atom_base(index);
+						return std::make_tuple(true, std::max(object_id, base),
+								base + k_slots_per_atom);
+					}
+			}
+
+		return std::make_tuple(false, object_id, object_id);
+	}
+
+	/**
+	 * Reports how much of this page's space is taken up by empty slots.
+	 * Slots are fixed by object id, so there is nothing to compact and
+	 * atoms are freed as soon as they are empty.
+	 */
+	virtual fragmentation_stats_type get_fragmentation()
+	{
+		fragmentation_stats_type stats;
+
+		for (auto& atom : slots)
+			{
+				if (!atom)
+					{
+						continue;
+					}
+
+				stats.atoms++;
+				if (atom->encoded)
+					{
+						stats.bytes += atom->encoded->size();
+						stats.live_bytes += atom->encoded->size();
+					}
+				else
+					{
+						stats.bytes += k_slots_per_atom * sizeof(value_type);
+						stats.live_bytes += atom->count * sizeof(value_type);
+					}
+			}
+
+		return stats;
+	}
+
+	//==----------------------------------------------------------==//
+	//                        Scanning
+	//==----------------------------------------------------------==//
+
+	/**
+	 * The number of atoms in this page, including empty ones.
+	 */
+	size_type get_number_of_atoms() const
+	{
+		return slots.size();
+	}
+
+	/**
+	 * The object id stored in the first slot of an atom.
+	 *
+	 * @param index: The atom to look at.
+	 */
+	object_id_type get_atom_base(size_type index) const
+	{
+		return index * k_slots_per_atom;
+	}
+
+	/**
+	 * Provides the values of an atom. The array has k_slots_per_atom
+	 * entries, only those with a non-zero reference count hold objects.
+	 *
+	 * @param index: The atom to look at.
+	 *
+	 * @returns: The value array, or nullptr if the atom is empty or
+	 *           encoded.
+	 */
+	const value_type* get_atom_values(size_type index) const
+	{
+		return slots[index] ? slots[index]->values.get() : nullptr;
+	}
+
+	/**
+	 * Provides the values of an atom, decoding them if the atom is
+	 * encoded.
+	 *
+	 * @param index: The atom to look at.
+	 * @param buffer: Room for k_slots_per_atom values, used if the atom
+	 *                is encoded.
+	 *
+	 * @returns: The value array, either the atom's own or 'buffer', or
+	 *           nullptr if the atom is empty.
+	 */
+	const value_type* read_atom_values(size_type index,
+			value_type* buffer) const
+	{
+		if (!slots[index])
+			{
+				return nullptr;
+			}
+
+		if (slots[index]->encoded)
+			{
+				slots[index]->encoded->decode(buffer);
+				return buffer;
+			}
+
+		return slots[index]->values.get();
+	}
+
+	/**
+	 * Visits the values of the objects in [first, first + count) one atom
+	 * at a time, so that they can be processed in tight loops. Atoms that
+	 * are empty, or whose zone map rules out 'pred', are skipped.
+	 *
+	 * @param first: The first object id to visit.
+	 * @param count: The number of object ids to visit.
+	 * @param pred: The predicate to check zone maps against, or nullptr.
+	 * @param f: Called as f(position, values, references, n) for each run
+	 *           of n slots in one atom, where position is the offset of
+	 *           the run from 'first'. Slots with a zero reference count
+	 *           hold no object.
+	 */
+	template<typename F>
+	void scan(object_id_type first, size_type count, predicate* pred,
+			F f) const
+	{
+		// Only the slots asked for are decoded, not the whole atom.
+		std::unique_ptr<value_type[]> buffer;
+		size_type buffer_size = 0;
+		data_value low, high;
+
+		auto end = first + count;
+		for (auto object_id = first; object_id < end;)
+			{
+				auto index = object_id / k_slots_per_atom;
+				auto slot = object_id % k_slots_per_atom;
+				auto n = std::min<object_id_type>(end - object_id,
+						k_slots_per_atom - slot);
+
+				if (index >= slots.size())
+					{
+						break;
+					}
+
+				auto& atom = slots[index];
+				if (atom
+						&& (pred == nullptr || !_zone_value(atom->low, low)
+								|| !_zone_value(atom->high, high)
+								|| pred->may_match(low, high)))
+					{
+						const value_type* values;
+						if (atom->encoded)
+							{
+								if (buffer_size < n)
+									{
+										buffer.reset(new value_type[n]);
+										buffer_size = n;
+									}
+
+								atom->encoded->decode(slot, n, buffer.get());
+								values = buffer.get();
+							}
+						else
+							{
+								values = atom->values.get() + slot;
+							}
+
+						f(object_id - first, values,
+								atom->ref_counts.get() + slot, n);
+					}
+
+				object_id += n;
+			}
+	}
+
+	/**
+	 * Provides the zone map of an atom.
+	 *
+	 * @param index: The atom to look at.
+	 *
+	 * @returns: A tuple of (result, low, high). The result is false if
+	 *           the atom is empty.
+	 */
+	std::tuple<bool, value_type, value_type> get_atom_zone(
+			size_type index) const
+	{
+		if (!slots[index])
+			{
+				return std::make_tuple(false, value_type(), value_type());
+			}
+
+		return std::make_tuple(true, slots[index]->low, slots[index]->high);
+	}
+
+	/**
+	 * Provides the encoding of an atom's values.
+	 *
+	 * @param index: The atom to look at.
+	 */
+	integer_encoding get_atom_encoding(size_type index) const
+	{
+		return slots[index] && slots[index]->encoded ?
+				slots[index]->encoded->get_encoding() : integer_encoding::NONE;
+	}
+
+	/**
+	 * Seals every atom before the one inserts are going to.
+	 */
+	void seal()
+	{
+		auto last = std::min(open_atom, slots.size());
+		for (size_type index = 0; index < last; ++index)
+			{
+				seal_atom(index);
+			}
+	}
+
+	/**
+	 * Provides the reference counts of an atom, one per value slot.
+	 *
+	 * @param index: The atom to look at.
+	 *
+	 * @returns: The reference count array, or nullptr if the atom is empty.
+	 */
+	const reference_count_type* get_atom_references(size_type index) const
+	{
+		return slots[index] ? slots[index]->ref_counts.get() : nullptr;
+	}
+};
+
+/**
+ * Selects the objects in a block of a fixed width page whose values pass
+ * a test, one tight loop per atom.
+ *
+ * @param p: The page to read.
+ * @param first: The object id of the first object in the block.
+ * @param selection: The selection to fill in. The block is as long as
+ *                   the selection.
+ * @param pred: Atoms whose zone map this predicate rules out are not
+ *              read. May be nullptr.
+ * @param test: The test to run on each value.
+ */
+template<typename T, typename Test>
+void select_objects(const fixed_page<T>& p, page::object_id_type first,
+		selection_bitmap& selection, predicate* pred, Test test)
+{
+	selection.clear();
+	p.scan(first, selection.size(), pred,
+			[&](page::size_type position, const T* values,
+					const page::reference_count_type* references, page::size_type n)
+				{
+					selection.select(position, values, references, n, test);
+				});
+}
+
+} // end namespace cell
+} // end namespace lattice
+
+#endif //__LATTICE_CELL_FIXED_PAGE_H__
@@ -0,0 +1,480 @@
+#ifndef __LATTICE_CELL_INTEGER_ENCODING_H__
+#define __LATTICE_CELL_INTEGER_ENCODING_H__
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace lattice {
+namespace cell {
+
+/**
+ * The ways in which a block of integers can be encoded.
+ */
+enum class integer_encoding
+{
+	// The values are stored as they are.
+	NONE,
+
+	// Each value is stored as its bit packed difference from the smallest
+	// value.
+	FRAME_OF_REFERENCE,
+
+	// Each value is stored as its bit packed difference from the previous
+	// value.
+	DELTA,
+
+	// Runs of equal values are stored once.
+	RUN_LENGTH
+};
+
+/**
+ * A block of integers compressed with one of the lightweight encodings.
+ * The encoding is chosen from the data so that the result is as small as
+ * possible. Single values can be read without decoding the whole block.
+ *
+ * Only integer types are encoded, encode() always fails for other types.
+ */
+template<typename T>
+class encoded_integers
+{
+public:
+	typedef T value_type;
+
+	typedef std::size_t size_type;
+
+	/** The number of values between two delta checkpoints. */
+	static const size_type k_delta_block_size = 128;
+
+private:
+	typedef std::uint64_t word_type;
+
+	typedef struct run
+	{
+		// The index just past the end of the run.
+		std::uint32_t end;
+
+		// The value repeated in the run.
+		value_type value;
+	} run_type;
+
+	/** The encoding in use. */
+	integer_encoding encoding;
+
+	/** The number of values encoded. */
+	size_type count;
+
+	/**
+	 * For FRAME_OF_REFERENCE, the smallest value. For DELTA, the smallest
+	 * difference between two consecutive values.
+	 */
+	std::int64_t reference;
+
+	/** The number of bits used by each packed value. */
+	unsigned int width;
+
+	/** The bit packed values. */
+	std::vector<word_type> bits;
+
+	/** For DELTA, the value at the start of each block. */
+	std::vector<value_type> checkpoints;
+
+	/** For RUN_LENGTH, the list of runs. */
+	std::vector<run_type> runs;
+
+	/**
+	 * The number of bits needed to represent 'value'.
+	 */
+	static unsigned int bits_needed(std::uint64_t value)
+	{
+		unsigned int n = 0;
+		while (value != 0)
+			{
+				++n;
+				value >>= 1;
+			}
+
+		return n;
+	}
+
+	/**
+	 * Stores a packed value.
+	 */
+	void pack(size_type index, std::uint64_t value)
+	{
+		if (width == 0)
+			{
+				return;
+			}
+
+		auto offset = index * width;
+		auto word = offset / 64;
+		auto shift = offset % 64;
+
+		bits[word] |= value << shift;
+		if (shift + width > 64)
+			{
+				bits[word + 1] |= value >> (64 - shift);
+			}
+	}
+
+	/**
+	 * Reads a packed value.
+	 */
+	std::uint64_t unpack(size_type index) const
+	{
+		if (width == 0)
+			{
+				return 0;
+			}
+
+		auto offset = index * width;
+		auto word = offset / 64;
+		auto shift = offset % 64;
+
+		std::uint64_t value = bits[word] >> shift;
+		if (shift + width > 64)
+			{
+				value |= bits[word + 1] << (64 - shift);
+			}
+
+		return width == 64 ? value : value & ((std::uint64_t(1) << width) - 1);
+	}
+
+	/**
+	 * Sizes the bit packing area for the current count and width.
+	 */
+	void allocate_bits()
+	{
+		bits.assign((count * width + 63) / 64, 0);
+	}
+
+	/**
+	 * Bytes needed to bit pack 'n' values of 'w' bits each.
+	 */
+	static size_type packed_size(size_type n, unsigned int w)
+	{
+		return ((n * w + 63) / 64) * sizeof(word_type);
+	}
+
+public:
+	encoded_integers() :
+			encoding(integer_encoding::NONE), count(0), reference(0), width(0)
+	{
+	}
+
+	/**
+	 * The encoding chosen for the values.
+	 */
+	integer_encoding get_encoding() const
+	{
+		return encoding;
+	}
+
+	/**
+	 * The number of values encoded.
+	 */
+	size_type get_count() const
+	{
+		return count;
+	}
+
+	/**
+	 * The number of bytes used by the encoded values.
+	 */
+	size_type size() const
+	{
+		return bits.size() * sizeof(word_type)
+				+ checkpoints.size() * sizeof(value_type)
+				+ runs.size() * sizeof(run_type);
+	}
+
+	/**
+	 * Encodes the values with whichever encoding produces the smallest
+	 * result.
+	 *
+	 * @param values: The values to encode.
+	 * @param n: The number of values.
+	 *
+	 * @returns: true if the values were encoded, false if no encoding is
+	 *           smaller than the plain values.
+	 */
+	bool encode(const value_type* values, size_type n)
+	{
+		if (n == 0 || !std::is_integral<value_type>::value)
+			{
+				return false;
+			}
+
+		// Gather what we need to size each encoding.
+		std::int64_t low = values[0], high = values[0];
+		std::int64_t low_delta = std::numeric_limits<std::int64_t>::max();
+		std::int64_t high_delta = std::numeric_limits<std::int64_t>::min();
+		size_type number_of_runs = 1;
+		bool delta_fits = true;
+
+		for (size_type i = 1; i < n; ++i)
+			{
+				std::int64_t v = values[i];
+				low = std::min(low, v);
+				high = std::max(high, v);
+
+				if (values[i] != values[i - 1])
+					{
+						++number_of_runs;
+					}
+
+				if (i % k_delta_block_size == 0)
+					{
+						continue;
+					}
+
+				std::int64_t delta;
+				if (__builtin_sub_overflow(v, std::int64_t(values[i - 1]), &delta))
+					{
+						delta_fits = false;
+						continue;
+					}
+
+				low_delta = std::min(low_delta, delta);
+				high_delta = std::max(high_delta, delta);
+			}
+
+		auto plain_size = n * sizeof(value_type);
+		auto best_size = plain_size;
+		auto best = integer_encoding::NONE;
+
+		// The range of a 64 bit column may not fit in 64 bits.
+		std::uint64_t range = std::uint64_t(high) - std::uint64_t(low);
+		auto range_width = bits_needed(range);
+		if (range_width < 64 && packed_size(n, range_width) < best_size)
+			{
+				best_size = packed_size(n, range_width);
+				best = integer_encoding::FRAME_OF_REFERENCE;
+			}
+
+		unsigned int delta_width = 0;
+		if (delta_fits && n > 1)
+			{
+				std::uint64_t delta_range = std::uint64_t(high_delta)
+						- std::uint64_t(low_delta);
+				delta_width = bits_needed(delta_range);
+
+				auto delta_size = packed_size(n, delta_width)
+						+ ((n + k_delta_block_size - 1) / k_delta_block_size)
+								* sizeof(value_type);
+
+				if (delta_width < 64 && delta_size < best_size)
+					{
+						best_size = delta_size;
+						best = integer_encoding::DELTA;
+					}
+			}
+
+		if (number_of_runs * sizeof(run_type) < best_size)
+			{
+				best_size = number_of_runs * sizeof(run_type);
+				best = integer_encoding::RUN_LENGTH;
+			}
+
+		if (best == integer_encoding::NONE)
+			{
+				return false;
+			}
+
+		encoding = best;
+		count = n;
+		bits.clear();
+		checkpoints.clear();
+		runs.clear();
+
+		switch (encoding)
+			{
+			case integer_encoding::FRAME_OF_REFERENCE:
+				reference = low;
+				width = range_width;
+				allocate_bits();
+
+				for (size_type i = 0; i < n; ++i)
+					{
+						pack(i, std::uint64_t(std::int64_t(values[i]))
+								- std::uint64_t(reference));
+					}
+			break;
+
+			case integer_encoding::DELTA:
+				reference = n > 1 ? low_delta : 0;
+				width = delta_width;
+				allocate_bits();
+
+				for (size_type i = 0; i < n; ++i)
+					{
+						if (i % k_delta_block_size == 0)
+							{
+								checkpoints.push_back(values[i]);
+								continue;
+							}
+
+						std::int64_t delta = std::int64_t(values[i])
+								- std::int64_t(values[i - 1]);
+						pack(i, std::uint64_t(delta) - std::uint64_t(reference));
+					}
+			break;
+
+			case integer_encoding::RUN_LENGTH:
+				width = 0;
+				for (size_type i = 0; i < n; ++i)
+					{
+						if (runs.empty() || runs.back().value != values[i])
+							{
+								runs.push_back(run_type
+									{
+									std::uint32_t(i + 1), values[i]
+									});
+							}
+						else
+							{
+								runs.back().end = i + 1;
+							}
+					}
+			break;
+
+			default:
+			break;
+			}
+
+		return true;
+	}
+
+	/**
+	 * Reads a single value.
+	 *
+	 * @param index: The position of the value.
+	 */
+	value_type get(size_type index) const
+	{
+		switch (encoding)
+			{
+			case integer_encoding::FRAME_OF_REFERENCE:
+				return value_type(std::uint64_t(reference) + unpack(index));
+
+			case integer_encoding::DELTA:
+				{
+					auto block = index / k_delta_block_size;
+					std::uint64_t value = std::int64_t(checkpoints[block]);
+
+					for (auto i = block * k_delta_block_size + 1; i <= index; ++i)
+						{
+							value += std::uint64_t(reference) + unpack(i);
+						}
+
+					return value_type(value);
+				}
+
+			case integer_encoding::RUN_LENGTH:
+				{
+					auto pos = std::upper_bound(runs.begin(), runs.end(), index,
+							[](size_type i, const run_type& r)
+							{
+								return i < r.end;
+							});
+
+					return pos->value;
+				}
+
+			default:
+				return value_type();
+			}
+	}
+
+	/**
+	 * Decodes every value.
+	 *
+	 * @param out: The array to write the values into. It must have room
+	 *             for get_count() values.
+	 */
+	void decode(value_type* out) const
+	{
+		decode(0, count, out);
+	}
+
+	/**
+	 * Decodes the values in [first, first + n). The deltas or runs are
+	 * walked once for the whole range, rather than once per value as
+	 * get() does.
+	 *
+	 * @param first: The position of the first value.
+	 * @param n: The number of values.
+	 * @param out: The array to write the values into. It must have room
+	 *             for 'n' values.
+	 */
+	void decode(size_type first, size_type n, value_type* out) const
+	{
+		auto end = std::min(first + n, count);
+		if (first >= end)
+			{
+				return;
+			}
+
+		switch (encoding)
+			{
+			case integer_encoding::FRAME_OF_REFERENCE:
+				for (auto i = first; i < end; ++i)
+					{
+						out[i - first] = value_type(std::uint64_t(reference) + unpack(i));
+					}
+			break;
+
+			case integer_encoding::DELTA:
+				{
+					std::uint64_t value = std::int64_t(get(first));
+					out[0] = value_type(value);
+
+					for (auto i = first + 1; i < end; ++i)
+						{
+							if (i % k_delta_block_size == 0)
+								{
+									value = std::int64_t(checkpoints[i / k_delta_block_size]);
+								}
+							else
+								{
+									value += std::uint64_t(reference) + unpack(i);
+								}
+
+							out[i - first] = value_type(value);
+						}
+				}
+			break;
+
+			case integer_encoding::RUN_LENGTH:
+				{
+					auto pos = std::upper_bound(runs.begin(), runs.end(), first,
+							[](size_type i, const run_type& r)
+							{
+								return i < r.end;
+							});
+
+					for (auto i = first; i < end; ++i)
+						{
+							while (pos->end <= i)
+								{
+									++pos;
+								}
+
+							out[i - first] = pos->value;
+						}
+				}
+			break;
+
+			default:
+			break;
+			}
+	}
+};
+
+} // end namespace cell
+} // end namespace lattice
+
+#endif //__LATTICE_CELL_INTEGER_ENCODING_H__
@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <vector>
+
+#include <cell/cpp/fixed_page.h>
 #include <cell/cpp/list_predicate.h>
 #include <cell/cpp/page_cursor.h>
 
@@ -6,18 +10,181 @@ namespace lattice
 namespace cell
 {
 
+/**
+ * Selects the objects of a fixed width page whose value is in the list.
+ *
+ * @param get: Reads a T out of a data value.
+ *
+ * @returns: false if the page does not store values of type T.
+ */
+template<typename T, typename Get>
+static bool _select_values(page& p, page::object_id_type first,
+    selection_bitmap& selection, predicate* pred,
+    const list_predicate::scalar_list_type& list, Get get)
+{
+  auto fp = dynamic_cast<fixed_page<T>*>(&p);
+  if (fp == nullptr)
+    {
+      return false;
+    }
+
+  // The list is already sorted, so the values come out sorted.
+  std::vector<T> values;
+  for (auto& value : list)
+    {
+      values.push_back(get(value));
+    }
+
+  select_objects(*fp, first, selection, pred,
+      [&values](const T& x)
+        {
+          return std::binary_search(values.begin(), values.end(), x);
+        });
+
+  return true;
+}
+
 int
 list_predicate::cmp(page_cursor& cursor)
 {
   return 0;
 }
 
+void
+list_predicate::bind(dictionary_page& p)
+{
+  code_list.clear();
+
+  for (auto& value : pred_list)
+    {
+      if (value.get_type() != column::data_type::varchar)
+        {
+          continue;
+        }
+
+      bool found;
+      dictionary_page::code_type code;
+
+      std::tie(found, code) = p.find_code(*value.raw_string_value());
+      if (found)
+        {
+          code_list.insert(code);
+        }
+    }
+
+  code_page = &p;
+  code_page_size = p.get_dictionary_size();
+}
+
 bool
 list_predicate::contains(page_cursor& cursor)
 {
+  // Dictionary encoded pages can be checked with integer lookups.
+  auto dict = cursor.get_page().get_dictionary_page();
+  if (dict != nullptr)
+    {
+      // New values may have been added to the dictionary since the
+      // codes were looked up.
+      if (dict != code_page || dict->get_dictionary_size() != code_page_size)
+        {
+          bind(*dict);
+        }
+
+      auto code = std::get<1>(dict->get_code(cursor.oid()));
+      return code_list.find(code) != code_list.end();
+    }
+
   auto value = cursor.get_value();
   return pred_list.find(value) != pred_list.end();
 }
 
+bool
+list_predicate::may_match(const data_value& low, const data_value& high)
+{
+  if (pred_list.empty())
+    {
+      return false;
+    }
+
+  // Values of other types are not comparable, assume they match.
+  if (pred_list.begin()->get_type() != low.get_type())
+    {
+      return true;
+    }
+
+  // The list is sorted, so only the first value >= low needs checking.
+  auto pos = pred_list.lower_bound(low);
+
+  return pos != pred_list.end() && !(high < *pos);
+}
+
+void
+list_predicate::select(page& p, page::object_id_type first,
+    selection_bitmap& selection)
+{
+  bool done = false;
+
+  // Dictionary encoded pages are checked with integer lookups.
+  auto dict = p.get_dictionary_page();
+  if (dict != nullptr)
+    {
+      if (dict != code_page || dict->get_dictionary_size() != code_page_size)
+        {
+          bind(*dict);
+        }
+
+      auto& codes = code_list;
+      select_objects(dict->get_codes(), first, selection, nullptr,
+          [&codes](const dictionary_page::code_type& x)
+            {
+              return codes.find(x) != codes.end();
+            });
+
+      return;
+    }
+
+  // Every value has to be of the page's type for the typed loops.
+  auto type = pred_list.empty() ? column::data_type::varchar :
+      pred_list.begin()->get_type();
+  for (auto& value : pred_list)
+    {
+      if (value.get_type() != type)
+        {
+          type = column::data_type::varchar;
+        }
+    }
+
+  switch (type)
+    {
+    case column::data_type::smallint:
+      done = _select_values<std::int16_t>(p, first, selection, this,
+          pred_list, [](const data_value& v) { return v.raw_int16_value(); });
+    break;
+    case column::data_type::integer:
+      done = _select_values<std::int32_t>(p, first, selection, this,
+          pred_list, [](const data_value& v) { return v.raw_int32_value(); });
+    break;
+    case column::data_type::bigint:
+      done = _select_values<std::int64_t>(p, first, selection, this,
+          pred_list, [](const data_value& v) { return v.raw_int64_value(); });
+    break;
+    case column::data_type::real:
+      done = _select_values<float>(p, first, selection, this,
+          pred_list, [](const data_value& v) { return v.raw_float_value(); });
+    break;
+    case column::data_type::double_precision:
+      done = _select_values<double>(p, first, selection, this,
+          pred_list, [](const data_value& v) { return v.raw_double_value(); });
+    break;
+    default:
+    break;
+    }
+
+  if (!done)
+    {
+      predicate::select(p, first, selection);
+    }
+}
+
 } // namespace cell
 } // namespace lattice
@@ -2,9 +2,11 @@
 #define __LATTICE_CELL_LIST_PREDICATE_H__
 
 #include <set>
+#include <unordered_set>
 
 #include <cell/cpp/predicate.h>
 #include <cell/cpp/data_value.h>
+#include <cell/cpp/dictionary_page.h>
 
 namespace lattice
 {
@@ -15,21 +17,52 @@ namespace lattice
 	 {
 	 public:
 		typedef std::set<data_value> scalar_list_type;
+		typedef std::unordered_set<dictionary_page::code_type> code_list_type;
 	 private:
 		scalar_list_type pred_list;
+
+		/**
+		 * The dictionary codes of the values in pred_list, for the
+		 * dictionary page they were last looked up in.
+		 */
+		code_list_type code_list;
+
+		/** The page the codes in code_list belong to. */
+		dictionary_page* code_page;
+
+		/** The size of code_page's dictionary when code_list was built. */
+		dictionary_page::size_type code_page_size;
+
+		/**
+		 * Translates the values in the list into codes of the given
+		 * dictionary page.
+		 */
+		void bind(dictionary_page& p);
 	 public:
+		list_predicate() :
+		  code_page(nullptr), code_page_size(0)
+		  {
+		  }
+
 		template<typename T>
 		  void add_value(column::data_type t, const T& value)
 		  {
 			 data_value pred;
 			 pred.set_value(t, value);
 			 auto p =  pred_list.insert(pred);
-			 
+
+			 // Force the codes to be looked up again.
+			 code_page = nullptr;
 		  }
 
 		virtual int cmp(page_cursor& cursor);
 
 		virtual bool contains(page_cursor& cursor);
+
+		virtual bool may_match(const data_value& low, const data_value& high);
+
+		virtual void select(page& p, page::object_id_type first,
+			 selection_bitmap& selection);
 	 };
 
 } // namespace cell
@@ -0,0 +1,109 @@
+#ifndef __LATTICE_CELL_OID_SLAB_H__
+#define __LATTICE_CELL_OID_SLAB_H__
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <cell/cpp/page.h>
+
+namespace lattice {
+namespace cell {
+
+/**
+ * Hands out the column object id arrays of a table's rows.
+ *
+ * Every row of a table has the same number of columns, so the arrays are
+ * all the same size. They are carved out of large slabs instead of being
+ * allocated one at a time, and arrays given back are reused by the next
+ * rows.
+ */
+class oid_slab
+{
+public:
+   /** The type stored in the arrays. */
+   typedef page::object_id_type value_type;
+
+   /** The type for parameters indicating size. */
+   typedef std::size_t size_type;
+
+   /** The number of arrays carved out of each slab. */
+   static const size_type k_arrays_per_slab = 1024;
+
+private:
+   /** The number of values in each array. */
+   size_type width;
+
+   /** The slabs. */
+   std::vector<std::unique_ptr<value_type[]>> slabs;
+
+   /** The number of arrays handed out from the last slab. */
+   size_type used;
+
+   /** Arrays given back, to be handed out again. */
+   std::vector<value_type*> free_list;
+
+public:
+   /**
+    * @param _width: The number of values in each array.
+    */
+   explicit oid_slab(size_type _width) :
+         width(_width == 0 ? 1 : _width), used(k_arrays_per_slab)
+   {
+   }
+
+   // Arrays handed out point into the slabs.
+   oid_slab(const oid_slab&) = delete;
+   oid_slab& operator=(const oid_slab&) = delete;
+
+   /**
+    * The number of values in each array.
+    */
+   size_type get_width() const
+   {
+      return width;
+   }
+
+   /**
+    * The number of arrays handed out and not given back.
+    */
+   size_type size() const
+   {
+      return slabs.size() * k_arrays_per_slab - (k_arrays_per_slab - used)
+            - free_list.size();
+   }
+
+   /**
+    * Hands out an array. Its contents are undefined.
+    */
+   value_type* allocate()
+   {
+      if (!free_list.empty())
+         {
+            auto array = free_list.back();
+            free_list.pop_back();
+            return array;
+         }
+
+      if (used == k_arrays_per_slab)
+         {
+            slabs.emplace_back(new value_type[width * k_arrays_per_slab]);
+            used = 0;
+         }
+
+      return slabs.back().get() + width * used++;
+   }
+
+   /**
+    * Gives back an array handed out by allocate().
+    */
+   void release(value_type* array)
+   {
+      free_list.push_back(array);
+   }
+};
+
+} // namespace cell
+} // namespace lattice
+
+#endif // __LATTICE_CELL_OID_SLAB_H__
@@ -4,24 +4,30 @@
 #include <algorithm>
 #include <chrono>
 #include <cstdint>
+#include <cstring>
 #include <iterator>
+#include <limits>
 #include <memory>
 #include <set>
-#include <sstream>
+#include <string>
 #include <tuple>
-#include <unordered_map>
 #include <vector>
 
-#include <cell/cpp/page.h>
+#include <cell/cpp/byte_arena.h>
 #include <cell/cpp/column.h>
 
 namespace lattice {
 namespace cell {
 
-class page_cursor;
+class dictionary_page;
+class predicate;
 
 /**
  * A page contains data for a single column.
+ *
+ * This page stores objects of any size, one after another, in its atoms.
+ * Columns of fixed width types use fixed_page<T> instead, which overrides
+ * the virtual members below.
  */
 class page
 {
@@ -44,77 +50,73 @@ public:
 	typedef std::set<object_id_type> object_set_type;
 
 	/** The type for atom data bulk storage. */
-	typedef std::stringstream atom_data_type;
+	typedef byte_arena atom_data_type;
+
+	/** The type of an object's offset inside an atom. */
+	typedef atom_data_type::offset_type atom_offset_type;
+
+	/** The type of an atom's position in the atom list. */
+	typedef std::uint32_t atom_index_type;
 
-	/** The type for an object reference. */
-	typedef struct object_reference
+	/** The type for an object directory entry. */
+	typedef struct object_entry
 	{
-		bool forwarded;
+		// The atom the object's data lives in.
+		atom_index_type atom;
 
-		reference_count_type ref_count;
+		// The offset of the object's data inside the atom.
+		atom_offset_type offset;
 
-		union
-		{
-			// If not forwarded, this represents the actual data pointer
-			std::streampos offset;
+		// The number of bytes the object's data takes up.
+		std::uint32_t length;
 
-			// If forwarded, the id is set to the object id that points to the data.
-			object_id_type id;
-		};
+		// The number of references held on the object. Zero means
+		// that there is no object with this id.
+		reference_count_type ref_count;
 
-		/** Create a new object reference to an offset in the page. */
-		object_reference(const std::streampos& _offset) :
-				forwarded(false), ref_count(1), offset(_offset)
-		{
-		}
-		;
+	} object_entry_type;
 
-		/** Create a new object reference that forwards to another
-		 * reference.
-		 */
-		object_reference(const object_id_type& _oid) :
-				forwarded(true), ref_count(1), id(_oid)
-		{
-		}
-		;
+	/**
+	 * The number of directory entries in one directory chunk. Must be a
+	 * power of two.
+	 */
+	static const object_id_type k_directory_chunk_size = 4096;
 
-		object_reference(const object_reference& o)
-		{
-			forwarded = o.forwarded;
-			ref_count = o.ref_count;
-
-			if (forwarded)
-				{
-					id = o.id;
-				}
-			else
-				{
-					offset = o.offset;
-				}
-		}
+	/**
+	 * The number of bytes a caller of read_data() must provide for a value
+	 * that is not stored in place.
+	 */
+	static const size_type k_scratch_size = 8;
 
-	} object_reference_type;
+	/** The type of a directory chunk. */
+	typedef std::unique_ptr<object_entry_type[]> directory_chunk_type;
 
-	/** The type for the atom index. */
-	typedef std::unordered_map<object_id_type, object_reference_type> index_map_type;
+	/**
+	 * The type for the object directory. Entries are addressed directly by
+	 * object id, one chunk at a time, so that growing the directory never
+	 * moves existing entries.
+	 */
+	typedef std::vector<directory_chunk_type> directory_type;
 
 	/** The type of an atom. */
 	typedef struct atom
 	{
-		// This is the column to object index. It maps a objectid to an
-		// offset on the page.
-		index_map_type index;
-
 		// This is the actual data storage area.
 		atom_data_type data;
 
 		// The number of bytes written to this atom.
 		atom_size_type size;
 
+		// The number of bytes used by live objects. The rest of the
+		// atom is garbage left behind by deleted objects.
+		atom_size_type live;
+
+		// The object ids whose data was written to this atom. Objects
+		// since deleted, overwritten or moved are left in the list.
+		std::vector<object_id_type> oids;
+
 		atom() :
-				size(0), data(
-						atom_data_type::in | atom_data_type::out
-								| atom_data_type::binary)
+				size(0), live(0), oids()
 		{
 		}
 		;
@@ -124,11 +126,44 @@ public:
 	/** A handle to an atom. */
 	typedef std::unique_ptr<atom_type> atom_handle_type;
 
-	/** A list of atom handles. */
+	/**
+	 * A list of atom handles. An entry is empty once its atom has been
+	 * freed, so that the atom indexes of other objects do not change.
+	 */
 	typedef std::vector<atom_handle_type> atom_list_type;
 
-	/** Give page cursor access to our internals. */
-	friend class page_cursor;
+	/** Describes how much of a page's space is wasted. */
+	typedef struct fragmentation_stats
+	{
+		// The number of atoms holding data.
+		size_type atoms;
+
+		// The number of bytes allocated to those atoms.
+		std::uint64_t bytes;
+
+		// The number of bytes used by live objects.
+		std::uint64_t live_bytes;
+
+		// The number of atoms compact() would rewrite.
+		size_type sparse_atoms;
+
+		// The number of bytes given back since the page was created.
+		std::uint64_t reclaimed_bytes;
+
+		fragmentation_stats() :
+				atoms(0), bytes(0), live_bytes(0), sparse_atoms(0), reclaimed_bytes(
+						0)
+		{
+		}
+		;
+
+	} fragmentation_stats_type;
+
+	/**
+	 * Atoms whose live objects take up less than this percentage of the
+	 * atom are rewritten by compact().
+	 */
+	static const atom_size_type k_compaction_live_percent = 50;
 
 private:
 	//==----------------------------------------------------------==//
@@ -142,6 +177,11 @@ private:
 	 */
 	atom_list_type atoms;
 
+	/**
+	 * Maps object ids to the location of their data.
+	 */
+	directory_type directory;
+
 	/**
 	 * The maximum size an atom can attain.
 	 */
@@ -157,6 +197,16 @@ private:
 	 */
 	object_id_type next_oid;
 
+	/**
+	 * The atom compact() looks at first.
+	 */
+	atom_index_type compaction_cursor;
+
+	/**
+	 * The number of bytes given back by freeing atoms.
+	 */
+	std::uint64_t reclaimed_bytes;
+
 	//==----------------------------------------------------------==//
 	//                    Helper Functions
 	//==----------------------------------------------------------==//
@@ -166,22 +216,163 @@ private:
 	 *
 	 * @param object_id: The object id to find.
 	 *
-	 * returns: A tuple of (result, atoms::iterator, index::iterator)
+	 * returns: The directory entry for the object, or nullptr if
+	 *          there is no such object.
 	 */
-	std::tuple<bool, atom_list_type::iterator, index_map_type::iterator> find_object(
-			object_id_type object_id)
+	object_entry_type* find_object(object_id_type object_id)
+	{
+		auto chunk = object_id / k_directory_chunk_size;
+		if (chunk >= directory.size() || !directory[chunk])
+			{
+				return nullptr;
+			}
+
+		auto entry = &directory[chunk][object_id % k_directory_chunk_size];
+		if (entry->ref_count == 0)
+			{
+				return nullptr;
+			}
+
+		return entry;
+	}
+
+	/**
+	 * Provides the directory entry for an object id, growing the
+	 * directory if it is not large enough yet.
+	 *
+	 * @param object_id: The object id to add.
+	 */
+	object_entry_type* add_object(object_id_type object_id)
+	{
+		auto chunk = object_id / k_directory_chunk_size;
+		if (chunk >= directory.size())
+			{
+				directory.resize(chunk + 1);
+			}
+
+		if (!directory[chunk])
+			{
+				// Value-initialize, so that every entry starts out empty.
+				directory[chunk] = directory_chunk_type(
+						new object_entry_type[k_directory_chunk_size]());
+			}
+
+		return &directory[chunk][object_id % k_directory_chunk_size];
+	}
+
+	/**
+	 * Points a directory entry at an object's data, releasing the data
+	 * the entry pointed to before.
+	 *
+	 * @param object_id: The object the data belongs to.
+	 * @param offset: Where the data starts in the last atom.
+	 * @param length: The number of bytes of data.
+	 */
+	void place_object(object_id_type object_id, atom_offset_type offset,
+			std::uint32_t length)
+	{
+		auto entry = add_object(object_id);
+		if (entry->ref_count > 0)
+			{
+				release_object(entry);
+			}
+
+		entry->atom = atoms.size() - 1;
+		entry->offset = offset;
+		entry->length = length;
+		entry->ref_count = 1;
+
+		track_object(entry->atom, object_id, length);
+	}
+
+	/**
+	 * Counts an object's data as live in an atom.
+	 */
+	void track_object(atom_index_type index, object_id_type object_id,
+			std::uint32_t length)
+	{
+		auto atom = atoms[index].get();
+
+		atom->oids.push_back(object_id);
+		atom->live += length;
+	}
+
+	/**
+	 * Marks an object's data as garbage. Atoms other than the last one
+	 * are freed as soon as nothing in them is live.
+	 *
+	 * @param entry: The directory entry of the object.
+	 */
+	void release_object(const object_entry_type* entry)
+	{
+		auto& atom = atoms[entry->atom];
+
+		atom->live -= entry->length;
+		if (atom->live == 0 && entry->atom + 1 < atoms.size())
+			{
+				reclaimed_bytes += atom->size;
+				atom.reset();
+			}
+	}
+
+	/**
+	 * Indicates whether an atom has little enough live data that
+	 * compact() should rewrite it. The last atom is never rewritten.
+	 */
+	bool is_sparse(atom_index_type index) const
+	{
+		auto& atom = atoms[index];
+
+		return atom && index + 1 < atoms.size()
+				&& atom->live * 100 < atom->size * k_compaction_live_percent;
+	}
+
+	/**
+	 * Copies the live objects of an atom to the end of the page and frees
+	 * the atom. Only the objects written to the atom are looked at, not
+	 * every object id in between.
+	 *
+	 * @param index: The atom to move.
+	 *
+	 * @returns: The number of bytes copied.
+	 */
+	size_type move_atom(atom_index_type index)
 	{
-		for (auto atom = atoms.begin(); atom != atoms.end(); ++atom)
+		auto old_atom = atoms[index].get();
+		size_type moved = 0;
+
+		for (auto object_id : old_atom->oids)
 			{
-				auto &index = (*atom)->index;
-				auto pos = index.find(object_id);
-				if (pos != index.end())
+				if (old_atom->live == 0)
+					{
+						break;
+					}
+
+				auto entry = find_object(object_id);
+				if (entry == nullptr || entry->atom != index)
 					{
-						return std::make_tuple(true, atom, pos);
+						continue;
 					}
+
+				// The reference count stays as it is, only the
+				// location of the data changes.
+				auto target = get_last_atom();
+				auto length = entry->length;
+
+				entry->offset = target->data.append(
+						old_atom->data.at(entry->offset), length);
+				entry->atom = atoms.size() - 1;
+				target->size += length;
+				track_object(entry->atom, object_id, length);
+
+				old_atom->live -= length;
+				moved += length;
 			}
 
-		return std::make_tuple(false, atoms.end(), atoms.back()->index.end());
+		reclaimed_bytes += old_atom->size;
+		atoms[index].reset();
+
+		return moved;
 	}
 
 	/**
@@ -203,7 +394,8 @@ private:
 	 * Delegating constructor for building a page.
 	 */
 	page(atom_size_type _max_atom_size, cell::column* col) :
-			max_atom_size(_max_atom_size), column(col), next_oid(1)
+			max_atom_size(_max_atom_size), column(col), next_oid(1), compaction_cursor(
+					0), reclaimed_bytes(0)
 	{
 
 	}
@@ -222,6 +414,19 @@ public:
 
 	}
 
+	virtual ~page()
+	{
+	}
+
+	/**
+	 * Provides this page if it is dictionary encoded, otherwise
+	 * nullptr.
+	 */
+	virtual dictionary_page* get_dictionary_page()
+	{
+		return nullptr;
+	}
+
 	//==----------------------------------------------------------==//
 	//                          API
 	//==----------------------------------------------------------==//
@@ -252,13 +457,16 @@ public:
 	 * Counts how much data is stored in this page,
 	 * and returns the value.
 	 */
-	std::uint64_t size()
+	virtual std::uint64_t size()
 	{
 		std::uint64_t total_size = 0;
 
-		for (int i = 0; i < atoms.size(); ++i)
+		for (auto& atom : atoms)
 			{
-				total_size += atoms[i]->size;
+				if (atom)
+					{
+						total_size += atom->size;
+					}
 			}
 
 		return total_size;
@@ -272,6 +480,20 @@ public:
 		return next_oid++;
 	}
 
+	/**
+	 * Gets a run of object ids for this column at once.
+	 *
+	 * @param count: The number of object ids.
+	 *
+	 * @returns: The first object id. The others follow it.
+	 */
+	object_id_type get_next_oids(size_type count)
+	{
+		auto first = next_oid;
+		next_oid += count;
+		return first;
+	}
+
 	/**
 	 * Gets the column definition for this page.
 	 *
@@ -288,36 +510,22 @@ public:
 	 *
 	 * @param object_id: The object id to look for.
 	 */
-	void delete_object(object_id_type object_id)
+	virtual void delete_object(object_id_type object_id)
 	{
-		bool result;
-		atom_list_type::iterator atom;
-		index_map_type::iterator pos;
-
-		auto el = find_object(object_id);
-		std::tie(result, atom, pos) = el;
+		auto entry = find_object(object_id);
 
 		// If it was not found, return.
-		if (!result)
+		if (entry == nullptr)
 			{
 				return;
 			}
 
-		// Perform the deletion.
-		pos->second.ref_count--;
-		if (pos->second.ref_count == 0)
+		// Perform the deletion. The object's bytes stay in the
+		// atom until it is freed or compacted.
+		entry->ref_count--;
+		if (entry->ref_count == 0)
 			{
-				auto ap = (*atom).get();
-
-				// Erase the object.
-				ap->index.erase(pos);
-
-				// Potentially erase the atom.
-				// Note: this could use serious optimization.
-				if (ap->size == 0)
-					{
-						atoms.erase(atom);
-					}
+				release_object(entry);
 			}
 	}
 
@@ -342,35 +550,185 @@ public:
 	 * The object will be released when its references are all done.
 	 *
 	 * @param object_id: The object id to acquire.
+	 *
+	 * @returns: false if there is no such object, or if it already has as
+	 *           many references as the count can hold. The caller should
+	 *           then make its own copy of the object.
 	 */
-	bool acquire_object(object_id_type object_id)
+	virtual bool acquire_object(object_id_type object_id)
 	{
-		bool result;
-		atom_list_type::iterator atom;
-		index_map_type::iterator pos;
+		auto entry = find_object(object_id);
 
-		// If the atom is empty, we cannot read it.
-		if (atoms.size() == 0)
+		// No object, bail.
+		if (entry == nullptr)
 			{
 				return false;
 			}
 
-		// Get the object and unpack the results.
-		auto el = find_object(object_id);
-		std::tie(result, atom, pos) = el;
-
-		// No object, bail.
-		if (!result)
+		// Saturate rather than wrap around to zero.
+		if (entry->ref_count
+				== std::numeric_limits<reference_count_type>::max())
 			{
 				return false;
 			}
 
 		// Update the object's ref count.
-		pos->second.ref_count++;
+		entry->ref_count++;
 
 		return true;
 	}
 
+	/**
+	 * Writes a new object into the page, reading it from a row buffer
+	 * in the format produced by data_value::write().
+	 *
+	 * @param object_id: The object to associate with the data.
+	 * @param buffer: The data to read the object from.
+	 * @param available: The number of bytes available in 'buffer'.
+	 *
+	 * @returns: The number of bytes consumed from 'buffer', or zero if
+	 *           'buffer' did not contain a whole object.
+	 */
+	virtual size_type insert_value(object_id_type object_id,
+			const byte_type* buffer, size_type available)
+	{
+		std::uint32_t size = 0;
+		if (available < sizeof(size))
+			{
+				return 0;
+			}
+
+		// Variable length data is length prefixed.
+		std::memcpy(&size, buffer, sizeof(size));
+		if (available - sizeof(size) < size)
+			{
+				return 0;
+			}
+
+		auto atom = get_last_atom();
+		auto offset = atom->data.append(buffer, sizeof(size) + size);
+		atom->size += sizeof(size) + size;
+
+		place_object(object_id, offset, sizeof(size) + size);
+
+		return sizeof(size) + size;
+	}
+
+	/**
+	 * Writes a run of new objects with consecutive object ids, reading
+	 * them one after the other from a buffer in the format produced by
+	 * data_value::write().
+	 *
+	 * @param first: The object id of the first object.
+	 * @param count: The number of objects.
+	 * @param buffer: The data to read the objects from.
+	 * @param available: The number of bytes available in 'buffer'.
+	 *
+	 * @returns: The number of bytes consumed from 'buffer', or zero if
+	 *           'buffer' did not contain 'count' whole objects.
+	 */
+	virtual size_type insert_values(object_id_type first, size_type count,
+			const byte_type* buffer, size_type available)
+	{
+		size_type offset = 0;
+		for (size_type i = 0; i < count; ++i)
+			{
+				auto bytes = insert_value(first + i, buffer + offset,
+						available - offset);
+				if (bytes == 0)
+					{
+						return 0;
+					}
+
+				offset += bytes;
+			}
+
+		return offset;
+	}
+
+	/**
+	 * Finds the first object whose id is at least 'object_id'.
+	 *
+	 * @param object_id: The object id to start looking at.
+	 *
+	 * @returns: A tuple of (result, object id).
+	 */
+	virtual std::tuple<bool, object_id_type> next_object(
+			object_id_type object_id)
+	{
+		auto last = directory.size() * k_directory_chunk_size;
+
+		for (; object_id < last; ++object_id)
+			{
+				auto& chunk = directory[object_id / k_directory_chunk_size];
+				if (!chunk)
+					{
+						// Skip the whole chunk, there is nothing in it.
+						object_id += k_directory_chunk_size
+								- (object_id % k_directory_chunk_size) - 1;
+						continue;
+					}
+
+				if (chunk[object_id % k_directory_chunk_size].ref_count > 0)
+					{
+						return std::make_tuple(true, object_id);
+					}
+			}
+
+		return std::make_tuple(false, object_id);
+	}
+
+	/**
+	 * Reads a block of objects in object id order, starting with the first
+	 * object whose id is at least 'object_id'. The data of each object is
+	 * prefetched as it is found, so that it is on its way into the cache
+	 * by the time the caller reads the block.
+	 *
+	 * @param object_id: The object id to start looking at.
+	 * @param max: The most objects to read.
+	 * @param oids: Room for 'max' object ids.
+	 * @param data: Room for 'max' pointers to the bytes of the objects.
+	 *              They are only valid until the next write to this page
+	 *              or to 'scratch'.
+	 * @param scratch: At least max * k_scratch_size bytes that values not
+	 *                 stored in place may be decoded into.
+	 *
+	 * @returns: The number of objects read. This is less than 'max' only
+	 *           at the end of the page.
+	 */
+	virtual size_type read_block(object_id_type object_id, size_type max,
+			object_id_type* oids, const byte_type** data, byte_type* scratch)
+	{
+		auto last = directory.size() * k_directory_chunk_size;
+		size_type n = 0;
+
+		for (; n < max && object_id < last; ++object_id)
+			{
+				auto& chunk = directory[object_id / k_directory_chunk_size];
+				if (!chunk)
+					{
+						object_id += k_directory_chunk_size
+								- (object_id % k_directory_chunk_size) - 1;
+						continue;
+					}
+
+				auto& entry = chunk[object_id % k_directory_chunk_size];
+				if (entry.ref_count == 0)
+					{
+						continue;
+					}
+
+				auto location = atoms[entry.atom]->data.at(entry.offset);
+				__builtin_prefetch(location);
+
+				oids[n] = object_id;
+				data[n] = location;
+				++n;
+			}
+
+		return n;
+	}
+
 	/**
 	 * Writes a new object into the page.
 	 *
@@ -397,42 +755,135 @@ public:
 	std::tuple<bool, size_type> fetch_object(object_id_type object_id, T& data);
 
 	/**
-	 * Provides access to the istream object on the page so that
-	 * the object may be read directly.
+	 * Provides direct access to the bytes of an object so that it
+	 * may be read in place.
 	 *
 	 * @param object_id: The object id to find.
 	 *
-	 * The istream will have its read head positioned correctly when
-	 * returned.
+	 * @returns: A tuple of (result, pointer). The pointer is only valid
+	 *           until the next write to this page.
 	 */
-	std::tuple<bool, std::istream*> get_stream(object_id_type object_id)
+	virtual std::tuple<bool, const byte_type*> get_data(
+			object_id_type object_id)
 	{
-		bool result;
-		atom_list_type::iterator atom;
-		index_map_type::iterator pos;
+		auto entry = find_object(object_id);
 
-		// If the atom is empty, we cannot read it.
-		if (atoms.size() == 0)
+		if (entry == nullptr)
 			{
 				return std::make_tuple(false, nullptr);
 			}
 
-		// Get the object and unpack the results.
-		auto el = find_object(object_id);
-		std::tie(result, atom, pos) = el;
+		auto ap = atoms[entry->atom].get();
 
-		if (!result)
+		// Return success.
+		return std::make_tuple(true,
+				static_cast<const byte_type*>(ap->data.at(entry->offset)));
+	}
+
+	/**
+	 * Provides the bytes of an object like get_data(), but lets the
+	 * caller supply the space for values that are not stored in place,
+	 * such as values in an encoded atom. Several readers can then share
+	 * one page.
+	 *
+	 * @param object_id: The object id to find.
+	 * @param scratch: At least k_scratch_size bytes the value may be
+	 *                 decoded into.
+	 *
+	 * @returns: A tuple of (result, pointer). The pointer is only valid
+	 *           until the next write to this page or to 'scratch'.
+	 */
+	virtual std::tuple<bool, const byte_type*> read_data(
+			object_id_type object_id, byte_type* scratch)
+	{
+		return get_data(object_id);
+	}
+
+	/**
+	 * Finds the next zone at or after 'object_id' whose values may satisfy
+	 * a predicate. A zone is a range of object ids summarized by one zone
+	 * map, and zones that the predicate rules out are skipped.
+	 *
+	 * @param object_id: The object id to start looking at.
+	 * @param pred: The predicate to check the zone maps against.
+	 *
+	 * @returns: A tuple of (result, first object id, end object id). The
+	 *           end is one past the last object id in the zone.
+	 */
+	virtual std::tuple<bool, object_id_type, object_id_type> next_zone(
+			object_id_type object_id, predicate& pred)
+	{
+		// There are no zone maps here, so the whole page is one zone.
+		return std::make_tuple(true, object_id,
+				std::numeric_limits<object_id_type>::max());
+	}
+
+	//==----------------------------------------------------------==//
+	//                        Compaction
+	//==----------------------------------------------------------==//
+
+	/**
+	 * Reports how much of this page's space is taken up by deleted
+	 * objects.
+	 */
+	virtual fragmentation_stats_type get_fragmentation()
+	{
+		fragmentation_stats_type stats;
+
+		for (atom_index_type i = 0; i < atoms.size(); ++i)
 			{
-				return std::make_tuple(false, nullptr);
+				if (!atoms[i])
+					{
+						continue;
+					}
+
+				stats.atoms++;
+				stats.bytes += atoms[i]->size;
+				stats.live_bytes += atoms[i]->live;
+				if (is_sparse(i))
+					{
+						stats.sparse_atoms++;
+					}
 			}
 
-		auto ap = (*atom).get();
+		stats.reclaimed_bytes = reclaimed_bytes;
+		return stats;
+	}
 
-		// Seek to the proper position
-		ap->data.seekg(pos->second.offset);
+	/**
+	 * Rewrites sparse atoms, copying their live objects to the end of
+	 * the page and freeing the space held by deleted objects. Object ids
+	 * do not change.
+	 *
+	 * The work is done incrementally: each call picks up where the last
+	 * one stopped, and stops once 'max_bytes' bytes have been copied, so
+	 * it can run between requests without holding them up. At least one
+	 * atom is rewritten if any is sparse.
+	 *
+	 * @param max_bytes: The number of bytes that may be copied.
+	 *
+	 * @returns: The number of bytes copied.
+	 */
+	virtual size_type compact(size_type max_bytes)
+	{
+		size_type moved = 0;
+		size_type visited = 0;
 
-		// Return success.
-		return std::make_tuple(true, &(ap->data));
+		for (; visited < atoms.size() && moved < max_bytes; ++visited)
+			{
+				if (compaction_cursor >= atoms.size())
+					{
+						compaction_cursor = 0;
+					}
+
+				auto index = compaction_cursor++;
+				if (is_sparse(index))
+					{
+						moved += move_atom(index);
+					}
+			}
+
+		return moved;
 	}
 };
 
@@ -448,8 +899,6 @@ typedef std::unique_ptr<page> page_handle_type;
 /**
  * Writes a data element into a specific atom.
  *
- * Specialized for std::string.
- *
  * @param atom: The atom to write into.
  * @param data: The data to write.
  *
@@ -458,8 +907,7 @@ template<typename T>
 static void _insert_object(page::atom_type*atom, const T& data)
 {
 	// Write the data.
-	atom->data.write(static_cast<const char*>(static_cast<const void*>(&data)),
-			sizeof(data));
+	atom->data.append(&data, sizeof(data));
 
 	atom->size += sizeof(data);
 }
@@ -481,49 +929,47 @@ void _insert_object<>(page::atom_type*atom, const std::string& data)
 	_insert_object(atom, size);
 
 	// Write the data.
-	atom->data.write(data.c_str(), data.size());
+	atom->data.append(data.c_str(), size);
 	atom->size += size;
 }
 
 /**
- * Reads a data element from a specific atom.
+ * Reads a data element from raw atom memory.
  *
- * @param atom: The atom to read from.
+ * @param buffer: The location of the object inside the atom.
  * @param data: The data to read.
  *
  */
 template<typename T>
-static page::size_type _fetch_object(page::atom_type*atom, T& data)
+static page::size_type _fetch_object(const page::byte_type* buffer, T& data)
 {
 	// Read the data.
-	atom->data.read(static_cast<char*>(static_cast<void*>(&data)), sizeof(data));
+	std::memcpy(&data, buffer, sizeof(data));
 
 	return sizeof(data);
 }
 
 /**
- * Reads a data element from a specific atom.
+ * Reads a data element from raw atom memory.
  *
  * Specialized for std::string.
  *
- * @param atom: The atom to read from.
+ * @param buffer: The location of the object inside the atom.
  * @param data: The data to read.
  *
  */
 template<>
-page::size_type _fetch_object<>(page::atom_type*atom, std::string& data)
+page::size_type _fetch_object<>(const page::byte_type* buffer,
+		std::string& data)
 {
 	// Read the length of the string first.
-	std::uint32_t size = data.size();
-	_fetch_object(atom, size);
-
-	char buf[size];
-
-	// Read the data.
-	atom->data.read(buf, size);
+	std::uint32_t size = 0;
+	_fetch_object(buffer, size);
 
-	// Copy it into the string.
-	data.assign(buf, size);
+	// Copy the data into the string.
+	data.assign(
+			static_cast<const char*>(static_cast<const void*>(buffer
+					+ sizeof(size))), size);
 
 	return size + sizeof(size);
 }
@@ -545,21 +991,15 @@ page::size_type page::insert_object(object_id_type object_id, const T& data)
 {
 	auto atom = get_last_atom();
 
-	// Make sure we seek to the end of the stream.
-	atom->data.seekp(0, std::ios::end);
-
-	// Find out where that is.
-	auto pos = atom->data.tellp();
+	// New objects always go at the end of the atom.
+	atom_offset_type pos = atom->data.size();
 	auto initial_size = atom->size;
 
 	// Hand off the write.
 	_insert_object(atom, data);
 
-	// Update the index.
-	atom->index.insert(
-		{
-		object_id, object_reference_type(pos)
-		});
+	// Update the directory.
+	place_object(object_id, pos, atom->size - initial_size);
 
 	return atom->size - initial_size;
 }
@@ -578,32 +1018,17 @@ template<typename T>
 std::tuple<bool, page::size_type> page::fetch_object(object_id_type object_id,
 		T& data)
 {
-	bool result;
-	atom_list_type::iterator atom;
-	index_map_type::iterator pos;
-
-	// If the atom is empty, we cannot read it.
-	if (atoms.size() == 0)
-		{
-			return std::make_tuple(false, 0);
-		}
+	auto entry = find_object(object_id);
 
-	// Get the object and unpack the results.
-	auto el = find_object(object_id);
-	std::tie(result, atom, pos) = el;
-
-	if (!result)
+	if (entry == nullptr)
 		{
 			return std::make_tuple(false, 0);
 		}
 
-	auto ap = (*atom).get();
-
-	// Seek to the proper position
-	ap->data.seekg(pos->second.offset);
+	auto ap = atoms[entry->atom].get();
 
 	// Return success.
-	return std::make_tuple(true, _fetch_object(ap, data));
+	return std::make_tuple(true, _fetch_object(ap->data.at(entry->offset), data));
 }
 
 } // end namespace cell
@@ -7,19 +7,16 @@ namespace lattice
 namespace cell
 {
 
+const std::size_t page_cursor::k_block_size;
+
 data_value 
 page_cursor::get_value() 
   {
 	 auto type = p.get_column_definition()->type;
 	 data_value v(type);
 
-	 auto atom = p.atoms[atom_index].get();
-
-    // Seek to the proper position
-    atom->data.seekg(entry->second.offset);
-
 	 // Read out the data value
-	 v.read(atom->data);
+	 v.read(object_data);
 
 	 return v;
   }
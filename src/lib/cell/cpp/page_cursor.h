@@ -1,8 +1,12 @@
 #ifndef __LATTICE_CELL_PAGE_CURSOR_H__
 #define __LATTICE_CELL_PAGE_CURSOR_H__
 
+#include <algorithm>
+#include <cstddef>
+
 #include <cell/cpp/compare.h>
 #include <cell/cpp/page.h>
+#include <cell/cpp/predicate.h>
 
 namespace lattice
 {
@@ -13,37 +17,167 @@ namespace cell
 
 class page_cursor
 {
+public:
+  /**
+   * The most objects next_block() reads from the page at once.
+   */
+  static const std::size_t k_block_size = 64;
+
+private:
   /**
    * The page we are attached to.
    */
   page& p;
 
   /**
-   * Which atom we are iterating.
+   * The object id the cursor is pointing to.
+   */
+  page::object_id_type current;
+
+  /**
+   * The data of the object the cursor is pointing to.
+   */
+  const page::byte_type* object_data;
+
+  /**
+   * Space for the value of an object that is not stored in place,
+   * such as one in an encoded atom.
+   */
+  alignas(8) page::byte_type scratch[page::k_scratch_size];
+
+  /**
+   * The end of the zone the cursor is in, when moving with a predicate.
+   * Objects before it do not need their zone map checked again.
    */
-  unsigned int atom_index;
+  page::object_id_type zone_end;
 
   /**
-   * The atom index iterator.
+   * The predicate zone_end was found for.
    */
-  page::index_map_type::iterator entry;
+  predicate* zone_pred;
 
   /**
    * When this is set to true, we have reached the end of the page.
    */
   bool at_end;
 
+  /**
+   * Moves the cursor to the first object with an id >= 'from'.
+   */
+  void seek(page::object_id_type from)
+  {
+    bool found;
+
+    std::tie(found, current) = p.next_object(from);
+    if (!found)
+      {
+        at_end = true;
+        return;
+      }
+
+    object_data = std::get<1>(p.read_data(current, scratch));
+  }
+
+  /**
+   * Moves the cursor to the first object with an id >= 'from' in a zone
+   * that 'pred' may match.
+   */
+  void seek(page::object_id_type from, predicate& pred)
+  {
+    bool found;
+
+    if (zone_pred != &pred)
+      {
+        zone_pred = &pred;
+        zone_end = 0;
+      }
+
+    for (;;)
+      {
+        if (from >= zone_end)
+          {
+            page::object_id_type first;
+
+            std::tie(found, first, zone_end) = p.next_zone(from, pred);
+            if (!found)
+              {
+                at_end = true;
+                return;
+              }
+
+            from = first;
+          }
+
+        std::tie(found, current) = p.next_object(from);
+        if (!found)
+          {
+            at_end = true;
+            return;
+          }
+
+        // The object may be past the zone, in which case the zone
+        // it is in has to be checked.
+        if (current < zone_end)
+          {
+            object_data = std::get<1>(p.read_data(current, scratch));
+            return;
+          }
+
+        from = current;
+      }
+  }
+
 public:
 
   page_cursor(page& _page) :
       p(_page),
-          atom_index(0),
+          current(0),
+          object_data(nullptr),
+          zone_end(0),
+          zone_pred(nullptr),
           at_end(false)
   {
-    if (p.atoms.size() > 0)
-      {
-        entry = p.atoms[0]->index.begin();
-      }
+    seek(0);
+  }
+
+  /**
+   * Creates a cursor that starts at the first object with an id >= 'from'.
+   */
+  page_cursor(page& _page, page::object_id_type from) :
+      p(_page),
+          current(0),
+          object_data(nullptr),
+          zone_end(0),
+          zone_pred(nullptr),
+          at_end(false)
+  {
+    seek(from);
+  }
+
+  /**
+   * Creates a cursor that starts at the first object in a zone that
+   * 'pred' may match.
+   */
+  page_cursor(page& _page, predicate& pred) :
+      p(_page),
+          current(0),
+          object_data(nullptr),
+          zone_end(0),
+          zone_pred(nullptr),
+          at_end(false)
+  {
+    seek(0, pred);
+  }
+
+  // The data pointer may refer to our own scratch space.
+  page_cursor(const page_cursor&) = delete;
+
+  /**
+   * Provides the page the cursor is attached to.
+   */
+  page& get_page()
+  {
+    return p;
   }
 
   /**
@@ -61,25 +195,75 @@ public:
   {
     if (!at_end)
       {
-        ++entry;
-        if (entry == p.atoms[atom_index]->index.end())
+        seek(current + 1);
+      }
+    return *this;
+  }
+
+  /**
+   * Advance the cursor to the next object in a zone that 'pred' may
+   * match, skipping whole atoms that its zone maps rule out. Objects
+   * that are not skipped still need to be checked with 'pred'.
+   */
+  page_cursor& advance(predicate& pred)
+  {
+    if (!at_end)
+      {
+        seek(current + 1, pred);
+      }
+    return *this;
+  }
+
+  /**
+   * Reads the values of up to 'max' objects, starting with the one at the
+   * cursor, and moves the cursor past them. Objects are read in object id
+   * order, a block at a time, which is much faster than advance() for
+   * scanning a whole page.
+   *
+   * @param values: Room for 'max' values.
+   * @param oids: Room for the 'max' object ids of the values, or nullptr.
+   * @param max: The most values to read.
+   *
+   * @returns: The number of values read. This is less than 'max' only
+   *           when the cursor has reached the end of the page.
+   */
+  template<typename T>
+  std::size_t next_block(T* values, page::object_id_type* oids,
+      std::size_t max)
+  {
+    page::object_id_type block_oids[k_block_size];
+    const page::byte_type* block_data[k_block_size];
+    alignas(8) page::byte_type block_scratch[k_block_size
+        * page::k_scratch_size];
+
+    std::size_t n = 0;
+    while (!at_end && n < max)
+      {
+        auto wanted = std::min(max - n, k_block_size);
+        auto got = p.read_block(current, wanted, block_oids, block_data,
+            block_scratch);
+
+        for (std::size_t i = 0; i < got; ++i)
           {
-            ++atom_index;
-            if (atom_index < p.atoms.size())
-              {
-                entry = p.atoms[atom_index]->index.begin();
-              }
-            else
-              {
-                at_end = true;
-              }
+            _fetch_object(block_data[i], values[n + i]);
           }
-        else
+
+        if (oids != nullptr)
+          {
+            std::copy(block_oids, block_oids + got, oids + n);
+          }
+
+        n += got;
+        if (got < wanted)
           {
             at_end = true;
+            break;
           }
+
+        seek(block_oids[got - 1] + 1);
       }
-    return *this;
+
+    return n;
   }
 
   /**
@@ -91,7 +275,7 @@ public:
    */
   page::object_id_type oid()
   {
-    return entry->first;
+    return current;
   }
 
   /**
@@ -107,12 +291,7 @@ public:
   template<typename T>
   std::size_t value(T& data)
   {
-    auto atom = p.atoms[atom_index].get();
-
-    // Seek to the proper position
-    atom->data.seekg(entry->second.offset);
-
-    return _fetch_object(atom, data);
+    return _fetch_object(object_data, data);
   }
 
   /**
@@ -134,13 +313,8 @@ public:
   template<typename T>
   int cmp(const T& data)
   {
-    auto atom = p.atoms[atom_index].get();
-
-    // Seek to the proper position
-    atom->data.seekg(entry->second.offset);
-
-    // Compare the data.
-    return cell::cmp(data, atom->data);
+    // Compare the data in place.
+    return cell::cmp(data, static_cast<const std::uint8_t*>(object_data));
   }
 
 };
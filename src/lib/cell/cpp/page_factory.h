@@ -0,0 +1,56 @@
+#ifndef __LATTICE_CELL_PAGE_FACTORY_H__
+#define __LATTICE_CELL_PAGE_FACTORY_H__
+
+#include <cstdint>
+
+#include <cell/cpp/column.h>
+#include <cell/cpp/dictionary_page.h>
+#include <cell/cpp/fixed_page.h>
+#include <cell/cpp/page.h>
+
+namespace lattice {
+namespace cell {
+
+/**
+ * Creates a page suitable for storing the given column.
+ *
+ * @param col: The column definition. The page takes ownership of it.
+ *
+ * @returns: A handle to the new page, or an empty handle if the storage
+ *           engine does not know how to store the column's data type.
+ */
+static inline page_handle_type make_page(column* col)
+{
+	switch (col->type)
+		{
+	case column::data_type::smallint:
+		return page_handle_type(new fixed_page<std::int16_t>(col));
+
+	case column::data_type::integer:
+		return page_handle_type(new fixed_page<std::int32_t>(col));
+
+	case column::data_type::bigint:
+		return page_handle_type(new fixed_page<std::int64_t>(col));
+
+	case column::data_type::real:
+		return page_handle_type(new fixed_page<float>(col));
+
+	case column::data_type::double_precision:
+		return page_handle_type(new fixed_page<double>(col));
+
+	case column::data_type::varchar:
+		if (col->dictionary_encoded)
+			{
+				return page_handle_type(new dictionary_page(col));
+			}
+		return page_handle_type(new page(col));
+
+	default:
+		return page_handle_type(nullptr);
+		}
+}
+
+} // end namespace cell
+} // end namespace lattice
+
+#endif //__LATTICE_CELL_PAGE_FACTORY_H__
@@ -0,0 +1,27 @@
+#include <cell/cpp/page_cursor.h>
+#include <cell/cpp/predicate.h>
+
+namespace lattice
+{
+namespace cell
+{
+
+void
+predicate::select(page& p, page::object_id_type first,
+    selection_bitmap& selection)
+{
+  selection.clear();
+
+  auto end = first + selection.size();
+  for (page_cursor cursor(p, first);
+       !cursor.end_of_page() && cursor.oid() < end; cursor.advance())
+    {
+      if (contains(cursor))
+        {
+          selection.set(cursor.oid() - first);
+        }
+    }
+}
+
+} // namespace cell
+} // namespace lattice
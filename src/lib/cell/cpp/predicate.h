@@ -3,11 +3,15 @@
 
 #include <memory>
 
+#include <cell/cpp/page.h>
+#include <cell/cpp/selection.h>
+
 namespace lattice
 {
 	namespace cell
    {
 
+	  class data_value;
 	  class page_cursor;
 
 		class predicate
@@ -15,6 +19,34 @@ namespace lattice
 		public:
 			virtual int cmp(page_cursor& cursor)=0;
 			virtual bool contains(page_cursor& cursor)=0;
+
+			/**
+			 * Indicates whether any value between 'low' and 'high',
+			 * inclusive, could satisfy this predicate. Scans use this to
+			 * skip atoms whose zone map rules them out, so the answer
+			 * must only be false when no value in the range can match.
+			 */
+			virtual bool may_match(const data_value& low, const data_value& high)
+			{
+				return true;
+			}
+
+			/**
+			 * Evaluates the predicate over a block of objects at once.
+			 * Bit i of 'selection' is set when object 'first + i' exists
+			 * and satisfies the predicate, and cleared otherwise. The
+			 * block is as long as 'selection'.
+			 *
+			 * This implementation visits the objects one at a time with a
+			 * cursor. Predicates override it to work directly on the
+			 * value arrays of the pages they know about.
+			 *
+			 * @param p: The page to read values from.
+			 * @param first: The object id of the first object in the block.
+			 * @param selection: The selection to fill in.
+			 */
+			virtual void select(page& p, page::object_id_type first,
+					selection_bitmap& selection);
 		};
 
 		typedef std::shared_ptr<predicate> predicate_handle_type;
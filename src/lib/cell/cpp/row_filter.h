@@ -0,0 +1,126 @@
+#ifndef __LATTICE_CELL_ROW_FILTER_H__
+#define __LATTICE_CELL_ROW_FILTER_H__
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <cell/cpp/predicate.h>
+
+namespace lattice {
+namespace cell {
+
+/**
+ * A condition on the columns of a row. The leaves test one column each
+ * with a predicate, and are joined with AND and OR.
+ *
+ * An AND with no children matches every row, and an OR with no children
+ * matches none.
+ */
+class row_filter
+{
+public:
+   /** What a node of the tree does. */
+   enum class kind
+   {
+      COLUMN,     // Tests one column with a predicate.
+
+      AND,        // Matches if every child matches.
+
+      OR          // Matches if any child matches.
+   };
+
+   typedef std::vector<row_filter> children_type;
+
+private:
+   kind k;
+
+   /** The column tested by a COLUMN node. */
+   std::size_t column_number;
+
+   /** The test for a COLUMN node. */
+   predicate_handle_type pred;
+
+   /** The operands of an AND or OR node. */
+   children_type children;
+
+public:
+   /**
+    * Makes a filter that matches every row.
+    */
+   row_filter() :
+         k(kind::AND), column_number(0)
+   {
+   }
+
+   /**
+    * Makes a filter testing one column.
+    *
+    * @param column: The column to test.
+    * @param p: The test.
+    */
+   row_filter(std::size_t column, predicate_handle_type p) :
+         k(kind::COLUMN), column_number(column), pred(std::move(p))
+   {
+   }
+
+   /**
+    * Makes a filter joining others.
+    *
+    * @param op: kind::AND or kind::OR.
+    * @param operands: The filters to join.
+    */
+   row_filter(kind op, children_type operands) :
+         k(op), column_number(0), children(std::move(operands))
+   {
+   }
+
+   kind get_kind() const
+   {
+      return k;
+   }
+
+   /**
+    * Evaluates the filter, stopping as soon as the answer is known.
+    *
+    * @param test: Called with a column number and a predicate&, and
+    *              returns whether that column of the row satisfies the
+    *              predicate.
+    */
+   template<typename Test>
+   bool matches(Test& test) const
+   {
+      switch (k)
+         {
+         case kind::COLUMN:
+            return pred && test(column_number, *pred);
+
+         case kind::AND:
+            for (auto& child : children)
+               {
+                  if (!child.matches(test))
+                     {
+                        return false;
+                     }
+               }
+            return true;
+
+         case kind::OR:
+            for (auto& child : children)
+               {
+                  if (child.matches(test))
+                     {
+                        return true;
+                     }
+               }
+            return false;
+         }
+
+      return false;
+   }
+};
+
+} // namespace cell
+} // namespace lattice
+
+#endif // __LATTICE_CELL_ROW_FILTER_H__
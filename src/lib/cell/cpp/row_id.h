@@ -32,11 +32,29 @@ public:
       return row_id(value);
    }
 
+   std::uint64_t to_uint64() const
+   {
+      return id;
+   }
+
    row_id next()
    {
       return row_id(++id);
    }
 
+   /**
+    * Hands out a block of ids at once, as if next() had been called
+    * 'count' times.
+    *
+    * @returns: The first id of the block. The others follow it.
+    */
+   row_id reserve(std::uint64_t count)
+   {
+      row_id first(id + 1);
+      id += count;
+      return first;
+   }
+
    bool operator==(const row_id& o) const
    {
       return id == o.id;
@@ -0,0 +1,364 @@
+#ifndef __LATTICE_CELL_ROW_STORE_H__
+#define __LATTICE_CELL_ROW_STORE_H__
+
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <cell/cpp/row_id.h>
+#include <cell/cpp/row_value.h>
+
+namespace lattice {
+namespace cell {
+
+/**
+ * The rows of a table, addressed directly by row id.
+ *
+ * Row ids are handed out in sequence, so rather than hashing them the
+ * store keeps a directory of fixed size chunks of row slots, and the row
+ * id is the slot number. Lookups are a pair of array indexes, scans run
+ * in insert order, and growing the store never moves a row, so iterators
+ * stay valid while rows are inserted. An iterator at end() moves on to
+ * rows inserted after it got there.
+ *
+ * Iterators dereference to a (row id, row) pair, like the hash map this
+ * replaces.
+ */
+class row_store
+{
+public:
+   /** The type of a row id and its row. */
+   typedef std::pair<const row_id, row_value> value_type;
+
+   /** The type for sizes and slot numbers. */
+   typedef std::uint64_t size_type;
+
+   /**
+    * The number of row slots in a chunk. Must be a power of two.
+    */
+   static const size_type k_rows_per_chunk = 1024;
+
+private:
+   /** A slot, which may hold a row. */
+   typedef struct slot
+   {
+      // Set if the slot holds a row.
+      bool used;
+
+      // Space for the row.
+      typename std::aligned_storage<sizeof(value_type),
+            alignof(value_type)>::type storage;
+
+      value_type* get()
+      {
+         return static_cast<value_type*>(static_cast<void*>(&storage));
+      }
+
+   } slot_type;
+
+   /** A chunk of consecutive slots. */
+   typedef struct chunk
+   {
+      // The slots.
+      slot_type slots[k_rows_per_chunk];
+
+      // The number of slots in use.
+      size_type live;
+
+   } chunk_type;
+
+   /** The directory of chunks. Empty chunks are freed. */
+   typedef std::vector<std::unique_ptr<chunk_type>> directory_type;
+
+   /** The chunks. */
+   directory_type directory;
+
+   /** One past the highest slot ever used. */
+   size_type limit;
+
+   /** The number of rows. */
+   size_type count;
+
+   /**
+    * Provides the slot for a row id, or nullptr if its chunk does not
+    * exist.
+    */
+   slot_type* find_slot(size_type index)
+   {
+      auto c = index / k_rows_per_chunk;
+      if (c >= directory.size() || !directory[c])
+         {
+            return nullptr;
+         }
+
+      return &directory[c]->slots[index % k_rows_per_chunk];
+   }
+
+   /**
+    * Finds the first used slot at or after 'index', or limit if there is
+    * none.
+    */
+   size_type next_used(size_type index)
+   {
+      while (index < limit)
+         {
+            auto& c = directory[index / k_rows_per_chunk];
+            if (!c)
+               {
+                  // Skip the whole chunk, there is nothing in it.
+                  index += k_rows_per_chunk - (index % k_rows_per_chunk);
+                  continue;
+               }
+
+            if (c->slots[index % k_rows_per_chunk].used)
+               {
+                  return index;
+               }
+
+            ++index;
+         }
+
+      return limit;
+   }
+
+public:
+   /**
+    * Walks the rows in row id order.
+    */
+   class iterator: public std::iterator<std::forward_iterator_tag,
+         value_type>
+   {
+      /** The store we walk. */
+      row_store* store;
+
+      /** The slot we point to. */
+      size_type index;
+
+      friend class row_store;
+
+      iterator(row_store* _store, size_type _index) :
+            store(_store), index(_index)
+      {
+      }
+
+   public:
+      iterator() :
+            store(nullptr), index(0)
+      {
+      }
+
+      value_type& operator*() const
+      {
+         return *store->find_slot(index)->get();
+      }
+
+      value_type* operator->() const
+      {
+         return store->find_slot(index)->get();
+      }
+
+      iterator& operator++()
+      {
+         index = store->next_used(index + 1);
+         return *this;
+      }
+
+      iterator operator++(int)
+      {
+         iterator i = *this;
+         ++(*this);
+         return i;
+      }
+
+      /**
+       * Indicates whether the row we point to is still in the store. An
+       * iterator may be moved on from an erased row, but not read.
+       */
+      bool live() const
+      {
+         auto s = store->find_slot(index);
+         return s != nullptr && s->used;
+      }
+
+      bool operator==(const iterator& o) const
+      {
+         return index == o.index && store == o.store;
+      }
+
+      bool operator!=(const iterator& o) const
+      {
+         return !(*this == o);
+      }
+   };
+
+   row_store() :
+         limit(0), count(0)
+   {
+   }
+
+   // Rows are stored in place and handed out by reference.
+   row_store(const row_store&) = delete;
+   row_store& operator=(const row_store&) = delete;
+
+   ~row_store()
+   {
+      for (auto& c : directory)
+         {
+            if (!c)
+               {
+                  continue;
+               }
+
+            for (auto& s : c->slots)
+               {
+                  if (s.used)
+                     {
+                        s.get()->~value_type();
+                     }
+               }
+         }
+   }
+
+   /**
+    * The number of rows in the store.
+    */
+   size_type size() const
+   {
+      return count;
+   }
+
+   /**
+    * Provides an iterator pointing to the row with the lowest id.
+    */
+   iterator begin()
+   {
+      return iterator(this, next_used(0));
+   }
+
+   /**
+    * Provides an iterator pointing just past the row with the highest id.
+    */
+   iterator end()
+   {
+      return iterator(this, limit);
+   }
+
+   /**
+    * Finds a row.
+    *
+    * @param rid: The id of the row.
+    *
+    * @returns: An iterator pointing to the row, or end() if there is no
+    *           such row.
+    */
+   iterator find(const row_id& rid)
+   {
+      auto index = rid.to_uint64();
+      auto s = find_slot(index);
+
+      if (s == nullptr || !s->used)
+         {
+            return end();
+         }
+
+      return iterator(this, index);
+   }
+
+   /**
+    * Finds the first row whose id is at least 'rid'.
+    *
+    * @returns: An iterator pointing to the row, or end() if there is no
+    *           such row.
+    */
+   iterator lower_bound(const row_id& rid)
+   {
+      return iterator(this, next_used(rid.to_uint64()));
+   }
+
+   /**
+    * Adds a row.
+    *
+    * @param rid: The id of the row.
+    * @param row: The row, which is moved into place.
+    *
+    * @returns: A pair of (iterator, result). The result is false, and the
+    *           iterator points to the existing row, if the id is in use.
+    */
+   std::pair<iterator, bool> insert(const row_id& rid, row_value row)
+   {
+      auto index = rid.to_uint64();
+      auto c = index / k_rows_per_chunk;
+
+      if (c >= directory.size())
+         {
+            directory.resize(c + 1);
+         }
+
+      if (!directory[c])
+         {
+            directory[c] = std::unique_ptr<chunk_type>(new chunk_type());
+         }
+
+      auto& s = directory[c]->slots[index % k_rows_per_chunk];
+      if (s.used)
+         {
+            return std::make_pair(iterator(this, index), false);
+         }
+
+      new (&s.storage) value_type(rid, std::move(row));
+      s.used = true;
+
+      ++directory[c]->live;
+      ++count;
+
+      if (index >= limit)
+         {
+            limit = index + 1;
+         }
+
+      return std::make_pair(iterator(this, index), true);
+   }
+
+   /**
+    * Removes a row. Iterators pointing to it become invalid, all others
+    * stay valid.
+    *
+    * @param rid: The id of the row.
+    *
+    * @returns: true if the row was removed, false if there was no such
+    *           row.
+    */
+   bool erase(const row_id& rid)
+   {
+      auto index = rid.to_uint64();
+      auto s = find_slot(index);
+
+      if (s == nullptr || !s->used)
+         {
+            return false;
+         }
+
+      s->get()->~value_type();
+      s->used = false;
+      --count;
+
+      // Give the chunk back once it is empty, unless new rows may still
+      // be added to it.
+      auto c = index / k_rows_per_chunk;
+      if (--directory[c]->live == 0 && c != (limit - 1) / k_rows_per_chunk)
+         {
+            directory[c].reset();
+         }
+
+      return true;
+   }
+};
+
+} // namespace cell
+} // namespace lattice
+
+#endif // __LATTICE_CELL_ROW_STORE_H__
@@ -5,6 +5,8 @@
 #include <utility>
 #include <vector>
 
+#include <cell/cpp/commit_clock.h>
+#include <cell/cpp/oid_slab.h>
 #include <cell/cpp/transaction_id.h>
 #include <cell/cpp/page.h>
 
@@ -29,24 +31,66 @@ private:
     * writes by other transaction. */
    transaction_id transaction_lock_id;
 
+   /** When the transaction that wrote this row committed, or k_never if
+    * it has not. Until then the row is only visible to the transaction
+    * that wrote it.
+    */
+   commit_timestamp_type committed_at;
+
    /** This field does double duty: if the row is outright deleted, this serves
     * as the tombstone marker so that the row can be garbage collected. If
     * the row is updated, it tells us at which point the row is no longer
-    * visible. Once all transactions <= transaction_deleted_id have committed,
-    * this row can be removed from the data store.
+    * visible. It is the time the deleting transaction committed, or k_never.
+    * Once every transaction that began before then has finished, this row
+    * can be removed from the data store.
     */
-   transaction_id transaction_deleted_id;
+   commit_timestamp_type deleted_at;
+
+   /** The array of column ids. */
+   page::object_id_type *column_oids;
+
+   /** The slab column_oids came from, or nullptr if it came from the
+    * heap. */
+   oid_slab *slab;
 
    /** The number of columns in the row. */
    column_count_type number_of_columns;
 
-   /** Indicates if the row was actually committed. If not, this row is
-    * only visible to the transaction that wrote it.
+   /** Set once the transaction holding the lock has replaced the row
+    * with a new version. The row is deleted when that transaction
+    * commits, but it stops seeing the row straight away. */
+   bool replaced;
+
+   /**
+    * Allocates the column id array, from the slab if there is one.
     */
-   bool committed;
+   void allocate_oids()
+   {
+      column_oids = slab != nullptr ?
+            slab->allocate() : new page::object_id_type[number_of_columns];
+   }
 
-   /** The array of column ids. */
-   page::object_id_type *column_oids;
+   /**
+    * Gives back the column id array.
+    */
+   void release_oids()
+   {
+      if (column_oids == nullptr)
+         {
+            return;
+         }
+
+      if (slab != nullptr)
+         {
+            slab->release(column_oids);
+         }
+      else
+         {
+            delete[] column_oids;
+         }
+
+      column_oids = nullptr;
+   }
 
 public:
    /**
@@ -54,18 +98,25 @@ public:
     *
     * @param _write_id: The transaction writing this row.
     * @param init: The data to initialize the row with.
+    * @param _slab: Where to allocate the column ids from. Its width must
+    *               be at least init.size(). If nullptr, they are
+    *               allocated from the heap.
     *
     * @note: The row is created in a locked state. It will
     * be unlocked when commit() is called.
     */
    row_value(transaction_id _write_id,
-         const std::vector<page::object_id_type>& init) :
+         const std::vector<page::object_id_type>& init,
+         oid_slab *_slab = nullptr) :
             transaction_write_id(_write_id),
             transaction_lock_id(_write_id),
+            committed_at(commit_clock::k_never),
+            deleted_at(commit_clock::k_never),
+            slab(_slab),
             number_of_columns(init.size()),
-            committed(false)
+            replaced(false)
    {
-      column_oids = new page::object_id_type[number_of_columns];
+      allocate_oids();
       for (auto i = 0; i < number_of_columns; ++i)
          {
             column_oids[i] = init[i];
@@ -74,27 +125,30 @@ public:
    ;
 
    /**
-    * Copy constructor - duplicates the tuple.
+    * Copy constructor - duplicates the tuple, in the same slab.
     */
    row_value(const row_value& o) :
             transaction_write_id(o.transaction_write_id),
             transaction_lock_id(o.transaction_lock_id),
+            committed_at(o.committed_at),
+            deleted_at(o.deleted_at),
+            slab(o.slab),
             number_of_columns(o.number_of_columns),
-            committed(o.committed)
+            replaced(o.replaced)
    {
-      column_oids = new page::object_id_type[number_of_columns];
+      allocate_oids();
       for (auto i = 0; i < number_of_columns; ++i)
          {
             column_oids[i] = o.column_oids[i];
          }
    }
 
+   // Rows are copied or moved into place, never assigned.
+   row_value& operator=(const row_value&) = delete;
+
    ~row_value()
    {
-      if (column_oids != nullptr)
-         {
-            delete[] column_oids;
-         }
+      release_oids();
    }
 
    /**
@@ -111,6 +165,17 @@ public:
       return 0;
    }
 
+   /**
+    * Sets the oid of a column.
+    */
+   void set_column(column_count_type idx, page::object_id_type oid)
+   {
+      if (idx < number_of_columns)
+         {
+            column_oids[idx] = oid;
+         }
+   }
+
    /**
     * For every bit where the 'present' vector is false, it copies the column
     * information from the 'o' row.
@@ -145,14 +210,15 @@ public:
     * Marks this row as deleted.
     *
     * @param: txn_id: The transaction id that deleted the row.
+    * @param: ts: The time the deleting transaction committed.
     *
     * @returns: true if the transaction committed, false otherwise.
     */
-   bool remove(const transaction_id& txn_id)
+   bool remove(const transaction_id& txn_id, commit_timestamp_type ts)
    {
-      if (is_locked(txn_id))
+      if (!is_locked(txn_id))
          {
-            transaction_deleted_id = txn_id;
+            deleted_at = ts;
             return true;
          }
 
@@ -163,17 +229,22 @@ public:
     * Marks this row as committed, and updates the write id.
     *
     * @param: txn_id: The transaction id to commit.
+    * @param: ts: The time the transaction committed. A row that is
+    *             already committed keeps its time.
     *
     * @returns: true if the transaction committed, false otherwise.
     *
     * @note: Automatically unlocks the rows.
     */
-   bool commit(const transaction_id& txn_id)
+   bool commit(const transaction_id& txn_id, commit_timestamp_type ts)
    {
       if (unlock(txn_id))
          {
+            if (committed_at == commit_clock::k_never)
+               {
+                  committed_at = ts;
+               }
 
-            committed = true;
             transaction_write_id = transaction_lock_id;
             return true;
          }
@@ -187,25 +258,31 @@ public:
     * as it existed when the transaction began.
     *
     * @param txn_id: The transaction id requested.
+    * @param snapshot: The time the transaction began.
     *
     * @returns: true if the row is visible to txn_id, false otherwise.
     */
-   bool is_snapshot_visible(const transaction_id& txn_id) const
+   bool is_snapshot_visible(const transaction_id& txn_id,
+         commit_timestamp_type snapshot) const
    {
-      using namespace std::rel_ops;
+      // The transaction replacing the row sees the new version instead.
+      if (replaced && transaction_lock_id == txn_id)
+         {
+            return false;
+         }
 
-      // If the row is committed its write id must be
-      // <= the current transaction id, AND the row
-      // must not be deleted, or must have been deleted
-      // in a transaction > the current transaction id.
-      if (committed)
+      // A committed row is visible if it was committed by the time the
+      // snapshot was taken, and not deleted until after. Rows that are
+      // not committed have a commit time of k_never, which is after
+      // every snapshot.
+      if (committed_at <= snapshot)
          {
-            return transaction_write_id <= txn_id
-                  && (transaction_deleted_id.empty()
-                        || transaction_deleted_id > txn_id);
+            return snapshot < deleted_at;
          }
 
-      return transaction_lock_id == txn_id && transaction_deleted_id.empty();
+      return committed_at == commit_clock::k_never
+            && transaction_lock_id == txn_id
+            && deleted_at == commit_clock::k_never;
    }
 
    /**
@@ -219,19 +296,22 @@ public:
     */
    bool is_visible(const transaction_id& txn_id) const
    {
-      using namespace std::rel_ops;
-
-      // If the row is committed its write id must be
-      // <= the current transaction id, AND the row
-      // must not be deleted.
-      if (committed)
-         {
-            return transaction_write_id <= txn_id
-                  && transaction_deleted_id.empty();
-
-         }
+      return is_snapshot_visible(txn_id, commit_clock::k_latest);
+   }
 
-      return transaction_lock_id == txn_id && transaction_deleted_id.empty();
+   /**
+    * Determines if this row can be garbage collected: it was deleted
+    * before every active transaction began, so no one can see it any
+    * more.
+    *
+    * @param horizon: The time the oldest transaction still running
+    *                 began.
+    *
+    * @returns: true if the row can be removed, false otherwise.
+    */
+   bool is_reclaimable(commit_timestamp_type horizon) const
+   {
+      return deleted_at <= horizon;
    }
 
    /**
@@ -292,12 +372,32 @@ public:
       if (transaction_lock_id == txn_id)
          {
             transaction_lock_id.reset();
+            replaced = false;
             return true;
          }
 
       return false;
    }
 
+   /**
+    * Records that the transaction holding the lock has written a new
+    * version of this row.
+    *
+    * @param txn_id: The transaction that wrote the new version.
+    *
+    * @returns: true if txn_id holds the lock, false otherwise.
+    */
+   bool replace(const transaction_id& txn_id)
+   {
+      if (!(transaction_lock_id == txn_id))
+         {
+            return false;
+         }
+
+      replaced = true;
+      return true;
+   }
+
    bool operator==(const row_value& o) const
    {
       for (auto i = 0; i < number_of_columns; ++i)
@@ -330,8 +430,11 @@ public:
    row_value(row_value&& o) :
    transaction_write_id(o.transaction_write_id),
    transaction_lock_id(o.transaction_lock_id),
+   committed_at(o.committed_at),
+   deleted_at(o.deleted_at),
+   slab(o.slab),
    number_of_columns(o.number_of_columns),
-   committed(o.committed)
+   replaced(o.replaced)
       {
          column_oids = o.column_oids;
          o.column_oids = nullptr;
@@ -5,7 +5,10 @@
 #include <memory>
 #include <string>
 
+#include <cell/cpp/compare_kernels.h>
 #include <cell/cpp/data_value.h>
+#include <cell/cpp/dictionary_page.h>
+#include <cell/cpp/fixed_page.h>
 #include <cell/cpp/predicate.h>
 
 namespace lattice
@@ -15,10 +18,133 @@ namespace cell
 
 class scalar_predicate: public predicate
 {
+public:
+  /**
+   * How the column is compared with the predicate's value.
+   */
+  enum class comparison
+  {
+    EQUAL,
+    NOT_EQUAL,
+    LESS,
+    LESS_EQUAL,
+    GREATER,
+    GREATER_EQUAL,
+
+    // value <= column <= upper
+    BETWEEN
+  };
+
+private:
   data_value value;
 
+  /** The upper bound for comparison::BETWEEN. */
+  data_value upper;
+
+  comparison op;
+
+  /**
+   * The kernel comparison for our comparison.
+   */
+  compare_op get_compare_op() const
+  {
+    switch (op)
+      {
+      case comparison::NOT_EQUAL:
+        return compare_op::NOT_EQUAL;
+      case comparison::LESS:
+        return compare_op::LESS;
+      case comparison::LESS_EQUAL:
+        return compare_op::LESS_EQUAL;
+      case comparison::GREATER:
+        return compare_op::GREATER;
+      case comparison::GREATER_EQUAL:
+        return compare_op::GREATER_EQUAL;
+      case comparison::BETWEEN:
+        return compare_op::BETWEEN;
+      default:
+        return compare_op::EQUAL;
+      }
+  }
+
+  /**
+   * Selects the objects of a fixed width page that satisfy the
+   * comparison, running the comparison kernels over each atom.
+   *
+   * @param low: The value, or the lower bound for BETWEEN.
+   * @param high: The upper bound for BETWEEN.
+   *
+   * @returns: false if the page does not store values of type T.
+   */
+  template<typename T>
+  bool select_values(page& p, page::object_id_type first,
+      selection_bitmap& selection, T low, T high)
+  {
+    auto fp = dynamic_cast<fixed_page<T>*>(&p);
+    if (fp == nullptr)
+      {
+        return false;
+      }
+
+    auto kernel_op = get_compare_op();
+    selection_bitmap::word_type mask[fixed_page<T>::k_slots_per_atom
+        / selection_bitmap::k_word_bits];
+
+    selection.clear();
+    fp->scan(first, selection.size(), this,
+        [&](page::size_type position, const T* values,
+            const page::reference_count_type* references, page::size_type n)
+          {
+            compare_values(kernel_op, values, references, n, low, high, mask);
+            selection.merge(position, mask, n);
+          });
+
+    return true;
+  }
+
+  /**
+   * Selects the objects of a dictionary page that are (not) equal to
+   * the value, by comparing codes.
+   *
+   * @returns: false if the comparison cannot be done on codes.
+   */
+  bool select_codes(dictionary_page& p, page::object_id_type first,
+      selection_bitmap& selection)
+  {
+    if (value.get_type() != column::data_type::varchar
+        || (op != comparison::EQUAL && op != comparison::NOT_EQUAL))
+      {
+        return false;
+      }
+
+    bool found;
+    dictionary_page::code_type code;
+
+    std::tie(found, code) = p.find_code(*value.raw_string_value());
+    if (!found)
+      {
+        // No object has the value.
+        code = p.get_dictionary_size();
+      }
+
+    // Codes carry no order, so the zone maps are no help here.
+    if (op == comparison::EQUAL)
+      {
+        select_objects(p.get_codes(), first, selection, nullptr,
+            [code](const dictionary_page::code_type& x) { return x == code; });
+      }
+    else
+      {
+        select_objects(p.get_codes(), first, selection, nullptr,
+            [code](const dictionary_page::code_type& x) { return x != code; });
+      }
+
+    return true;
+  }
+
 public:
-  scalar_predicate()
+  scalar_predicate() :
+      op(comparison::EQUAL)
   {
   }
 
@@ -27,15 +153,136 @@ public:
     value.set_value(t, v);
   }
 
+  /**
+   * Selects the columns between two values, inclusive, by setting the
+   * value, the upper bound and comparison::BETWEEN.
+   */
+  template<typename T>
+  void set_range(column::data_type t, const T& low, const T& high)
+  {
+    value.set_value(t, low);
+    upper.set_value(t, high);
+    op = comparison::BETWEEN;
+  }
+
+  /**
+   * Sets how the column is compared with the value. The default is
+   * comparison::EQUAL.
+   */
+  void set_comparison(comparison c)
+  {
+    op = c;
+  }
+
   virtual int cmp(page_cursor& cursor)
   {
     return value.cmp(cursor);
   }
 
+  /**
+   * Indicates whether the value at the cursor satisfies
+   * 'column <op> value'.
+   */
   virtual bool contains(page_cursor& cursor)
   {
+    // cmp() orders our value against the column, so it is reversed here.
+    auto r = value.cmp(cursor);
+
+    switch (op)
+      {
+      case comparison::EQUAL:
+        return r == 0;
+      case comparison::NOT_EQUAL:
+        return r != 0;
+      case comparison::LESS:
+        return r > 0;
+      case comparison::LESS_EQUAL:
+        return r >= 0;
+      case comparison::GREATER:
+        return r < 0;
+      case comparison::GREATER_EQUAL:
+        return r <= 0;
+      case comparison::BETWEEN:
+        return r <= 0 && upper.cmp(cursor) >= 0;
+      }
+
     return false;
   }
+
+  virtual bool may_match(const data_value& low, const data_value& high)
+  {
+    // Values of other types are not comparable, assume they match.
+    if (low.get_type() != value.get_type())
+      {
+        return true;
+      }
+
+    switch (op)
+      {
+      case comparison::EQUAL:
+        return !(value < low) && !(high < value);
+      case comparison::NOT_EQUAL:
+        return !(low == value && high == value);
+      case comparison::LESS:
+        return low < value;
+      case comparison::LESS_EQUAL:
+        return !(value < low);
+      case comparison::GREATER:
+        return value < high;
+      case comparison::GREATER_EQUAL:
+        return !(high < value);
+      case comparison::BETWEEN:
+        return !(high < value) && !(upper < low);
+      }
+
+    return true;
+  }
+
+  virtual void select(page& p, page::object_id_type first,
+      selection_bitmap& selection)
+  {
+    bool done = false;
+
+    // Only BETWEEN has an upper bound, the kernels ignore it otherwise.
+    auto& high = op == comparison::BETWEEN ? upper : value;
+
+    switch (value.get_type())
+      {
+      case column::data_type::smallint:
+        done = select_values(p, first, selection, value.raw_int16_value(),
+            high.raw_int16_value());
+      break;
+      case column::data_type::integer:
+        done = select_values(p, first, selection, value.raw_int32_value(),
+            high.raw_int32_value());
+      break;
+      case column::data_type::bigint:
+        done = select_values(p, first, selection, value.raw_int64_value(),
+            high.raw_int64_value());
+      break;
+      case column::data_type::real:
+        done = select_values(p, first, selection, value.raw_float_value(),
+            high.raw_float_value());
+      break;
+      case column::data_type::double_precision:
+        done = select_values(p, first, selection, value.raw_double_value(),
+            high.raw_double_value());
+      break;
+      case column::data_type::varchar:
+        if (p.get_dictionary_page() != nullptr)
+          {
+            done = select_codes(*p.get_dictionary_page(), first, selection);
+          }
+      break;
+      default:
+      break;
+      }
+
+    if (!done)
+      {
+        predicate::select(p, first, selection);
+      }
+  }
 };
 
 
@@ -0,0 +1,285 @@
+#ifndef __LATTICE_CELL_SELECTION_H__
+#define __LATTICE_CELL_SELECTION_H__
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace lattice {
+namespace cell {
+
+/**
+ * The result of evaluating a predicate over a block of objects. Bit i is
+ * set when the i'th object of the block was selected.
+ *
+ * Bitmaps of the same size can be combined with &= and |= to evaluate
+ * conjunctions and disjunctions a word at a time.
+ */
+class selection_bitmap
+{
+public:
+	/** The type bits are stored in. */
+	typedef std::uint64_t word_type;
+
+	/** The type for parameters indicating size. */
+	typedef std::size_t size_type;
+
+	/** A list of selected positions. */
+	typedef std::vector<std::uint32_t> selection_vector_type;
+
+	/** The number of bits in a word. */
+	static const size_type k_word_bits = 64;
+
+private:
+	/** The bits. Bits past the end of the last word are always zero. */
+	std::vector<word_type> words;
+
+	/** The number of objects in the block. */
+	size_type bits;
+
+	/**
+	 * Clears the unused bits of the last word.
+	 */
+	void trim()
+	{
+		if (bits % k_word_bits != 0)
+			{
+				words.back() &= (word_type(1) << (bits % k_word_bits)) - 1;
+			}
+	}
+
+public:
+	selection_bitmap() :
+			bits(0)
+	{
+	}
+
+	selection_bitmap(size_type n) :
+			words((n + k_word_bits - 1) / k_word_bits, 0), bits(n)
+	{
+	}
+
+	/**
+	 * The number of objects in the block.
+	 */
+	size_type size() const
+	{
+		return bits;
+	}
+
+	/**
+	 * Changes the size of the block and clears every bit.
+	 */
+	void resize(size_type n)
+	{
+		bits = n;
+		words.assign((n + k_word_bits - 1) / k_word_bits, 0);
+	}
+
+	/**
+	 * Clears every bit.
+	 */
+	void clear()
+	{
+		std::fill(words.begin(), words.end(), 0);
+	}
+
+	/**
+	 * Sets every bit.
+	 */
+	void set_all()
+	{
+		std::fill(words.begin(), words.end(), ~word_type(0));
+		if (!words.empty())
+			{
+				trim();
+			}
+	}
+
+	/**
+	 * Selects a position.
+	 */
+	void set(size_type position)
+	{
+		words[position / k_word_bits] |= word_type(1)
+				<< (position % k_word_bits);
+	}
+
+	/**
+	 * Deselects a position.
+	 */
+	void reset(size_type position)
+	{
+		words[position / k_word_bits] &= ~(word_type(1)
+				<< (position % k_word_bits));
+	}
+
+	/**
+	 * Indicates whether a position is selected.
+	 */
+	bool test(size_type position) const
+	{
+		return (words[position / k_word_bits] >> (position % k_word_bits)) & 1;
+	}
+
+	/**
+	 * The number of selected positions.
+	 */
+	size_type count() const
+	{
+		size_type n = 0;
+		for (auto word : words)
+			{
+				n += __builtin_popcountll(word);
+			}
+
+		return n;
+	}
+
+	/**
+	 * Indicates whether nothing is selected.
+	 */
+	bool none() const
+	{
+		for (auto word : words)
+			{
+				if (word != 0)
+					{
+						return false;
+					}
+			}
+
+		return true;
+	}
+
+	/**
+	 * Selects the positions selected in both bitmaps.
+	 */
+	selection_bitmap& operator&=(const selection_bitmap& o)
+	{
+		for (size_type i = 0; i < words.size(); ++i)
+			{
+				words[i] &= o.words[i];
+			}
+
+		return *this;
+	}
+
+	/**
+	 * Selects the positions selected in either bitmap.
+	 */
+	selection_bitmap& operator|=(const selection_bitmap& o)
+	{
+		for (size_type i = 0; i < words.size(); ++i)
+			{
+				words[i] |= o.words[i];
+			}
+
+		return *this;
+	}
+
+	/**
+	 * Selects exactly the positions that are not selected.
+	 */
+	void flip()
+	{
+		for (auto& word : words)
+			{
+				word = ~word;
+			}
+
+		if (!words.empty())
+			{
+				trim();
+			}
+	}
+
+	/**
+	 * Runs a test over an array of values, selecting position
+	 * 'position + i' when 'references[i]' is non-zero and 'test(values[i])'
+	 * is true. Positions that fail are left as they are.
+	 *
+	 * @param position: The position of the first value.
+	 * @param values: The values to test.
+	 * @param references: The reference count of each value. Zero means
+	 *                    there is no object.
+	 * @param n: The number of values.
+	 * @param test: The test to run.
+	 */
+	template<typename T, typename R, typename Test>
+	void select(size_type position, const T* values, const R* references,
+			size_type n, Test test)
+	{
+		size_type i = 0;
+
+		while (i < n)
+			{
+				// Build up one word at a time, without branches.
+				auto index = (position + i) / k_word_bits;
+				auto shift = (position + i) % k_word_bits;
+				auto end = std::min(n, i + k_word_bits - shift);
+
+				word_type word = 0;
+				for (; i < end; ++i, ++shift)
+					{
+						word_type hit = (references[i] != 0) & test(values[i]);
+						word |= hit << shift;
+					}
+
+				words[index] |= word;
+			}
+	}
+
+	/**
+	 * Selects the positions set in a bitmask, starting at 'position'.
+	 * Positions that are not set are left as they are.
+	 *
+	 * @param position: The position of bit 0 of the mask.
+	 * @param mask: The bits to select, with (n + 63) / 64 words.
+	 * @param n: The number of bits in the mask.
+	 */
+	void merge(size_type position, const word_type* mask, size_type n)
+	{
+		auto index = position / k_word_bits;
+		auto shift = position % k_word_bits;
+		auto last = (position + n + k_word_bits - 1) / k_word_bits;
+
+		for (size_type i = 0; i * k_word_bits < n; ++i)
+			{
+				auto word = mask[i];
+				if (i * k_word_bits + k_word_bits > n)
+					{
+						word &= (word_type(1) << (n % k_word_bits)) - 1;
+					}
+
+				words[index + i] |= word << shift;
+				if (shift != 0 && index + i + 1 < last)
+					{
+						words[index + i + 1] |= word >> (k_word_bits - shift);
+					}
+			}
+	}
+
+	/**
+	 * Lists the selected positions.
+	 *
+	 * @param out: The positions are appended to this list.
+	 */
+	void to_vector(selection_vector_type& out) const
+	{
+		for (size_type i = 0; i < words.size(); ++i)
+			{
+				auto word = words[i];
+				while (word != 0)
+					{
+						out.push_back(i * k_word_bits + __builtin_ctzll(word));
+						word &= word - 1;
+					}
+			}
+	}
+};
+
+} // end namespace cell
+} // end namespace lattice
+
+#endif //__LATTICE_CELL_SELECTION_H__
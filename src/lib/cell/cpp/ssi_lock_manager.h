@@ -28,8 +28,31 @@ class ssi_lock_manager
    typedef std::unordered_map<transaction_id, dependency_set_type,
          transaction_id_hash> dependency_map_type;
 
+   /** Maps a table to the transactions holding a read lock on all of it. */
+   typedef std::unordered_map<page::object_id_type, dependency_set_type> table_lock_map_type;
+
+public:
    typedef std::size_t size_type;
 
+   /**
+    * The default number of row range segments a transaction may hold
+    * on a table before they are swapped for a lock on the whole table.
+    */
+   static const size_type k_escalation_threshold = 1024;
+
+private:
+   /**
+    * Holds the table locks. A table lock covers every row of the table,
+    * so readers that scan a table take one instead of a lock per row.
+    */
+   table_lock_map_type table_locks;
+
+   /**
+    * The number of row range segments a transaction may hold on a table
+    * before they are escalated to a table lock.
+    */
+   size_type escalation_threshold;
+
    /**
     * Holds the range locks so that we can determine when
     * a read-after-write conflict has occurred.
@@ -38,10 +61,17 @@ class ssi_lock_manager
 
    /**
     * Tracks read-before-write conflicts to locate
-    * dangerous structures.
+    * dangerous structures. Maps each reader to the writers it has an
+    * rw-antidependency on (its out conflicts).
     */
    dependency_map_type dep_map;
 
+   /**
+    * The same conflicts the other way around. Maps each writer to the
+    * readers with an rw-antidependency on it (its in conflicts).
+    */
+   dependency_map_type rev_dep_map;
+
    /**
     * Tracks concurrent transactions so that we know, for example T1 and T2
     * ran at the same time. Once all transactions from some slice of time
@@ -109,7 +139,10 @@ class ssi_lock_manager
                   txn_map.second.clear();
                }
 
+            table_locks.clear();
+
             dep_map.clear();
+            rev_dep_map.clear();
             return;
          }
 
@@ -149,6 +182,11 @@ class ssi_lock_manager
                {
                   pos.second.erase(empty_tid);
                }
+
+            for (auto& pos : table_locks)
+               {
+                  pos.second.erase(empty_tid);
+               }
          }
    }
 
@@ -171,6 +209,28 @@ class ssi_lock_manager
 
       auto& dep_set = pos->second;
       dep_set.insert(writer);
+
+      rev_dep_map[writer].insert(reader);
+   }
+
+   /**
+    * Removes 'tid' from the dependency set of 'key', and drops the set
+    * once it is empty.
+    */
+   static void remove_dependency(dependency_map_type& map,
+         const transaction_id& key, const transaction_id& tid)
+   {
+      auto pos = map.find(key);
+      if (pos == map.end())
+         {
+            return;
+         }
+
+      pos->second.erase(tid);
+      if (pos->second.empty())
+         {
+            map.erase(pos);
+         }
    }
 
    /**
@@ -186,21 +246,18 @@ class ssi_lock_manager
     */
    transaction_id get_rw_dependency(const transaction_id& tid)
    {
-      for (auto pos = dep_map.begin(); pos != dep_map.end(); ++pos)
+      auto pos = rev_dep_map.find(tid);
+      if (pos == rev_dep_map.end())
          {
-            // Don't bother checking if we are looking in our
-            // own bucket.
-            if (pos->first == tid)
-               {
-                  continue;
-               }
+            return transaction_id();
+         }
 
-            auto& s = pos->second;
-            if (s.find(tid) != s.end())
+      for (auto& reader : pos->second)
+         {
+            // Don't bother with our own reads.
+            if (!(reader == tid))
                {
-                  // The transaction at pos->first has an rw dependency on
-                  // tid.
-                  return pos->first;
+                  return reader;
                }
          }
 
@@ -223,12 +280,55 @@ class ssi_lock_manager
       // Remove all dependencies to this transaction as a reader (since
       // we no longer care what it has read), but leave all references
       // to it as a writer (since other readers may still care.)
-      dep_map.erase(tid);
+      auto pos = dep_map.find(tid);
+      if (pos != dep_map.end())
+         {
+            for (auto& writer : pos->second)
+               {
+                  remove_dependency(rev_dep_map, writer, tid);
+               }
+
+            dep_map.erase(pos);
+         }
+
+      // An aborted transaction never wrote anything, so no one depends
+      // on it.
+      auto rev_pos = abort ? rev_dep_map.find(tid) : rev_dep_map.end();
+      if (rev_pos != rev_dep_map.end())
+         {
+            for (auto& reader : rev_pos->second)
+               {
+                  remove_dependency(dep_map, reader, tid);
+               }
+
+            rev_dep_map.erase(rev_pos);
+         }
 
       // Remove from active transactions.
       del_transaction(tid);
    }
+   /**
+    * Determines if a transaction holds a read lock on a whole table.
+    */
+   bool holds_table_lock(const transaction_id& tid,
+         page::object_id_type table_id) const
+   {
+      auto pos = table_locks.find(table_id);
+      return pos != table_locks.end()
+            && pos->second.find(tid) != pos->second.end();
+   }
+
 public:
+   /**
+    * @param _escalation_threshold: The number of row range segments a
+    *                               transaction may hold on a table before
+    *                               they are escalated to a table lock.
+    */
+   ssi_lock_manager(size_type _escalation_threshold = k_escalation_threshold) :
+         escalation_threshold(_escalation_threshold)
+   {
+   }
+
    /**
     * Provides the number of writer nodes that have outstanding reader
     * dependencies. Note that some of these writers may have committed
@@ -239,6 +339,38 @@ public:
       return dep_map.size();
    }
 
+   /**
+    * Indicates whether some other transaction has an rw-antidependency
+    * on 'tid', that is, read something 'tid' then wrote.
+    */
+   bool has_in_conflict(const transaction_id& tid)
+   {
+      return !get_rw_dependency(tid).empty();
+   }
+
+   /**
+    * Indicates whether 'tid' has an rw-antidependency on some other
+    * transaction, that is, read something it then wrote.
+    */
+   bool has_out_conflict(const transaction_id& tid)
+   {
+      auto pos = dep_map.find(tid);
+      if (pos == dep_map.end())
+         {
+            return false;
+         }
+
+      for (auto& writer : pos->second)
+         {
+            if (!(writer == tid))
+               {
+                  return true;
+               }
+         }
+
+      return false;
+   }
+
    /**
     * Tracks a read to a particular row in a particular table for some transaction.
     *
@@ -249,6 +381,12 @@ public:
    void track_read(const transaction_id& tid, page::object_id_type table_id,
          const row_id& rid)
    {
+      // A table lock already covers the row.
+      if (holds_table_lock(tid, table_id))
+         {
+            return;
+         }
+
       add_transaction(tid);
 
       // Find the table
@@ -271,6 +409,36 @@ public:
       // Add the row.
       auto& row_range = tid_pos->second;
       row_range.insert(rid);
+
+      // Too many scattered rows cost more to track than they are worth,
+      // swap them for a lock on the table.
+      if (row_range.size() > escalation_threshold)
+         {
+            txn_map.erase(tid_pos);
+            table_locks[table_id].insert(tid);
+         }
+   }
+
+   /**
+    * Tracks a read of a whole table for some transaction, as done by a
+    * scan. Rows read afterwards are not tracked one by one.
+    *
+    * @param tid: The transaction executing the read.
+    * @param table_id: The table being read.
+    */
+   void track_table_read(const transaction_id& tid,
+         page::object_id_type table_id)
+   {
+      add_transaction(tid);
+
+      // The table lock covers any rows already tracked.
+      auto table_pos = range_map.find(table_id);
+      if (table_pos != range_map.end())
+         {
+            table_pos->second.erase(tid);
+         }
+
+      table_locks[table_id].insert(tid);
    }
 
    /**
@@ -288,15 +456,29 @@ public:
    {
       add_transaction(tid);
 
+      bool result = false;
+
+      // Everyone who read the whole table read this row.
+      auto lock_pos = table_locks.find(table_id);
+      if (lock_pos != table_locks.end())
+         {
+            for (auto& reader : lock_pos->second)
+               {
+                  if (!(tid == reader))
+                     {
+                        add_rw_dependency(reader, tid);
+                        result = true;
+                     }
+               }
+         }
+
       // Find the table.
       auto table_pos = range_map.find(table_id);
       if (table_pos == range_map.end())
          {
-            return false;
+            return result;
          }
 
-      bool result = false;
-
       // Walk the transactions
       auto& txn_map = table_pos->second;
       for (auto &txn : txn_map)
@@ -344,9 +526,21 @@ public:
    std::tuple<transaction_id, bool> check_for_conflicts(
          const transaction_id& tid)
    {
-      auto t2 = get_rw_dependency(tid);
-      if (!t2.empty())
+      // Only the readers of tid need looking at, which are found without
+      // walking the rest of the graph.
+      auto pos = rev_dep_map.find(tid);
+      if (pos == rev_dep_map.end())
          {
+            return std::make_tuple(transaction_id(), false);
+         }
+
+      for (auto& t2 : pos->second)
+         {
+            if (t2 == tid)
+               {
+                  continue;
+               }
+
             // The transaction at t2 (T2) has an rw dependency on
             // tid (T3). Now check to see if T2 is an rw dependency of
             // some other transaction (T1).
@@ -1,12 +1,15 @@
 #include <cstdlib>
+#include <sstream>
 #include <cell/cpp/data_value.h>
+#include <cell/cpp/page_cursor.h>
 #include <cell/cpp/table.h>
 
 namespace lattice {
 namespace cell {
 
 static inline bool row_is_visible(const transaction_id& tid,
-      const table::row_type& row, isolation_level level)
+      const table::row_type& row, isolation_level level,
+      commit_timestamp_type snapshot)
 {
    // Check to see if the row is visible to this transaction.
    switch (level)
@@ -20,7 +23,7 @@ static inline bool row_is_visible(const transaction_id& tid,
 
       case isolation_level::REPEATABLE_READ:
       case isolation_level::SERIALIZABLE:
-         if (!row.is_snapshot_visible(tid))
+         if (!row.is_snapshot_visible(tid, snapshot))
             {
                return false;
             }
@@ -57,55 +60,317 @@ table::insert_code table::insert_row(const transaction_id& tid, row_id& rid,
                return insert_code::UNDER_FLOW;
             }
 
-         // Fetch the bits of information we need to write
-         // the data properly.
+         // The page knows how to decode its own data type, so
+         // there is no need to look at the column definition.
          auto p = column_data[i].get();
-         auto c = p->get_column_definition();
          auto oid = p->get_next_oid();
 
          row_data.push_back(oid);
 
-         switch (c->type)
+         auto bytes_written = p->insert_value(oid, buffer + offset,
+               buffer_size - offset);
+         if (bytes_written == 0)
             {
+               return insert_code::UNDER_FLOW;
+            }
 
-#include "row_insert_int_ops.h"
+         offset += bytes_written;
+      }
 
-            default:
-               return insert_code::UNKNOWN_DATA_TYPE;
+   // Insert the data into the row buffer.
+   rows.insert(rid, row_type(tid, row_data, &row_oids));
+
+   return insert_code::SUCCESS;
+}
+
+/**
+ * Checks that a column of a batch can be inserted into a table column.
+ */
+static table::insert_code check_batch_column(
+      const column_batch::column_type& c, const column* definition,
+      std::uint32_t rows)
+{
+   if (definition == nullptr || definition->type != c.type)
+      {
+         return table::insert_code::UNKNOWN_DATA_TYPE;
+      }
+
+   auto width = column_batch::fixed_width(c.type);
+   if (width != 0)
+      {
+         return c.values.size() < rows * width ?
+               table::insert_code::UNDER_FLOW : table::insert_code::SUCCESS;
+      }
+
+   if (c.offsets.size() <= rows)
+      {
+         return table::insert_code::UNDER_FLOW;
+      }
+
+   for (std::uint32_t r = 0; r < rows; ++r)
+      {
+         if (c.offsets[r + 1] < c.offsets[r])
+            {
+               return table::insert_code::UNDER_FLOW;
             }
       }
 
-   // Insert the data into the row buffer.
-   auto result = rows.insert(std::make_pair(rid, row_type(tid, row_data)));
+   return c.offsets[rows] <= c.values.size() ?
+         table::insert_code::SUCCESS : table::insert_code::UNDER_FLOW;
+}
+
+table::insert_code table::insert_rows(const transaction_id& tid,
+      const column_batch& batch, std::vector<row_id>& rids)
+{
+   auto row_count = batch.get_row_count();
+
+   // Check everything first, so that a bad batch inserts nothing.
+   for (auto& c : batch.get_columns())
+      {
+         auto code = check_batch_column(c,
+               get_column_definition(c.column_number), row_count);
+         if (code != insert_code::SUCCESS)
+            {
+               return code;
+            }
+      }
+
+   // The object id of each column of each row. Fixed width columns
+   // without nulls get a run of object ids, and only the first is kept.
+   std::vector<page::object_id_type> first_oid(number_of_columns, 0);
+   std::vector<std::vector<page::object_id_type>> oids(number_of_columns);
+
+   // Deletes the values written so far when a page runs out of data
+   // part way through, so that a failed batch leaves nothing behind.
+   auto discard = [&]()
+      {
+         for (unsigned int i = 0; i < number_of_columns; ++i)
+            {
+               auto p = column_data[i].get();
+               if (first_oid[i] != 0)
+                  {
+                     for (std::uint32_t r = 0; r < row_count; ++r)
+                        {
+                           p->delete_object(first_oid[i] + r);
+                        }
+                  }
+
+               for (auto oid : oids[i])
+                  {
+                     if (oid != 0)
+                        {
+                           p->delete_object(oid);
+                        }
+                  }
+            }
+
+         return insert_code::UNDER_FLOW;
+      };
+
+   for (auto& c : batch.get_columns())
+      {
+         auto p = column_data[c.column_number].get();
+         auto width = column_batch::fixed_width(c.type);
+         auto* values = static_cast<const std::uint8_t*>(
+               static_cast<const void*>(c.values.data()));
+
+         if (width != 0 && c.nulls.find_first_not_of('\0') == std::string::npos)
+            {
+               // Set first, since a page may have written some of the
+               // values before it failed.
+               auto first = p->get_next_oids(row_count);
+               first_oid[c.column_number] = first;
+               oids[c.column_number].clear();
+
+               if (p->insert_values(first, row_count, values, c.values.size())
+                     == 0 && row_count != 0)
+                  {
+                     return discard();
+                  }
+
+               continue;
+            }
+
+         auto& column_oids = oids[c.column_number];
+         column_oids.assign(row_count, 0);
+         first_oid[c.column_number] = 0;
+
+         // Varchars are stored with their length in front.
+         std::string value;
+         for (std::uint32_t r = 0; r < row_count; ++r)
+            {
+               if (column_batch::is_null(c, r))
+                  {
+                     continue;
+                  }
+
+               const std::uint8_t* data;
+               std::size_t size;
+               if (width != 0)
+                  {
+                     data = values + r * width;
+                     size = width;
+                  }
+               else
+                  {
+                     column_batch::offset_type length = c.offsets[r + 1]
+                           - c.offsets[r];
+                     value.assign(static_cast<const char*>(
+                           static_cast<const void*>(&length)), sizeof(length));
+                     value.append(c.values, c.offsets[r], length);
+
+                     data = static_cast<const std::uint8_t*>(
+                           static_cast<const void*>(value.data()));
+                     size = value.size();
+                  }
+
+               auto oid = p->get_next_oid();
+               if (p->insert_value(oid, data, size) == 0)
+                  {
+                     return discard();
+                  }
+
+               column_oids[r] = oid;
+            }
+      }
+
+   // Insert the rows into the row buffer.
+   auto rid = get_next_row_ids(row_count);
+   std::vector<page::object_id_type> row_data(number_of_columns);
+
+   rids.clear();
+   rids.reserve(row_count);
+
+   for (std::uint32_t r = 0; r < row_count; ++r)
+      {
+         for (unsigned int i = 0; i < number_of_columns; ++i)
+            {
+               row_data[i] = first_oid[i] != 0 ? first_oid[i] + r :
+                     oids[i].empty() ? 0 : oids[i][r];
+            }
+
+         rows.insert(rid, row_type(tid, row_data, &row_oids));
+         rids.push_back(rid);
+         rid = rid + 1;
+      }
 
    return insert_code::SUCCESS;
 }
 
-bool table::commit_row(const transaction_id& tid, const row_id& rid)
+bool table::commit_row(const transaction_id& tid, const row_id& rid,
+      commit_timestamp_type ts)
 {
    auto pos = rows.find(rid);
    if (pos != rows.end())
       {
-         pos->second.commit(tid);
+         pos->second.commit(tid, ts);
          return true;
       }
    return false;
 }
 
-table::fetch_code table::fetch_row(const transaction_id& tid,
+std::size_t table::commit_rows(const transaction_id& tid,
+      const std::vector<row_id>& rids, commit_timestamp_type ts)
+{
+   std::size_t committed = 0;
+   auto pos = rows.end();
+
+   for (auto& rid : rids)
+      {
+         // Rows inserted together usually have consecutive ids, so the
+         // next row is most likely the one we want.
+         if (pos != rows.end())
+            {
+               ++pos;
+            }
+
+         if (pos == rows.end() || !(pos->first == rid))
+            {
+               pos = rows.find(rid);
+               if (pos == rows.end())
+                  {
+                     continue;
+                  }
+            }
+
+         if (pos->second.commit(tid, ts))
+            {
+               ++committed;
+            }
+      }
+
+   return committed;
+}
+
+bool table::remove_row(const transaction_id& tid, const row_id& rid,
+      commit_timestamp_type ts)
+{
+   auto pos = rows.find(rid);
+   if (pos == rows.end())
+      {
+         return false;
+      }
+
+   if (!pos->second.remove(tid, ts))
+      {
+         return false;
+      }
+
+   return pos->second.unlock(tid);
+}
+
+bool table::row_matches(row_type& row, const row_filter& filter)
+{
+   auto test = [&](std::size_t i, predicate& pred)
+      {
+         if (i >= number_of_columns || column_data[i].get() == nullptr)
+            {
+               return false;
+            }
+
+         auto oid = row.column(i);
+         if (oid == 0)
+            {
+               return false;
+            }
+
+         page_cursor cursor(*column_data[i], oid);
+         if (cursor.end_of_page() || cursor.oid() != oid)
+            {
+               return false;
+            }
+
+         return pred.contains(cursor);
+      };
+
+   return filter.matches(test);
+}
+
+template<typename Read>
+table::fetch_code table::read_row(const transaction_id& tid,
       row_list_type::iterator& pos, const column_present_type& present,
-      std::ostream& buffer, isolation_level level)
+      isolation_level level, commit_timestamp_type snapshot,
+      const row_filter* filter, Read read)
 {
+   // The row may have been vacuumed since the iterator was set.
+   if (!pos.live())
+      {
+         return fetch_code::ISOLATED;
+      }
+
    // Get a reference to the row.
    auto& row = pos->second;
 
-   if (!row_is_visible(tid, row, level))
+   if (!row_is_visible(tid, row, level, snapshot))
       {
          return fetch_code::ISOLATED;
       }
 
+   // Rows the filter rejects are not read out at all.
+   auto matched = filter == nullptr || row_matches(row, *filter);
+
    // Read columns from the row as requested.
-   for (auto i = 0; i < number_of_columns; ++i)
+   for (auto i = 0; matched && i < number_of_columns; ++i)
       {
          // If the column is not present, don't try to read it.
          if (present.size() <= i || present[i] == false)
@@ -113,24 +378,17 @@ table::fetch_code table::fetch_row(const transaction_id& tid,
                continue;
             }
 
-         // Fetch the bits of information we need to read
-         // the data properly.
+         // Columns that were never defined have nothing to read.
          auto& p = column_data[i];
-         auto c = p->get_column_definition();
-         auto oid = row.column(i);
-
-         data_value dv(c->type);
+         if (p.get() == nullptr)
+            {
+               continue;
+            }
 
-         // Sync up the data value.
-         auto seek = p->get_stream(oid);
-         if (std::get<0>(seek) == false)
+         if (!read(i, *p, row.column(i)))
             {
                return fetch_code::CORRUPT_PAGE;
             }
-
-         // Copy the data from the column store to the
-         // output buffer.
-         dv.copy(*std::get<1>(seek), buffer);
       }
 
    if (level==isolation_level::SERIALIZABLE && ssi_lm!=nullptr)
@@ -138,12 +396,124 @@ table::fetch_code table::fetch_row(const transaction_id& tid,
          ssi_lm->track_read(tid, table_id, pos->first);
       }
 
-   return fetch_code::SUCCESS;
+   return matched ? fetch_code::SUCCESS : fetch_code::FILTERED;
+}
+
+table::fetch_code table::fetch_row(const transaction_id& tid,
+      row_list_type::iterator& pos, const column_present_type& present,
+      std::ostream& buffer, isolation_level level,
+      commit_timestamp_type snapshot, const row_filter* filter)
+{
+   return read_row(tid, pos, present, level, snapshot, filter,
+         [&](unsigned int, page& p, page::object_id_type oid)
+            {
+               // Columns that were not given a value read as zero, or as
+               // an empty varchar, as they do in a column batch.
+               if (oid == 0)
+                  {
+                     static const char zeros[sizeof(std::uint64_t)] = { };
+
+                     auto width = column_batch::fixed_width(
+                           p.get_column_definition()->type);
+                     buffer.write(zeros, width != 0 ? width :
+                           sizeof(column_batch::offset_type));
+                     return true;
+                  }
+
+               // Locate the data value.
+               auto location = p.get_data(oid);
+               if (std::get<0>(location) == false)
+                  {
+                     return false;
+                  }
+
+               // Copy the data from the column store to the
+               // output buffer.
+               data_value dv(p.get_column_definition()->type);
+               dv.copy(std::get<1>(location), buffer);
+               return true;
+            });
+}
+
+void table::start_batch(const column_present_type& present,
+      column_batch& batch)
+{
+   // The same columns, in the same order, as read_row() reads.
+   for (auto i = 0; i < number_of_columns && i < present.size(); ++i)
+      {
+         if (present[i] && column_data[i].get() != nullptr)
+            {
+               batch.add_column(i,
+                     column_data[i]->get_column_definition()->type);
+            }
+      }
+}
+
+table::fetch_code table::fetch_row(const transaction_id& tid,
+      row_list_type::iterator& pos, const column_present_type& present,
+      column_batch& batch, isolation_level level,
+      commit_timestamp_type snapshot, const row_filter* filter)
+{
+   std::size_t k = 0;
+
+   auto code = read_row(tid, pos, present, level, snapshot, filter,
+         [&](unsigned int, page& p, page::object_id_type oid)
+            {
+               // Columns that were not given a value are null.
+               if (oid == 0)
+                  {
+                     batch.append_null(k++);
+                     return true;
+                  }
+
+               auto location = p.get_data(oid);
+               if (std::get<0>(location) == false)
+                  {
+                     return false;
+                  }
+
+               batch.append_value(k++, std::get<1>(location));
+               return true;
+            });
+
+   // A column that could not be read leaves the row half built.
+   if (code == fetch_code::SUCCESS)
+      {
+         batch.end_row();
+      }
+   else if (code == fetch_code::CORRUPT_PAGE)
+      {
+         batch.discard_row();
+      }
+
+   return code;
+}
+
+table::fetch_code table::aggregate_row(const transaction_id& tid,
+      row_list_type::iterator& pos, const column_present_type& present,
+      aggregate& agg, isolation_level level, commit_timestamp_type snapshot,
+      const row_filter* filter)
+{
+   // Only find where the values are, the aggregate reads what it needs.
+   auto code = read_row(tid, pos, present, level, snapshot, filter,
+         [&](unsigned int i, page& p, page::object_id_type oid)
+            {
+               agg.locate(i, p, oid);
+               return true;
+            });
+
+   if (code == fetch_code::SUCCESS)
+      {
+         agg.add_row();
+      }
+
+   return code;
 }
 
 table::fetch_code table::fetch_row(const transaction_id& tid, const row_id& rid,
       const column_present_type& present, std::ostream& buffer,
-      isolation_level level)
+      isolation_level level, commit_timestamp_type snapshot,
+      const row_filter* filter)
 {
    // See if the row exists.
    auto pos = rows.find(rid);
@@ -152,18 +522,49 @@ table::fetch_code table::fetch_row(const transaction_id& tid, const row_id& rid,
          return fetch_code::DOES_NOT_EXIST;
       }
 
-   return fetch_row(tid, pos, present, buffer, level);
+   return fetch_row(tid, pos, present, buffer, level, snapshot, filter);
+}
+
+page::object_id_type table::copy_object(page& p, page::object_id_type oid)
+{
+   auto location = p.get_data(oid);
+   if (std::get<0>(location) == false)
+      {
+         return 0;
+      }
+
+   // Take the bytes out before inserting, which may move them.
+   std::stringstream value;
+   data_value dv(p.get_column_definition()->type);
+   dv.copy(std::get<1>(location), value);
+
+   auto data = value.str();
+   auto copy = p.get_next_oid();
+   if (p.insert_value(copy, static_cast<const std::uint8_t*>(
+         static_cast<const void*>(data.data())), data.size()) == 0)
+      {
+         return 0;
+      }
+
+   return copy;
 }
 
 table::update_code table::update_row(const transaction_id& tid,
       row_list_type::iterator& pos, const column_present_type& present,
-      const std::string& buffer, row_id& new_rid, isolation_level level)
+      const std::string& buffer, row_id& new_rid, isolation_level level,
+      commit_timestamp_type snapshot)
 {
+   // The row may have been vacuumed since the iterator was set.
+   if (!pos.live())
+      {
+         return update_code::ISOLATED;
+      }
+
    // Get a reference to the row.
    auto& old_rid = pos->first;
    auto& old_row = pos->second;
 
-   if (!row_is_visible(tid, old_row, level))
+   if (!row_is_visible(tid, old_row, level, snapshot))
       {
          return update_code::ISOLATED;
       }
@@ -202,8 +603,32 @@ table::update_code table::update_row(const transaction_id& tid,
    // unchanged data.
    new_row.update(tid, present, old_row);
 
-   // Delete the old row.
-   old_row.remove(tid);
+   // The unchanged data is now shared by both versions, so that
+   // vacuuming the old one leaves it in place.
+   for (auto i = 0; i < number_of_columns && i < present.size(); ++i)
+      {
+         auto oid = new_row.column(i);
+         if (present[i] || oid == 0)
+            {
+               continue;
+            }
+
+         // A value shared by too many versions gets a copy of its own.
+         if (!column_data[i]->acquire_object(oid))
+            {
+               auto copy = copy_object(*column_data[i], oid);
+               if (copy == 0)
+                  {
+                     return update_code::CORRUPT_PAGE;
+                  }
+
+               new_row.set_column(i, copy);
+            }
+      }
+
+   // The old row stays locked, and visible to everyone else, until we
+   // commit and remove_row() marks it deleted.
+   old_row.replace(tid);
 
    // Track a write on the old row, in case anyone has read it.
    if (level==isolation_level::SERIALIZABLE && ssi_lm!=nullptr)
@@ -216,7 +641,8 @@ table::update_code table::update_row(const transaction_id& tid,
 
 table::update_code table::update_row(const transaction_id& tid,
       const row_id& rid, const column_present_type& present,
-      const std::string& buffer, row_id& new_rid, isolation_level level)
+      const std::string& buffer, row_id& new_rid, isolation_level level,
+      commit_timestamp_type snapshot)
 {
    // See if the row exists.
    auto pos = rows.find(rid);
@@ -225,8 +651,51 @@ table::update_code table::update_row(const transaction_id& tid,
          return update_code::DOES_NOT_EXIST;
       }
 
-   return update_row(tid, pos, present, buffer, new_rid, level);
+   return update_row(tid, pos, present, buffer, new_rid, level, snapshot);
+
+}
+
+std::size_t table::vacuum(commit_timestamp_type horizon,
+      std::size_t max_rows)
+{
+   std::size_t removed = 0;
+   auto pos = rows.lower_bound(vacuum_cursor);
+
+   for (std::size_t i = 0; i < max_rows; ++i)
+      {
+         if (pos == rows.end())
+            {
+               break;
+            }
+
+         auto rid = pos->first;
+         auto& row = pos->second;
+         ++pos;
+
+         if (!row.is_reclaimable(horizon))
+            {
+               continue;
+            }
+
+         // Drop our reference to each column. Objects shared with a newer
+         // version of the row stay until it goes too.
+         for (auto c = 0; c < number_of_columns; ++c)
+            {
+               auto oid = row.column(c);
+               if (oid != 0)
+                  {
+                     column_data[c]->delete_object(oid);
+                  }
+            }
+
+         rows.erase(rid);
+         ++removed;
+      }
+
+   // Carry on from here next time, or start over at the end.
+   vacuum_cursor = pos != rows.end() ? pos->first : row_id();
 
+   return removed;
 }
 
 bool table::to_binary(const column_present_type& present,
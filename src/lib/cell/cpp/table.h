@@ -8,11 +8,18 @@
 #include <unordered_map>
 
 #include <cell/cpp/unstringify.h>
+#include <cell/cpp/commit_clock.h>
 #include <cell/cpp/row_id.h>
+#include <cell/cpp/row_store.h>
 #include <cell/cpp/row_value.h>
 #include <cell/cpp/isolation_level.h>
+#include <cell/cpp/oid_slab.h>
 #include <cell/cpp/ssi_lock_manager.h>
 #include <cell/cpp/page.h>
+#include <cell/cpp/page_factory.h>
+#include <cell/cpp/row_filter.h>
+#include <cell/cpp/column_batch.h>
+#include <cell/cpp/aggregate.h>
 
 namespace lattice {
 namespace cell {
@@ -36,9 +43,11 @@ public:
       CORRUPT_PAGE,     // The page containing the column recorded a data
                         // offset that was not valid.
 
-      UNKNOWN_DATA_TYPE // The storage engine does not know how to read the
-                        // data specified in one or more columns.
+      UNKNOWN_DATA_TYPE, // The storage engine does not know how to read the
+                         // data specified in one or more columns.
 
+      FILTERED          // The row is visible, but does not satisfy the
+                        // filter it was fetched with.
    };
 
    /** Indicates various results that a row insert can issue. */
@@ -100,9 +109,9 @@ public:
    typedef std::vector<page_handle_type> column_data_type;
 
    /**
-    * A hash of rows.
+    * The rows, addressed directly by row id.
     */
-   typedef std::unordered_map<row_id, row_type, row_id_hash> row_list_type;
+   typedef row_store row_list_type;
 
    /**
     * Provides storage for text results read from a command string.
@@ -115,6 +124,11 @@ private:
     */
    ssi_lock_manager *ssi_lm;
 
+   /**
+    * The column object id arrays of the rows. This must outlive the rows.
+    */
+   oid_slab row_oids;
+
    /**
     * The list of rows assigned to the table.
     */
@@ -145,11 +159,42 @@ private:
     */
    page::object_id_type table_id;
 
+   /**
+    * The row id vacuum() looks at next.
+    */
+   row_id vacuum_cursor;
+
+   /**
+    * Indicates whether a row satisfies a filter, by reading the columns
+    * it tests straight out of the column pages. Columns the row has no
+    * value for satisfy nothing.
+    */
+   bool row_matches(row_type& row, const row_filter& filter);
+
+   /**
+    * Copies an object into a new object of the same page.
+    *
+    * @returns: The object id of the copy, or 0 if the object could not be
+    * read.
+    */
+   static page::object_id_type copy_object(page& p, page::object_id_type oid);
+
+   /**
+    * Does the work of fetch_row(): checks the row can be seen and
+    * satisfies the filter, then hands the column number, page and object
+    * id of each present column to 'read', which returns false if the
+    * page is corrupt.
+    */
+   template<typename Read>
+   fetch_code read_row(const transaction_id& tid, row_list_type::iterator& pos,
+         const column_present_type& present, isolation_level level,
+         commit_timestamp_type snapshot, const row_filter* filter, Read read);
+
 public:
 
    table(page::object_id_type _table_id, unsigned int _number_of_columns) :
          table_id(_table_id), number_of_columns(_number_of_columns),
-         ssi_lm(nullptr)
+         ssi_lm(nullptr), row_oids(_number_of_columns)
    {
       for (auto i = 0; i < number_of_columns; ++i)
          {
@@ -174,6 +219,23 @@ public:
       return number_of_columns;
    }
 
+   /**
+    * Provides the definition of a column, or nullptr if it has not been
+    * set.
+    *
+    * @param column_number: The column.
+    */
+   const column* get_column_definition(unsigned int column_number) const
+   {
+      if (column_number >= number_of_columns
+            || column_data[column_number].get() == nullptr)
+         {
+            return nullptr;
+         }
+
+      return column_data[column_number]->get_column_definition();
+   }
+
    /**
     * Get the column id by name.
     *
@@ -200,6 +262,16 @@ public:
       return row_id_generator.next();
    }
 
+   /**
+    * Get a block of consecutive row ids.
+    *
+    * @returns: The first row id of the block.
+    */
+   row_id get_next_row_ids(std::size_t count)
+   {
+      return row_id_generator.reserve(count);
+   }
+
    /**
     * Sets the serializable snapshot isolation lock manager for this
     * table.
@@ -212,6 +284,20 @@ public:
       ssi_lm = lm;
    }
 
+   /**
+    * Takes a read lock on the whole table for a serializable scan, so
+    * that the rows it reads are not tracked one at a time.
+    *
+    * @param tid: The transaction doing the scan.
+    */
+   void track_scan(const transaction_id& tid)
+   {
+      if (ssi_lm != nullptr)
+         {
+            ssi_lm->track_table_read(tid, table_id);
+         }
+   }
+
    /**
     * Set the column definition for the given column.
     *
@@ -245,13 +331,84 @@ public:
             return false;
          }
 
-      // Create a new column and set the definition.
-      column_data[column_number] = page_handle_type(new page(col));
+      // Create a new column and set the definition. Fixed width types get
+      // a typed page, so that their values are stored in dense arrays.
+      auto p = make_page(col);
+      if (p.get() == nullptr)
+         {
+            // The storage engine does not know how to store this type.
+            return false;
+         }
+
+      column_data[column_number] = std::move(p);
       column_names[col->name] = column_number;
 
       return true;
    }
 
+   /**
+    * Reclaims space held by deleted objects in the column pages. See
+    * page::compact().
+    *
+    * @param max_bytes: The number of bytes that may be copied, shared by
+    *                   all columns.
+    *
+    * @returns: The number of bytes copied.
+    */
+   page::size_type compact(page::size_type max_bytes)
+   {
+      page::size_type moved = 0;
+
+      for (auto& p : column_data)
+         {
+            if (p && moved < max_bytes)
+               {
+                  moved += p->compact(max_bytes - moved);
+               }
+         }
+
+      return moved;
+   }
+
+   /**
+    * Removes row versions that no transaction can see any more, and
+    * deletes the column objects they do not share with newer versions.
+    * Rows are looked at a few at a time, carrying on from where the last
+    * call left off, so that the cost can be spread over many requests.
+    *
+    * @param horizon: The time the oldest transaction still running began.
+    *                 Rows deleted at or before it are removed.
+    * @param max_rows: The most rows to look at.
+    *
+    * @returns: The number of rows removed.
+    */
+   std::size_t vacuum(commit_timestamp_type horizon, std::size_t max_rows);
+
+   /**
+    * Reports how much space is wasted in the column pages.
+    */
+   page::fragmentation_stats_type get_fragmentation()
+   {
+      page::fragmentation_stats_type stats;
+
+      for (auto& p : column_data)
+         {
+            if (!p)
+               {
+                  continue;
+               }
+
+            auto column_stats = p->get_fragmentation();
+            stats.atoms += column_stats.atoms;
+            stats.bytes += column_stats.bytes;
+            stats.live_bytes += column_stats.live_bytes;
+            stats.sparse_atoms += column_stats.sparse_atoms;
+            stats.reclaimed_bytes += column_stats.reclaimed_bytes;
+         }
+
+      return stats;
+   }
+
    /**
     * Provides an iterator pointing to the first row of this table.
     */
@@ -286,11 +443,28 @@ public:
    insert_code insert_row(const transaction_id& tid, row_id& rid,
          const column_present_type& present, const std::string& data);
 
+   /**
+    * Insert many rows into the table at once, a column at a time.
+    *
+    * @param tid: The transaction id to associate the inserts with.
+    * @param batch: The rows. Columns of the table that are not in the
+    *               batch have no value.
+    * @param rids: Filled in with the row ids assigned to the rows, which
+    *              are consecutive.
+    *
+    * Object ids and row ids are taken in blocks, and the values of a
+    * fixed width column without nulls are copied into its page in one
+    * pass. Nothing is inserted if the batch does not match the table.
+    */
+   insert_code insert_rows(const transaction_id& tid,
+         const column_batch& batch, std::vector<row_id>& rids);
+
    /**
     * Commit a row to the table store.
     *
     * @param tid: The id of the committing transaction.
     * @param rid: The id of the row.
+    * @param ts: The time the transaction committed.
     *
     * This function essentially makes a row visible to other transactions. The
     * insert_row() call stages the data by writing the data into the various
@@ -298,7 +472,36 @@ public:
     * committed.
     *
     */
-   bool commit_row(const transaction_id& tid, const row_id& rid);
+   bool commit_row(const transaction_id& tid, const row_id& rid,
+         commit_timestamp_type ts);
+
+   /**
+    * Commit many rows to the table store. See commit_row().
+    *
+    * @param tid: The id of the committing transaction.
+    * @param rids: The ids of the rows, in ascending order. Runs of
+    *              consecutive ids are walked instead of looked up.
+    * @param ts: The time the transaction committed.
+    *
+    * @returns: The number of rows committed.
+    */
+   std::size_t commit_rows(const transaction_id& tid,
+         const std::vector<row_id>& rids, commit_timestamp_type ts);
+
+   /**
+    * Marks a row as deleted by a committing transaction, and unlocks it.
+    *
+    * @param tid: The id of the committing transaction.
+    * @param rid: The id of the row.
+    * @param ts: The time the transaction committed.
+    *
+    * Transactions that update a row lock the old version and call this
+    * when they commit, so that other transactions keep seeing the old
+    * version until then. Once every transaction running at that point has
+    * finished, vacuum() removes it.
+    */
+   bool remove_row(const transaction_id& tid, const row_id& rid,
+         commit_timestamp_type ts);
 
    /**
     * Fetch a row from the table.
@@ -311,11 +514,61 @@ public:
     *                 read from the column store and written into
     *                 the buffer.
     *
-    * @param buffer: The data buffer to write data into.
+    * @param buffer: The data buffer to write data into. Columns the row
+    *                has no value for are written as zero, or as an empty
+    *                varchar.
+    *
+    * @param snapshot: The time the transaction began. Only used for
+    *                  REPEATABLE_READ and SERIALIZABLE.
+    *
+    * @param filter: If not nullptr, rows that do not satisfy it are not
+    *                written to the buffer, and fetch_code::FILTERED is
+    *                returned instead. They still count as read.
     */
    fetch_code fetch_row(const transaction_id& tid, row_list_type::iterator& pos,
          const column_present_type& present, std::ostream& buffer,
-         isolation_level level = isolation_level::READ_COMMITTED);
+         isolation_level level = isolation_level::READ_COMMITTED,
+         commit_timestamp_type snapshot = commit_clock::k_latest,
+         const row_filter* filter = nullptr);
+
+   /**
+    * Sets up a batch to receive the present columns of rows fetched with
+    * the fetch_row() below.
+    */
+   void start_batch(const column_present_type& present, column_batch& batch);
+
+   /**
+    * Fetch a row from the table into a columnar batch, as a new row of the
+    * batch. The values are copied straight from the pages, and columns
+    * the row has no value for are null.
+    *
+    * @param batch: The batch, set up with start_batch() and the same
+    *               present vector.
+    *
+    * The other parameters, and the result, are as for the fetch_row()
+    * above.
+    */
+   fetch_code fetch_row(const transaction_id& tid, row_list_type::iterator& pos,
+         const column_present_type& present, column_batch& batch,
+         isolation_level level = isolation_level::READ_COMMITTED,
+         commit_timestamp_type snapshot = commit_clock::k_latest,
+         const row_filter* filter = nullptr);
+
+   /**
+    * Adds a row to an aggregate. Nothing is copied out of the pages
+    * except the values the aggregate needs.
+    *
+    * @param present: The columns the aggregate needs, from
+    *                 aggregate::start().
+    * @param agg: The aggregate.
+    *
+    * The other parameters, and the result, are as for fetch_row().
+    */
+   fetch_code aggregate_row(const transaction_id& tid,
+         row_list_type::iterator& pos, const column_present_type& present,
+         aggregate& agg, isolation_level level = isolation_level::READ_COMMITTED,
+         commit_timestamp_type snapshot = commit_clock::k_latest,
+         const row_filter* filter = nullptr);
 
    /**
     * Fetch a row from the table.
@@ -330,10 +583,15 @@ public:
     *                 the buffer.
     *
     * @param buffer: The buffer to write data into.
+    *
+    * @param snapshot: The time the transaction began. Only used for
+    *                  REPEATABLE_READ and SERIALIZABLE.
     */
    fetch_code fetch_row(const transaction_id& tid, const row_id& rid,
          const column_present_type& present, std::ostream& buffer,
-         isolation_level level = isolation_level::READ_COMMITTED);
+         isolation_level level = isolation_level::READ_COMMITTED,
+         commit_timestamp_type snapshot = commit_clock::k_latest,
+         const row_filter* filter = nullptr);
 
    /**
     * Update a row in the table.
@@ -347,11 +605,15 @@ public:
     *                 the buffer.
     *
     * @param buffer: The data buffer to update from.
+    *
+    * @param snapshot: The time the transaction began. Only used for
+    *                  REPEATABLE_READ and SERIALIZABLE.
     */
    update_code update_row(const transaction_id& tid,
          row_list_type::iterator& pos, const column_present_type& present,
          const std::string& buffer, row_id& new_rid, isolation_level level =
-               isolation_level::READ_COMMITTED);
+               isolation_level::READ_COMMITTED,
+         commit_timestamp_type snapshot = commit_clock::k_latest);
 
    /**
     * Update a row in the table.
@@ -366,11 +628,15 @@ public:
     *                 the buffer.
     *
     * @param buffer: The buffer to update from.
+    *
+    * @param snapshot: The time the transaction began. Only used for
+    *                  REPEATABLE_READ and SERIALIZABLE.
     */
    update_code update_row(const transaction_id& tid, const row_id& rid,
          const column_present_type& present, const std::string& buffer,
          row_id& new_rid, isolation_level level =
-               isolation_level::READ_COMMITTED);
+               isolation_level::READ_COMMITTED,
+         commit_timestamp_type snapshot = commit_clock::k_latest);
 
    /**
     * Converts a text tuple into a binary format.
@@ -23,6 +23,11 @@ void transaction::create_version(table_handle_type t)
 bool transaction::insert_columns(table_handle_type t, const std::string& data,
       const std::vector<bool>& present)
 {
+   if (read_only)
+      {
+         return false;
+      }
+
    auto tbl_id = t->get_table_id();
    auto pos = versions.find(tbl_id);
    if (pos == versions.end())
@@ -40,11 +45,40 @@ bool transaction::insert_columns(table_handle_type t, const std::string& data,
          return false;
       }
 
-   version.added.insert(rid);
+   version.added.push_back(rid);
    return true;
 }
 
-bool transaction::commit()
+bool transaction::insert_rows(table_handle_type t, const column_batch& batch)
+{
+   if (read_only)
+      {
+         return false;
+      }
+
+   auto tbl_id = t->get_table_id();
+   auto pos = versions.find(tbl_id);
+   if (pos == versions.end())
+      {
+         create_version(t);
+         pos = versions.find(tbl_id);
+      }
+
+   auto& version = pos->second;
+
+   std::vector<row_id> rids;
+   if (t->insert_rows(id, batch, rids) != table::insert_code::SUCCESS)
+      {
+         return false;
+      }
+
+   // The new row ids are higher than any handed out before, so the
+   // added list stays in order.
+   version.added.insert(version.added.end(), rids.begin(), rids.end());
+   return true;
+}
+
+bool transaction::commit(commit_timestamp_type ts)
 {
    /**
     * Process each table version in turn.
@@ -54,18 +88,31 @@ bool transaction::commit()
          auto t = version.second.t;
 
          // Process all inserts.
-         for (auto& row : version.second.added)
+         t->commit_rows(id, version.second.added, ts);
+
+         // Process all deletes, including the old versions of updated rows.
+         for (auto& row : version.second.deleted)
             {
-               t->commit_row(id, row);
+               t->remove_row(id, row, ts);
             }
       }
 
    return true;
 }
 
-bool transaction::fetch_columns(cursor_type &cursor, std::string& data,
-      const std::vector<bool>& present)
+template<typename Fetch>
+bool transaction::next_row(cursor_type &cursor, Fetch fetch)
 {
+   auto level = get_read_level();
+
+   // A serializable scan locks the whole table once, rather than each
+   // row it reads.
+   if (level == isolation_level::SERIALIZABLE && !cursor.scan_locked)
+      {
+         cursor.t->track_scan(id);
+         cursor.scan_locked = true;
+      }
+
    while (true)
       {
          // If the cursor is at the end, don't try to fetch.
@@ -74,15 +121,14 @@ bool transaction::fetch_columns(cursor_type &cursor, std::string& data,
                return false;
             }
 
-         std::stringstream out;
-
-         switch (cursor.t->fetch_row(id, cursor.it, present, out, il))
+         switch (fetch(level))
             {
             case table::fetch_code::SUCCESS:    // return the data
-               data = out.str();
+               ++cursor.it;
                return true;
 
             case table::fetch_code::ISOLATED:   // go to the next row
+            case table::fetch_code::FILTERED:
                ++cursor.it;
             break;
 
@@ -92,9 +138,60 @@ bool transaction::fetch_columns(cursor_type &cursor, std::string& data,
       }
 }
 
+bool transaction::fetch_columns(cursor_type &cursor, std::string& data,
+      const std::vector<bool>& present, const row_filter* filter)
+{
+   return next_row(cursor, [&](isolation_level level)
+      {
+         std::stringstream out;
+
+         auto code = cursor.t->fetch_row(id, cursor.it, present, out, level,
+               snapshot, filter);
+         if (code == table::fetch_code::SUCCESS)
+            {
+               data = out.str();
+            }
+
+         return code;
+      });
+}
+
+std::size_t transaction::aggregate_columns(cursor_type &cursor,
+      aggregate& agg, const row_filter* filter)
+{
+   auto present = agg.start(cursor.t->get_number_of_columns());
+
+   std::size_t rows = 0;
+   while (next_row(cursor, [&](isolation_level level)
+      {
+         return cursor.t->aggregate_row(id, cursor.it, present, agg, level,
+               snapshot, filter);
+      }))
+      {
+         ++rows;
+      }
+
+   return rows;
+}
+
+bool transaction::fetch_columns(cursor_type &cursor, column_batch& batch,
+      const std::vector<bool>& present, const row_filter* filter)
+{
+   return next_row(cursor, [&](isolation_level level)
+      {
+         return cursor.t->fetch_row(id, cursor.it, present, batch, level,
+               snapshot, filter);
+      });
+}
+
 bool transaction::update_columns(cursor_type &cursor, const std::string& data,
       const std::vector<bool>& present)
 {
+   if (read_only)
+      {
+         return false;
+      }
+
    auto tbl_id = cursor.t->get_table_id();
    auto pos = versions.find(tbl_id);
    if (pos == versions.end())
@@ -113,12 +210,16 @@ bool transaction::update_columns(cursor_type &cursor, const std::string& data,
                return false;
             }
 
+         // The update moves the cursor to the new version.
+         auto old_rid = cursor.it->first;
+
          row_id new_rid;
-         switch (cursor.t->update_row(id, cursor.it, present, data, new_rid, il))
+         switch (cursor.t->update_row(id, cursor.it, present, data, new_rid, il,
+               snapshot))
             {
             case table::update_code::SUCCESS:    // update the records
-               version.deleted.insert(cursor.it->first);
-               version.added.insert(new_rid);
+               version.deleted.insert(old_rid);
+               version.added.push_back(new_rid);
                return true;
 
             case table::update_code::ISOLATED:   // go to the next row
@@ -3,7 +3,9 @@
 
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
+#include <cell/cpp/commit_clock.h>
 #include <cell/cpp/transaction_id.h>
 #include <cell/cpp/isolation_level.h>
 #include <cell/cpp/table.h>
@@ -15,13 +17,17 @@ class transaction
 {
    typedef std::unordered_set<row_id, row_id_hash> row_id_list_type;
 
+   /** Row ids in the order they were handed out, which is ascending. */
+   typedef std::vector<row_id> row_id_run_type;
+
    typedef struct
    {
       /** Reference to the table adjusted. */
       table_handle_type t;
 
-      /** Set of row ids added. */
-      row_id_list_type added;
+      /** The row ids added, in ascending order, so that they can be
+       * committed a run at a time. */
+      row_id_run_type added;
 
       /** Set of row ids deleted during this transaction. This set also
        * includes row ids implicitly deleted by updating them. */
@@ -36,6 +42,9 @@ class transaction
 
       /** Reference to the table the cursor is attached to. */
       table_handle_type t;
+
+      /** Set once a serializable scan has locked the table. */
+      bool scan_locked;
    } cursor_type;
 
    /** The map of version information for this transaction. The key is the table
@@ -54,13 +63,65 @@ class transaction
    /** The transaction id for this transaction. */
    transaction_id id;
 
+   /** The time this transaction began. REPEATABLE_READ and SERIALIZABLE
+    * transactions see the rows committed by then. */
+   commit_timestamp_type snapshot;
+
+   /** Set if this transaction may not write. */
+   bool read_only;
+
+   /** Set if this transaction is read only, and its snapshot cannot be
+    * part of a serialization anomaly, so its reads need not be tracked. */
+   bool safe_snapshot;
+
+   /**
+    * Moves the cursor to the next row that 'fetch' reads, skipping rows
+    * that cannot be seen or are filtered out.
+    *
+    * @param fetch: Called with the isolation level to read at, and
+    *               returns the table::fetch_code for the row at the
+    *               cursor.
+    *
+    * @returns: false at the end of the table, or on an error.
+    */
+   template<typename Fetch>
+   bool next_row(cursor_type &cursor, Fetch fetch);
+
 public:
    transaction() :
-         next_cursor_id(0), il(isolation_level::READ_COMMITTED)
+         next_cursor_id(0), il(isolation_level::READ_COMMITTED),
+         snapshot(commit_clock::k_latest), read_only(false),
+         safe_snapshot(false)
    {
    }
    ;
 
+   /**
+    * @param _id: The transaction id to read and write rows with.
+    * @param _snapshot: The time the transaction began.
+    */
+   transaction(transaction_id _id, commit_timestamp_type _snapshot) :
+         next_cursor_id(0), il(isolation_level::READ_COMMITTED), id(_id),
+         snapshot(_snapshot), read_only(false), safe_snapshot(false)
+   {
+   }
+
+   /**
+    * Provides the transaction id.
+    */
+   const transaction_id& get_id() const
+   {
+      return id;
+   }
+
+   /**
+    * Provides the time this transaction began.
+    */
+   commit_timestamp_type get_snapshot() const
+   {
+      return snapshot;
+   }
+
    /**
     * Set the isolation level for the transaction.
     *
@@ -71,6 +132,49 @@ public:
       il = level;
    }
 
+   /**
+    * Provides the isolation level for the transaction.
+    */
+   isolation_level get_isolation_level() const
+   {
+      return il;
+   }
+
+   /**
+    * Makes the transaction read only. Inserts and updates will fail.
+    *
+    * @param safe: true if no read-write SERIALIZABLE transaction was
+    *              running when the snapshot was taken. Such a snapshot
+    *              cannot take part in a serialization anomaly, so reads
+    *              are done at snapshot isolation and are not tracked.
+    */
+   void set_read_only(bool safe)
+   {
+      read_only = true;
+      safe_snapshot = safe;
+   }
+
+   /**
+    * Indicates whether the transaction is read only.
+    */
+   bool is_read_only() const
+   {
+      return read_only;
+   }
+
+   /**
+    * Provides the isolation level reads are done at.
+    */
+   isolation_level get_read_level() const
+   {
+      if (safe_snapshot && il == isolation_level::SERIALIZABLE)
+         {
+            return isolation_level::REPEATABLE_READ;
+         }
+
+      return il;
+   }
+
    /**
     * Creates a new version object for the table. This lets us isolate
     * changes from the main row store.
@@ -87,7 +191,7 @@ public:
       auto cursor_id = ++next_cursor_id;
       row_cursor_map.insert(std::make_pair(cursor_id, cursor_type
          {
-         t->begin(), t
+         t->begin(), t, false
          }));
 
       return cursor_id;
@@ -104,22 +208,64 @@ public:
       return row_cursor_map[cursor_id];
    }
 
+   /**
+    * Indicates whether a cursor is open.
+    */
+   bool has_cursor(page::object_id_type cursor_id) const
+   {
+      return row_cursor_map.find(cursor_id) != row_cursor_map.end();
+   }
+
    /**
     * Insert a new row into a table.
     */
    bool insert_columns(table_handle_type t, const std::string& data,
          const std::vector<bool>& present);
 
+   /**
+    * Insert a batch of rows into a table. See table::insert_rows().
+    */
+   bool insert_rows(table_handle_type t, const column_batch& batch);
+
    /**
     * Moves modifications into the table store.
+    *
+    * @param ts: The time of the commit, from the commit clock.
     */
-   bool commit();
+   bool commit(commit_timestamp_type ts);
 
    /**
-    * Fetch columns from a table.
+    * Fetch columns from a table, and move the cursor past the row.
+    *
+    * @param filter: If not nullptr, rows that do not satisfy it are
+    *                skipped.
     */
    bool fetch_columns(cursor_type &cursor, std::string& data,
-         const std::vector<bool>& present);
+         const std::vector<bool>& present, const row_filter* filter = nullptr);
+
+   /**
+    * Fetch columns from a table into the next row of a batch, and move
+    * the cursor past the row.
+    *
+    * @param batch: The batch, set up with table::start_batch() and the
+    *               same present vector.
+    * @param filter: If not nullptr, rows that do not satisfy it are
+    *                skipped.
+    */
+   bool fetch_columns(cursor_type &cursor, column_batch& batch,
+         const std::vector<bool>& present, const row_filter* filter = nullptr);
+
+   /**
+    * Adds every row from the cursor to the end of the table to an
+    * aggregate, leaving the cursor at the end.
+    *
+    * @param filter: If not nullptr, rows that do not satisfy it are
+    *                skipped.
+    *
+    * @returns: The number of rows added.
+    */
+   std::size_t aggregate_columns(cursor_type &cursor, aggregate& agg,
+         const row_filter* filter = nullptr);
 
    /**
     * Update columns in a table.
@@ -1,19 +1,3 @@
-insert_case_txt = """
-        case {type}:
-          {{
-            const {cpptype} *data = static_cast<const {cpptype}*>(
-                       static_cast<const void *>(buffer+offset)
-            );
-            auto bytes_written = p->insert_object(oid, *data);
-            if (bytes_written == 0 || bytes_written!=sizeof({cpptype}))
-              {{
-               return insert_code::OUT_OF_MEMORY;
-              }}
-            offset += bytes_written;
-          }}
-          break;
-"""
-
 to_binary_case_txt = """
         case {type}:
           {{
@@ -44,12 +28,6 @@ compound_types = [
     ("std::uint8_t",  "column::data_type::varchar"),
 ]
 
-with open("src/lib/cell/cpp/row_insert_int_ops.h", "w") as out:
-   for cpptype, sqltype in primitive_types:
-      d = {"cpptype":cpptype,
-           "type":sqltype }
-      out.write(insert_case_txt.format(**d))
-
 with open("src/lib/cell/cpp/row_to_binary_int_ops.h", "w") as out:
    for cpptype, sqltype in primitive_types:
       d = {"cpptype":cpptype,
@@ -2,7 +2,8 @@
 #define __LATTICE_CELL_RANGE_H__
 
 #include <cstdint>
-#include <list>
+#include <iterator>
+#include <map>
 #include <utility>
 
 namespace lattice {
@@ -10,7 +11,12 @@ namespace common {
 
 /**
  * Implements a set of one dimensional segments. The class provides the
- * ability to test for coverage, and to add a point to the segment set.
+ * ability to test for coverage, and to add a point or a whole segment to
+ * the segment set.
+ *
+ * Segments never overlap or touch, and are kept in a balanced tree keyed
+ * on their first point, so that inserts and lookups take O(log n) in the
+ * number of segments.
  *
  * The type implemented for the range boundary must implement operator+(T,int),
  * operator-(T,int), operator<(T,T), and operator==(T,T).
@@ -19,9 +25,10 @@ template<typename T>
 class range
 {
 public:
-   typedef std::pair<T, T> value_type;
+   /** A segment: its first and last points. */
+   typedef std::pair<const T, T> value_type;
 
-   typedef std::list<value_type> range_list_type;
+   typedef std::map<T, T> range_list_type;
 
    typedef typename range_list_type::iterator iterator;
 
@@ -44,12 +51,12 @@ public:
 
    value_type& front()
    {
-      return segments.front();
+      return *segments.begin();
    }
 
    value_type& back()
    {
-      return segments.back();
+      return *segments.rbegin();
    }
 
    size_type size() const
@@ -63,42 +70,62 @@ public:
     *
     * @param point: The item to insert.
     *
+    * @returns: An iterator to the segment that now holds the point.
     */
    iterator insert(const T& point)
    {
-      using namespace std::rel_ops;
+      return insert(point, point);
+   }
+
+   /**
+    * Insert every point from 'first' to 'last' into the range. Segments
+    * that overlap or touch the new one are merged with it.
+    *
+    * @param first: The first point to insert.
+    * @param last: The last point to insert. Must not be less than first.
+    *
+    * @returns: An iterator to the segment that now holds the points.
+    */
+   iterator insert(const T& first, const T& last)
+   {
+      T low = first;
+      T high = last;
 
-      for (auto pos = segments.begin(); pos != segments.end(); ++pos)
+      // The segment starting at or before 'low' may reach it already.
+      auto pos = segments.upper_bound(low);
+      if (pos != segments.begin())
          {
-            auto& el = *pos;
-            if (el.first <= point && el.second >= point)
-               {
-                  // point is already contained in the range.
-                  return pos;
-               }
+            auto prev = std::prev(pos);
+            T reach = prev->second;
 
-            if (el.first - 1 == point)
+            if (!(reach + 1 < low))
                {
-                  // extend range to the left.
-                  el.first = point;
-                  return pos;
+                  if (!(reach < high))
+                     {
+                        // The points are already contained in the range.
+                        return prev;
+                     }
+
+                  low = prev->first;
+                  pos = prev;
                }
+         }
 
-            if (el.second + 1 == point)
-               {
-                  // extend range to the right
-                  el.second = point;
-                  return pos;
-               }
+      // Swallow the segments that start inside, or right after, the new one.
+      T after = high;
+      after = after + 1;
 
-            if (point < el.first)
+      while (pos != segments.end() && !(after < pos->first))
+         {
+            if (high < pos->second)
                {
-                  // range belongs before this element.
-                  return segments.insert(pos, std::make_pair(point, point));
+                  high = pos->second;
                }
+
+            pos = segments.erase(pos);
          }
 
-      return segments.emplace(segments.end(), point, point);
+      return segments.insert(pos, std::make_pair(low, high));
    }
 
    /**
@@ -110,9 +137,7 @@ public:
     */
    bool contains(const T& point)
    {
-      using namespace std::rel_ops;
-
-      return ! (find(point) == end());
+      return find(point) != end();
    }
 
    /**
@@ -126,23 +151,21 @@ public:
     */
    iterator find(const T& point)
    {
-      using namespace std::rel_ops;
-
-      for (auto pos = segments.begin(); pos!=segments.end(); ++pos)
+      // The segment starting at or before the point is the only one that
+      // may hold it.
+      auto pos = segments.upper_bound(point);
+      if (pos == segments.begin())
          {
-            auto& seg = *pos;
-            if (seg.first<=point && seg.second>=point)
-               {
-                  return pos;
-               }
+            return segments.end();
+         }
 
-            if (seg.first>point)
-               {
-                  return segments.end();
-               }
+      --pos;
+      if (pos->second < point)
+         {
+            return segments.end();
          }
 
-      return segments.end();
+      return pos;
    }
 
 };
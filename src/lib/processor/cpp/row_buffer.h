@@ -10,7 +10,9 @@
 #include <vector>
 
 #include <cell/cpp/column.h>
+#include <cell/cpp/column_batch.h>
 #include <cell/cpp/data_value.h>
+#include <cell/proto/commands.pb.h>
 
 #include <processor/cpp/metadata.h>
 #include <processor/proto/row.pb.h>
@@ -51,6 +53,19 @@ public:
 	 * is used in unpacking.
 	 */
 	typedef std::vector<cell::column> row_header_type;
+
+	/**
+	 * A columnar batch of rows from a cell, and the next row in it to
+	 * process.
+	 */
+	typedef struct
+	{
+		cell::ColumnBatch batch;
+		std::uint32_t next;
+	} batch_type;
+
+	/** Batches are processed in the order they arrived. */
+	typedef std::deque<batch_type> batch_queue_type;
 private:
 
 	/**
@@ -58,6 +73,11 @@ private:
 	 */
 	row_queue_type rows;
 
+	/**
+	 * The queue of batches to process, once the rows are done.
+	 */
+	batch_queue_type batches;
+
 	/**
 	 * Serializes access to the rows queue.
 	 */
@@ -102,6 +122,28 @@ public:
 			});
 	}
 
+	/**
+	 * Take a columnar batch of rows and enqueue it into the
+	 * buffer. The columns of the batch must match the header.
+	 *
+	 * @param batch: The batch to enqueue. Its contents are taken
+	 *               rather than copied.
+	 *
+	 * @notes: This method is thread safe.
+	 */
+	void enqueue(cell::ColumnBatch& batch)
+	{
+		if (batch.row_count() == 0)
+			{
+				return;
+			}
+
+		std::lock_guard < std::mutex > lock(rows_lock);
+		batches.emplace_back();
+		batches.back().batch.Swap(&batch);
+		batches.back().next = 0;
+	}
+
 	/**
 	 * Take the next item from the front of the queue
 	 * and unpack it into the current_row vector.
@@ -114,6 +156,12 @@ public:
 		row_type row;
 			{
 				std::lock_guard < std::mutex > lock(rows_lock);
+				if (rows.empty())
+					{
+						dequeue_batch_row();
+						return;
+					}
+
 				row = rows.front();
 				rows.pop_front();
 			}
@@ -142,6 +190,55 @@ public:
 		return current_row;
 	}
 
+private:
+	/**
+	 * Unpacks the next row of the front batch into the current row.
+	 * Each value is found from the row number, without reading the
+	 * rows before it. The caller holds rows_lock.
+	 */
+	void dequeue_batch_row()
+	{
+		auto& front = batches.front();
+		auto& batch = front.batch;
+		auto i = front.next;
+
+		current_row.clear();
+
+		for (std::size_t k = 0; k < header.size(); ++k)
+			{
+				auto type = header[k].type;
+				auto& column = batch.columns(k);
+				auto& nulls = column.nulls();
+
+				current_row.emplace_back(cell::data_value(type));
+
+				if (i / 8 < nulls.size() && (nulls[i / 8] >> (i % 8)) & 1)
+					{
+						continue;
+					}
+
+				auto* values = static_cast<const std::uint8_t*>(
+						static_cast<const void*>(column.values().data()));
+
+				auto width = cell::column_batch::fixed_width(type);
+				if (width != 0)
+					{
+						current_row.back().read(values + i * width);
+						continue;
+					}
+
+				auto first = column.offsets(i);
+				current_row.back().set_value(type,
+						std::string(column.values(), first,
+								column.offsets(i + 1) - first));
+			}
+
+		if (++front.next == batch.row_count())
+			{
+				batches.pop_front();
+			}
+	}
+
 };
 
 } // end namespace processor
@@ -0,0 +1,90 @@
+#include <cstdint>
+
+#include <cell/cpp/aggregate.h>
+#include <cell/cpp/data_value.h>
+
+#include <gtest/gtest.h>
+
+TEST(AggregateTest, CanMergePartials)
+{
+   using namespace lattice::cell;
+
+   typedef aggregate::function function;
+
+   aggregate::partial sum, min, max;
+
+   for (auto i : { 5, -3, 12 })
+      {
+         data_value v;
+         v.set_value(column::data_type::integer, i);
+
+         sum.add(function::SUM, v);
+         min.add(function::MIN, v);
+         max.add(function::MAX, v);
+      }
+
+   EXPECT_EQ(3, sum.get_count());
+   EXPECT_EQ(aggregate::partial::value_kind::INTEGER, sum.get_kind());
+   EXPECT_EQ(14, sum.get_int_value());
+   EXPECT_EQ(-3, min.get_int_value());
+   EXPECT_EQ(12, max.get_int_value());
+
+   // Another cell's results.
+   aggregate::partial other;
+   other.set(2, aggregate::partial::value_kind::INTEGER, -10, 0,
+         std::string());
+
+   sum.merge(function::SUM, other);
+   min.merge(function::MIN, other);
+   max.merge(function::MAX, other);
+
+   EXPECT_EQ(5, sum.get_count());
+   EXPECT_EQ(4, sum.get_int_value());
+   EXPECT_EQ(-10, min.get_int_value());
+   EXPECT_EQ(12, max.get_int_value());
+
+   // Merging nothing changes nothing but the count.
+   max.merge(function::MAX, aggregate::partial());
+   EXPECT_EQ(12, max.get_int_value());
+}
+
+TEST(AggregateTest, ComparesText)
+{
+   using namespace lattice::cell;
+
+   typedef aggregate::function function;
+
+   aggregate::partial min, max;
+
+   for (auto s : { "pear", "apple", "quince" })
+      {
+         data_value v;
+         v.set_value(column::data_type::varchar, std::string(s));
+
+         min.add(function::MIN, v);
+         max.add(function::MAX, v);
+      }
+
+   EXPECT_EQ("apple", min.get_text_value());
+   EXPECT_EQ("quince", max.get_text_value());
+}
+
+TEST(AggregateTest, HasOneGroupWithoutGrouping)
+{
+   using namespace lattice::cell;
+
+   aggregate agg(
+      {
+         {
+         aggregate::function::COUNT, aggregate::k_all_rows
+         }
+      }, {});
+
+   ASSERT_EQ(1, agg.get_groups().size());
+   EXPECT_EQ(0, agg.get_groups().begin()->second[0].get_count());
+
+   // COUNT(*) needs no columns.
+   auto present = agg.start(3);
+   EXPECT_EQ(3, present.size());
+   EXPECT_FALSE(present[0] || present[1] || present[2]);
+}
@@ -0,0 +1,49 @@
+#include <cstdint>
+#include <cstring>
+
+#include <cell/cpp/column_batch.h>
+
+#include <gtest/gtest.h>
+
+TEST(ColumnBatchTest, CanDiscardRow)
+{
+   using namespace lattice::cell;
+
+   column_batch batch;
+   batch.add_column(0, column::data_type::integer);
+   batch.add_column(1, column::data_type::varchar);
+
+   std::uint8_t value[sizeof(column_batch::offset_type) + 2];
+   column_batch::offset_type size = 2;
+   std::memcpy(value, &size, sizeof(size));
+   std::memcpy(value + sizeof(size), "ab", 2);
+
+   std::int32_t id = 7;
+   batch.append_value(0, static_cast<const std::uint8_t*>(
+         static_cast<const void*>(&id)));
+   batch.append_value(1, value);
+   batch.end_row();
+
+   // The second row only gets part of the way.
+   batch.append_null(0);
+   batch.append_value(1, value);
+   batch.discard_row();
+
+   auto& columns = batch.get_columns();
+   EXPECT_EQ(1, batch.get_row_count());
+   EXPECT_EQ(sizeof(id), columns[0].values.size());
+   EXPECT_FALSE(column_batch::is_null(columns[0], 1));
+   EXPECT_EQ("ab", columns[1].values);
+   EXPECT_EQ(2, columns[1].offsets.size());
+
+   // The next row goes where the discarded one was.
+   batch.append_value(0, static_cast<const std::uint8_t*>(
+         static_cast<const void*>(&id)));
+   batch.append_null(1);
+   batch.end_row();
+
+   EXPECT_EQ(2 * sizeof(id), columns[0].values.size());
+   EXPECT_FALSE(column_batch::is_null(columns[0], 1));
+   EXPECT_TRUE(column_batch::is_null(columns[1], 1));
+   EXPECT_EQ(3, columns[1].offsets.size());
+}
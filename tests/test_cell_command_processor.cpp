@@ -189,3 +189,619 @@ TEST(CellCmdProcessorTest, CanExecuteFetch)
 
 }
 
+TEST(CellCmdProcessorTest, CanProjectColumns)
+{
+   using namespace lattice::cell;
+
+   command_processor cp;
+
+   cp.create_table("test_table_1",
+      {
+      new lattice::cell::column
+         {
+         lattice::cell::column::data_type::integer, "id", 4
+         }, new lattice::cell::column
+         {
+         lattice::cell::column::data_type::bigint, "c1", 8
+         },
+      });
+
+   auto tbl_id = cp.get_database().get_table_id("test_table_1");
+   auto t = cp.get_database().get_table(tbl_id);
+
+   CommandRequest request;
+
+   request.set_kind(CommandRequest::PREPARE);
+
+   auto* msg = request.mutable_prepare();
+   msg->set_create_transaction(true);
+   msg->add_cursors("test_table_1");
+
+   auto resp = cp.process(request);
+   auto txn_id = resp.prepare().transaction_id();
+   auto cursor_id = resp.prepare().cursor_ids(0);
+
+   table::text_tuple_type text_data
+      {
+      "123", "1234567890"
+      };
+
+   // Only the second column is sent. Bits past the last column are
+   // ignored.
+   std::string buffer;
+   t->to_binary(
+      {
+      false, true
+      }, text_data, buffer);
+
+   CommandRequest request2;
+
+   request2.set_kind(CommandRequest::INSERT);
+   auto* msg2 = request2.mutable_insert();
+
+   msg2->set_transaction_id(txn_id);
+   msg2->set_table_id(tbl_id);
+   msg2->set_column_mask(0xf0000002);
+   msg2->add_data(buffer);
+
+   auto resp2 = cp.process(request2);
+   EXPECT_EQ(1, resp2.insert().row_count());
+
+   // Ask for the second column only.
+   CommandRequest request3;
+
+   request3.set_kind(CommandRequest::FETCH);
+   auto* msg3 = request3.mutable_fetch();
+
+   msg3->set_transaction_id(txn_id);
+   msg3->add_cursors(cursor_id);
+   msg3->add_batch_size(1);
+   msg3->add_column_mask(0x2);
+
+   auto resp3 = cp.process(request3);
+
+   ASSERT_EQ(1, resp3.fetch().data_size());
+   EXPECT_EQ(buffer, resp3.fetch().data(0));
+
+   // Unknown cursors fetch nothing.
+   msg3->set_cursors(0, cursor_id + 1);
+
+   resp3 = cp.process(request3);
+   EXPECT_EQ(0, resp3.fetch().data_size());
+   EXPECT_EQ(0, resp3.fetch().batch_size(0));
+
+   // Insert a row with only the first column, and read both columns back.
+   // Columns without a value read as zero.
+   std::string first_only;
+   t->to_binary(
+      {
+      true, false
+      }, text_data, first_only);
+
+   msg2->set_column_mask(0x1);
+   msg2->set_data(0, first_only);
+
+   resp2 = cp.process(request2);
+   EXPECT_EQ(1, resp2.insert().row_count());
+
+   msg3->set_cursors(0, cp.create_cursor(txn_id, tbl_id));
+   msg3->set_batch_size(0, 2);
+   msg3->set_column_mask(0, 0x3);
+
+   resp3 = cp.process(request3);
+
+   ASSERT_EQ(2, resp3.fetch().data_size());
+   EXPECT_EQ(std::string(4, '\0') + buffer, resp3.fetch().data(0));
+   EXPECT_EQ(first_only + std::string(8, '\0'), resp3.fetch().data(1));
+}
+
+TEST(CellCmdProcessorTest, CanFilterFetches)
+{
+   using namespace lattice::cell;
+
+   command_processor cp;
+
+   cp.create_table("test_table_1",
+      {
+      new lattice::cell::column
+         {
+         lattice::cell::column::data_type::integer, "id", 4
+         }, new lattice::cell::column
+         {
+         lattice::cell::column::data_type::varchar, "name"
+         },
+      });
+
+   auto tbl_id = cp.get_database().get_table_id("test_table_1");
+   auto t = cp.get_database().get_table(tbl_id);
+
+   auto txn_id = cp.create_transaction();
+
+   for (auto i = 0; i < 10; ++i)
+      {
+         std::string buffer;
+         t->to_binary(
+            {
+            true, true
+            },
+            {
+            std::to_string(i), i % 2 ? "odd" : "even"
+            }, buffer);
+
+         cp.insert_columns(txn_id, tbl_id, { 0, 1 }, buffer);
+      }
+
+   cp.commit_transaction(txn_id);
+
+   CommandRequest request;
+
+   request.set_kind(CommandRequest::PREPARE);
+
+   auto* msg = request.mutable_prepare();
+   msg->set_create_transaction(true);
+   msg->add_cursors("test_table_1");
+   msg->add_cursors("test_table_1");
+
+   auto resp = cp.process(request);
+   txn_id = resp.prepare().transaction_id();
+
+   CommandRequest request2;
+
+   request2.set_kind(CommandRequest::FETCH);
+
+   auto* msg2 = request2.mutable_fetch();
+   msg2->set_transaction_id(txn_id);
+
+   // id < 2 OR name IN ('odd') AND 3 <= id <= 6, that is 0, 1, 3 and 5.
+   msg2->add_cursors(resp.prepare().cursor_ids(0));
+   msg2->add_batch_size(100);
+   msg2->add_column_mask(0x1);
+
+   auto* filter = msg2->add_filter();
+   filter->set_kind(Predicate::OR);
+
+   auto* less = filter->add_children();
+   less->set_kind(Predicate::COMPARE);
+   less->set_column(0);
+   less->set_comparison(Predicate::LESS);
+   less->add_values("2");
+
+   auto* both = filter->add_children();
+   both->set_kind(Predicate::AND);
+
+   auto* odd = both->add_children();
+   odd->set_kind(Predicate::IN_LIST);
+   odd->set_column(1);
+   odd->add_values("odd");
+
+   auto* between = both->add_children();
+   between->set_kind(Predicate::COMPARE);
+   between->set_column(0);
+   between->set_comparison(Predicate::BETWEEN);
+   between->add_values("3");
+   between->add_values("6");
+
+   // A predicate on a column the table does not have fetches nothing.
+   msg2->add_cursors(resp.prepare().cursor_ids(1));
+   msg2->add_batch_size(100);
+   msg2->add_column_mask(0x1);
+
+   auto* bad = msg2->add_filter();
+   bad->set_kind(Predicate::COMPARE);
+   bad->set_column(5);
+   bad->add_values("1");
+
+   auto resp2 = cp.process(request2);
+
+   ASSERT_EQ(2, resp2.fetch().batch_size_size());
+   EXPECT_EQ(4, resp2.fetch().batch_size(0));
+   EXPECT_EQ(0, resp2.fetch().batch_size(1));
+   ASSERT_EQ(4, resp2.fetch().data_size());
+
+   for (auto i = 0; i < 4; ++i)
+      {
+         std::string expected;
+         t->to_binary(
+            {
+            true
+            },
+            {
+            std::to_string(i < 2 ? i : 2 * i - 1)
+            }, expected);
+
+         EXPECT_EQ(expected, resp2.fetch().data(i));
+      }
+}
+
+TEST(CellCmdProcessorTest, CanFetchColumnar)
+{
+   using namespace lattice::cell;
+
+   command_processor cp;
+
+   cp.create_table("test_table_1",
+      {
+      new lattice::cell::column
+         {
+         lattice::cell::column::data_type::integer, "id", 4
+         }, new lattice::cell::column
+         {
+         lattice::cell::column::data_type::varchar, "name"
+         },
+      });
+
+   auto tbl_id = cp.get_database().get_table_id("test_table_1");
+   auto t = cp.get_database().get_table(tbl_id);
+
+   auto txn_id = cp.create_transaction();
+
+   // The second row has no name.
+   for (auto i = 0; i < 3; ++i)
+      {
+         std::vector<bool> present
+            {
+            true, i != 1
+            };
+
+         std::string buffer;
+         t->to_binary(present,
+            {
+            std::to_string(i), std::string(i + 1, 'x')
+            }, buffer);
+
+         cp.insert_columns(txn_id, tbl_id, i != 1 ?
+            std::vector<int> { 0, 1 } : std::vector<int> { 0 }, buffer);
+      }
+
+   auto cursor_id = cp.create_cursor(txn_id, tbl_id);
+
+   CommandRequest request;
+
+   request.set_kind(CommandRequest::FETCH);
+
+   auto* msg = request.mutable_fetch();
+   msg->set_transaction_id(txn_id);
+   msg->set_columnar(true);
+   msg->add_cursors(cursor_id);
+   msg->add_batch_size(100);
+   msg->add_column_mask(0x3);
+
+   auto resp = cp.process(request);
+   auto& fetch = resp.fetch();
+
+   EXPECT_EQ(0, fetch.data_size());
+   ASSERT_EQ(1, fetch.batches_size());
+   EXPECT_EQ(3, fetch.batch_size(0));
+
+   auto& batch = fetch.batches(0);
+
+   EXPECT_EQ(cursor_id, batch.cursor());
+   EXPECT_EQ(3, batch.row_count());
+   ASSERT_EQ(2, batch.columns_size());
+
+   auto& ids = batch.columns(0);
+   ASSERT_EQ(3 * sizeof(std::int32_t), ids.values().size());
+   EXPECT_FALSE(ids.has_nulls());
+
+   auto* id_values = static_cast<const std::int32_t*>(
+         static_cast<const void*>(ids.values().data()));
+   EXPECT_EQ(0, id_values[0]);
+   EXPECT_EQ(1, id_values[1]);
+   EXPECT_EQ(2, id_values[2]);
+
+   auto& names = batch.columns(1);
+   EXPECT_EQ(1, names.column());
+   EXPECT_EQ("xxxx", names.values());
+   ASSERT_EQ(4, names.offsets_size());
+   EXPECT_EQ(0, names.offsets(0));
+   EXPECT_EQ(1, names.offsets(1));
+   EXPECT_EQ(1, names.offsets(2));
+   EXPECT_EQ(4, names.offsets(3));
+   EXPECT_EQ(std::string(1, '\x02'), names.nulls());
+}
+
+TEST(CellCmdProcessorTest, CanAggregate)
+{
+   using namespace lattice::cell;
+
+   command_processor cp;
+
+   cp.create_table("test_table_1",
+      {
+      new lattice::cell::column
+         {
+         lattice::cell::column::data_type::integer, "id", 4
+         }, new lattice::cell::column
+         {
+         lattice::cell::column::data_type::varchar, "name"
+         },
+      });
+
+   auto tbl_id = cp.get_database().get_table_id("test_table_1");
+   auto t = cp.get_database().get_table(tbl_id);
+
+   auto txn_id = cp.create_transaction();
+
+   for (auto i = 0; i < 10; ++i)
+      {
+         std::string buffer;
+         t->to_binary(
+            {
+            true, true
+            },
+            {
+            std::to_string(i), i % 2 ? "odd" : "even"
+            }, buffer);
+
+         cp.insert_columns(txn_id, tbl_id, { 0, 1 }, buffer);
+      }
+
+   CommandRequest request;
+
+   request.set_kind(CommandRequest::AGGREGATE);
+
+   auto* msg = request.mutable_aggregate();
+   msg->set_transaction_id(txn_id);
+   msg->set_cursor(cp.create_cursor(txn_id, tbl_id));
+
+   // SELECT count(*), sum(id), min(id), avg(id) ... GROUP BY name
+   msg->add_terms()->set_function(CommandRequest::Aggregate::COUNT);
+
+   auto* sum = msg->add_terms();
+   sum->set_function(CommandRequest::Aggregate::SUM);
+   sum->set_column(0);
+
+   auto* min = msg->add_terms();
+   min->set_function(CommandRequest::Aggregate::MIN);
+   min->set_column(0);
+
+   auto* avg = msg->add_terms();
+   avg->set_function(CommandRequest::Aggregate::AVG);
+   avg->set_column(0);
+
+   msg->add_group_by(1);
+
+   auto resp = cp.process(request);
+
+   ASSERT_EQ(CommandResponse::AGGREGATE, resp.kind());
+   ASSERT_EQ(2, resp.aggregate().groups_size());
+
+   for (auto& group : resp.aggregate().groups())
+      {
+         ASSERT_EQ(1, group.key_size());
+         ASSERT_EQ(4, group.partials_size());
+
+         data_value name(column::data_type::varchar);
+         name.read(static_cast<const std::uint8_t*>(
+               static_cast<const void*>(group.key(0).data())));
+
+         auto odd = *name.raw_string_value() == "odd";
+
+         EXPECT_EQ(5, group.partials(0).count());
+         EXPECT_EQ(odd ? 25 : 20, group.partials(1).int_value());
+         EXPECT_EQ(odd ? 1 : 0, group.partials(2).int_value());
+         EXPECT_EQ(5, group.partials(3).count());
+         EXPECT_EQ(odd ? 25 : 20, group.partials(3).int_value());
+      }
+
+   // Only the rows that match the filter are aggregated.
+   msg->set_cursor(cp.create_cursor(txn_id, tbl_id));
+   msg->clear_group_by();
+
+   auto* filter = msg->mutable_filter();
+   filter->set_kind(Predicate::COMPARE);
+   filter->set_column(0);
+   filter->set_comparison(Predicate::GREATER_EQUAL);
+   filter->add_values("7");
+
+   resp = cp.process(request);
+
+   ASSERT_EQ(1, resp.aggregate().groups_size());
+   EXPECT_EQ(3, resp.aggregate().groups(0).partials(0).count());
+   EXPECT_EQ(24, resp.aggregate().groups(0).partials(1).int_value());
+
+   // The cursor is used up now.
+   resp = cp.process(request);
+   ASSERT_EQ(1, resp.aggregate().groups_size());
+   EXPECT_EQ(0, resp.aggregate().groups(0).partials(0).count());
+   EXPECT_FALSE(resp.aggregate().groups(0).partials(1).has_int_value());
+
+   // Summing text is not allowed.
+   sum->set_column(1);
+   resp = cp.process(request);
+   EXPECT_EQ(0, resp.aggregate().groups_size());
+}
+
+TEST(CellCmdProcessorTest, CanCommit)
+{
+   using namespace lattice::cell;
+
+   command_processor cp;
+
+   auto first = cp.create_transaction();
+   auto second = cp.create_transaction();
+
+   // Both began before anything committed.
+   EXPECT_EQ(0, cp.get_low_watermark());
+
+   CommandRequest request;
+
+   request.set_kind(CommandRequest::COMMIT);
+   request.mutable_commit()->set_transaction_id(first);
+
+   auto resp = cp.process(request);
+
+   ASSERT_EQ(CommandResponse::COMMIT, resp.kind());
+   EXPECT_EQ(first, resp.commit().transaction_id());
+   EXPECT_TRUE(resp.commit().committed());
+
+   EXPECT_EQ(0, cp.get_low_watermark());
+
+   // It is gone now.
+   resp = cp.process(request);
+   EXPECT_FALSE(resp.commit().committed());
+
+   EXPECT_TRUE(cp.commit_transaction(second));
+   EXPECT_EQ(2, cp.get_low_watermark());
+
+   // New transactions begin after both commits.
+   cp.create_transaction();
+   EXPECT_EQ(2, cp.get_low_watermark());
+}
+
+TEST(CellCmdProcessorTest, CanCommitInGroups)
+{
+   using namespace lattice::cell;
+
+   command_processor cp;
+
+   std::vector<CommandRequest> requests;
+
+   for (auto i = 0; i < 3; ++i)
+      {
+         CommandRequest request;
+
+         request.set_kind(CommandRequest::COMMIT);
+         request.mutable_commit()->set_transaction_id(cp.create_transaction());
+         requests.push_back(request);
+      }
+
+   // Committing the same transaction twice in a batch only works once.
+   requests.push_back(requests.back());
+
+   auto responses = cp.process(requests);
+
+   ASSERT_EQ(4, responses.size());
+   EXPECT_TRUE(responses[0].commit().committed());
+   EXPECT_TRUE(responses[1].commit().committed());
+   EXPECT_TRUE(responses[2].commit().committed());
+   EXPECT_FALSE(responses[3].commit().committed());
+
+   // The whole group committed at one time.
+   EXPECT_EQ(1, cp.get_low_watermark());
+
+   // Nothing is left waiting.
+   EXPECT_EQ(0, cp.commit_group());
+}
+
+TEST(CellCmdProcessorTest, CanPrepareReadOnly)
+{
+   using namespace lattice::cell;
+
+   command_processor cp;
+
+   cp.create_table("test_table_1",
+      {
+      new lattice::cell::column
+         {
+         lattice::cell::column::data_type::integer, "id", 4
+         },
+      });
+
+   auto table_id = cp.get_database().get_table_id("test_table_1");
+
+   CommandRequest request;
+
+   request.set_kind(CommandRequest::PREPARE);
+
+   auto* msg = request.mutable_prepare();
+
+   msg->set_create_transaction(true);
+   msg->set_isolation_level(CommandRequest::Prepare::SERIALIZABLE);
+   msg->set_read_only(true);
+
+   auto reader = cp.process(request).prepare().transaction_id();
+
+   // Read only transactions never make a snapshot unsafe.
+   EXPECT_FALSE(cp.has_serializable_writers());
+
+   EXPECT_FALSE(cp.insert_columns(reader, table_id, { 0 }, std::string()));
+
+   auto writer = cp.create_transaction(isolation_level::SERIALIZABLE);
+   EXPECT_TRUE(cp.has_serializable_writers());
+
+   // A writer waiting for its group to commit is still running.
+   EXPECT_TRUE(cp.queue_commit(writer));
+   EXPECT_TRUE(cp.has_serializable_writers());
+
+   EXPECT_EQ(1, cp.commit_group());
+   EXPECT_FALSE(cp.has_serializable_writers());
+}
+
+TEST(CellCmdProcessorTest, CanInsertColumnar)
+{
+   using namespace lattice::cell;
+
+   command_processor cp;
+
+   cp.create_table("test_table_1",
+      {
+      new lattice::cell::column
+         {
+         lattice::cell::column::data_type::integer, "id", 4
+         }, new lattice::cell::column
+         {
+         lattice::cell::column::data_type::varchar, "name"
+         },
+      });
+
+   auto tbl_id = cp.get_database().get_table_id("test_table_1");
+   auto txn_id = cp.create_transaction();
+
+   std::int32_t ids[] = { 1, 2, 3 };
+
+   CommandRequest request;
+
+   request.set_kind(CommandRequest::INSERT);
+
+   auto* msg = request.mutable_insert();
+   msg->set_transaction_id(txn_id);
+   msg->set_table_id(tbl_id);
+   msg->set_column_mask(0);
+
+   auto* rows = msg->mutable_rows();
+   rows->set_cursor(0);
+   rows->set_row_count(3);
+
+   auto* id_column = rows->add_columns();
+   id_column->set_column(0);
+   id_column->set_values(ids, sizeof(ids));
+
+   // The second row has no name.
+   auto* name_column = rows->add_columns();
+   name_column->set_column(1);
+   name_column->set_values("xxxxx");
+   for (auto offset : { 0, 2, 2, 5 })
+      {
+         name_column->add_offsets(offset);
+      }
+   name_column->set_nulls(std::string(1, '\x02'));
+
+   EXPECT_EQ(3, cp.process(request).insert().row_count());
+
+   // The rows read back as they went in.
+   CommandRequest fetch_request;
+
+   fetch_request.set_kind(CommandRequest::FETCH);
+
+   auto* fetch_msg = fetch_request.mutable_fetch();
+   fetch_msg->set_transaction_id(txn_id);
+   fetch_msg->set_columnar(true);
+   fetch_msg->add_cursors(cp.create_cursor(txn_id, tbl_id));
+   fetch_msg->add_batch_size(100);
+   fetch_msg->add_column_mask(0x3);
+
+   auto resp = cp.process(fetch_request);
+   ASSERT_EQ(1, resp.fetch().batches_size());
+
+   auto& batch = resp.fetch().batches(0);
+   EXPECT_EQ(3, batch.row_count());
+   ASSERT_EQ(2, batch.columns_size());
+   EXPECT_EQ(id_column->values(), batch.columns(0).values());
+   EXPECT_EQ(name_column->values(), batch.columns(1).values());
+   EXPECT_EQ(name_column->nulls(), batch.columns(1).nulls());
+
+   // A column the table does not have inserts nothing.
+   rows->add_columns()->set_column(5);
+   EXPECT_EQ(0, cp.process(request).insert().row_count());
+}
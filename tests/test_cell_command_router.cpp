@@ -0,0 +1,373 @@
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+
+#include <cell/cpp/command_router.h>
+
+#include <gtest/gtest.h>
+
+TEST(CellCmdRouterTest, CanCreateTable)
+{
+   using namespace lattice::cell;
+
+   command_router router(4);
+
+   ASSERT_EQ(4, router.size());
+   EXPECT_TRUE(router.create_table("test_table_1",
+      {
+      new column
+         {
+         column::data_type::integer, "id", 4
+         }
+      }));
+
+   // Every cell has the table, with the same id.
+   auto table_id = router.get_table_id("test_table_1");
+   for (command_router::size_type i = 0; i < router.size(); ++i)
+      {
+         router.with_cell(i, [&](command_processor& cp)
+            {
+               EXPECT_EQ(table_id, cp.get_database().get_table_id("test_table_1"));
+            });
+      }
+}
+
+TEST(CellCmdRouterTest, CanPartitionAndScan)
+{
+   using namespace lattice::cell;
+
+   command_router router(4);
+
+   router.create_table("test_table_1",
+      {
+      new column
+         {
+         column::data_type::integer, "id", 4
+         }
+      });
+
+   auto table_id = router.get_table_id("test_table_1");
+
+   // Open a transaction and insert some rows.
+   CommandRequest request;
+   request.set_kind(CommandRequest::PREPARE);
+   request.mutable_prepare()->set_create_transaction(true);
+
+   auto txn_id = router.process(request).prepare().transaction_id();
+
+   table t(0, 1);
+   t.set_column_definition(0, new column
+      {
+      column::data_type::integer, "id", 4
+      });
+
+   const auto k_rows = 100;
+
+   CommandRequest insert;
+   insert.set_kind(CommandRequest::INSERT);
+   insert.mutable_insert()->set_transaction_id(txn_id);
+   insert.mutable_insert()->set_table_id(table_id);
+   insert.mutable_insert()->set_column_mask(0x1);
+
+   for (auto i = 0; i < k_rows; ++i)
+      {
+         std::string buffer;
+         t.to_binary({ true }, { std::to_string(i) }, buffer);
+         insert.mutable_insert()->add_data(buffer);
+      }
+
+   auto resp = router.process(insert);
+   EXPECT_EQ(k_rows, resp.insert().row_count());
+
+   CommandRequest commit;
+   commit.set_kind(CommandRequest::COMMIT);
+   commit.mutable_commit()->set_transaction_id(txn_id);
+
+   EXPECT_TRUE(router.process(commit).commit().committed());
+   EXPECT_FALSE(router.process(commit).commit().committed());
+
+   // The rows were spread over more than one cell.
+   command_router::size_type cells_used = 0;
+   for (command_router::size_type i = 0; i < router.size(); ++i)
+      {
+         router.with_cell(i, [&](command_processor& cp)
+            {
+               auto t = cp.get_database().get_table(table_id);
+               if (t->begin() != t->end())
+                  {
+                     ++cells_used;
+                  }
+            });
+      }
+
+   EXPECT_LT(1, cells_used);
+
+   // A scan sees every row, from every cell.
+   request.mutable_prepare()->add_cursors("test_table_1");
+   resp = router.process(request);
+
+   auto scan_txn_id = resp.prepare().transaction_id();
+   auto cursor_id = resp.prepare().cursor_ids(0);
+
+   CommandRequest fetch;
+   fetch.set_kind(CommandRequest::FETCH);
+   fetch.mutable_fetch()->set_transaction_id(scan_txn_id);
+   fetch.mutable_fetch()->add_cursors(cursor_id);
+   fetch.mutable_fetch()->add_batch_size(30);
+   fetch.mutable_fetch()->add_column_mask(0x1);
+
+   std::size_t fetched = 0;
+   for (auto i = 0; i < 5; ++i)
+      {
+         resp = router.process(fetch);
+         ASSERT_EQ(resp.fetch().data_size(), resp.fetch().batch_size(0));
+         fetched += resp.fetch().data_size();
+      }
+
+   EXPECT_EQ(k_rows, fetched);
+
+   // A columnar scan gets a batch from each cell with rows.
+   resp = router.process(request);
+
+   fetch.mutable_fetch()->set_transaction_id(resp.prepare().transaction_id());
+   fetch.mutable_fetch()->set_cursors(0, resp.prepare().cursor_ids(0));
+   fetch.mutable_fetch()->set_batch_size(0, k_rows * 2);
+   fetch.mutable_fetch()->set_columnar(true);
+
+   resp = router.process(fetch);
+
+   EXPECT_EQ(0, resp.fetch().data_size());
+   EXPECT_EQ(k_rows, resp.fetch().batch_size(0));
+   EXPECT_EQ(cells_used, resp.fetch().batches_size());
+
+   fetched = 0;
+   for (auto& batch : resp.fetch().batches())
+      {
+         EXPECT_EQ(cursor_id, batch.cursor());
+         fetched += batch.row_count();
+      }
+
+   EXPECT_EQ(k_rows, fetched);
+
+   // Every cell counts and sums its own rows, and the results are merged.
+   resp = router.process(request);
+
+   CommandRequest aggregate;
+   aggregate.set_kind(CommandRequest::AGGREGATE);
+
+   auto* msg = aggregate.mutable_aggregate();
+   msg->set_transaction_id(resp.prepare().transaction_id());
+   msg->set_cursor(resp.prepare().cursor_ids(0));
+   msg->add_terms()->set_function(CommandRequest::Aggregate::COUNT);
+
+   auto* sum = msg->add_terms();
+   sum->set_function(CommandRequest::Aggregate::SUM);
+   sum->set_column(0);
+
+   auto* max = msg->add_terms();
+   max->set_function(CommandRequest::Aggregate::MAX);
+   max->set_column(0);
+
+   resp = router.process(aggregate);
+
+   ASSERT_EQ(1, resp.aggregate().groups_size());
+
+   auto& partials = resp.aggregate().groups(0).partials();
+   EXPECT_EQ(k_rows, partials.Get(0).count());
+   EXPECT_EQ(k_rows * (k_rows - 1) / 2, partials.Get(1).int_value());
+   EXPECT_EQ(k_rows - 1, partials.Get(2).int_value());
+}
+
+TEST(CellCmdRouterTest, CanInsertBatches)
+{
+   using namespace lattice::cell;
+
+   command_router router(2);
+
+   router.create_table("test_table_1",
+      {
+      new column
+         {
+         column::data_type::integer, "id", 4
+         }
+      });
+
+   auto table_id = router.get_table_id("test_table_1");
+
+   CommandRequest request;
+   request.set_kind(CommandRequest::PREPARE);
+   request.mutable_prepare()->set_create_transaction(true);
+
+   auto txn_id = router.process(request).prepare().transaction_id();
+
+   std::int32_t ids[] = { 1, 2, 3, 4, 5 };
+
+   CommandRequest insert;
+   insert.set_kind(CommandRequest::INSERT);
+   insert.mutable_insert()->set_transaction_id(txn_id);
+   insert.mutable_insert()->set_table_id(table_id);
+   insert.mutable_insert()->set_column_mask(0);
+
+   auto* rows = insert.mutable_insert()->mutable_rows();
+   rows->set_cursor(0);
+   rows->set_row_count(5);
+
+   auto* column = rows->add_columns();
+   column->set_column(0);
+   column->set_values(ids, sizeof(ids));
+
+   // Each batch goes whole to one cell, and the cells take turns.
+   EXPECT_EQ(5, router.process(insert).insert().row_count());
+   EXPECT_EQ(5, router.process(insert).insert().row_count());
+
+   for (command_router::size_type i = 0; i < router.size(); ++i)
+      {
+         router.with_cell(i, [&](command_processor& cp)
+            {
+               auto t = cp.get_database().get_table(table_id);
+
+               std::size_t count = 0;
+               for (auto pos = t->begin(); pos != t->end(); ++pos)
+                  {
+                     ++count;
+                  }
+
+               EXPECT_EQ(5, count);
+            });
+      }
+}
+
+TEST(CellCmdRouterTest, RunsEachCellOnItsOwnThread)
+{
+   using namespace lattice::cell;
+
+   command_router router(4);
+
+   // Every cell is busy at once, so they must be on different threads.
+   std::mutex lock;
+   std::condition_variable all_started;
+   command_router::size_type started = 0;
+   std::set<std::thread::id> threads;
+
+   std::vector<std::future<bool>> pending;
+   for (command_router::size_type i = 0; i < router.size(); ++i)
+      {
+         pending.push_back(router.post(i, [&](command_processor&)
+            {
+               std::unique_lock<std::mutex> l(lock);
+               threads.insert(std::this_thread::get_id());
+               ++started;
+               all_started.notify_all();
+               return all_started.wait_for(l, std::chrono::seconds(10), [&]()
+                  {
+                     return started == router.size();
+                  });
+            }));
+      }
+
+   for (auto& p : pending)
+      {
+         EXPECT_TRUE(p.get());
+      }
+
+   EXPECT_EQ(router.size(), threads.size());
+   EXPECT_EQ(0, threads.count(std::this_thread::get_id()));
+}
+
+TEST(CellCmdRouterTest, CanFetchManyCursors)
+{
+   using namespace lattice::cell;
+
+   command_router router(3);
+
+   router.create_table("test_table_1",
+      {
+      new column
+         {
+         column::data_type::integer, "id", 4
+         }
+      });
+
+   auto table_id = router.get_table_id("test_table_1");
+
+   CommandRequest request;
+   request.set_kind(CommandRequest::PREPARE);
+   request.mutable_prepare()->set_create_transaction(true);
+
+   auto txn_id = router.process(request).prepare().transaction_id();
+
+   table t(0, 1);
+   t.set_column_definition(0, new column
+      {
+      column::data_type::integer, "id", 4
+      });
+
+   const auto k_rows = 50;
+
+   CommandRequest insert;
+   insert.set_kind(CommandRequest::INSERT);
+   insert.mutable_insert()->set_transaction_id(txn_id);
+   insert.mutable_insert()->set_table_id(table_id);
+   insert.mutable_insert()->set_column_mask(0x1);
+
+   for (auto i = 0; i < k_rows; ++i)
+      {
+         std::string buffer;
+         t.to_binary({ true }, { std::to_string(i) }, buffer);
+         insert.mutable_insert()->add_data(buffer);
+      }
+
+   EXPECT_EQ(k_rows, router.process(insert).insert().row_count());
+
+   CommandRequest commit;
+   commit.set_kind(CommandRequest::COMMIT);
+   commit.mutable_commit()->set_transaction_id(txn_id);
+   EXPECT_TRUE(router.process(commit).commit().committed());
+
+   // Two cursors over the same table are scanned side by side, and their
+   // rows come back in the order the cursors were asked for.
+   request.mutable_prepare()->add_cursors("test_table_1");
+   request.mutable_prepare()->add_cursors("test_table_1");
+   auto resp = router.process(request);
+
+   CommandRequest fetch;
+   fetch.set_kind(CommandRequest::FETCH);
+
+   auto* msg = fetch.mutable_fetch();
+   msg->set_transaction_id(resp.prepare().transaction_id());
+   msg->add_cursors(resp.prepare().cursor_ids(1));
+   msg->add_batch_size(k_rows);
+   msg->add_column_mask(0x1);
+   msg->add_cursors(resp.prepare().cursor_ids(0));
+   msg->add_batch_size(7);
+   msg->add_column_mask(0x1);
+
+   resp = router.process(fetch);
+
+   ASSERT_EQ(2, resp.fetch().cursors_size());
+   EXPECT_EQ(msg->cursors(0), resp.fetch().cursors(0));
+   EXPECT_EQ(msg->cursors(1), resp.fetch().cursors(1));
+   EXPECT_EQ(k_rows, resp.fetch().batch_size(0));
+   EXPECT_EQ(7, resp.fetch().batch_size(1));
+   EXPECT_EQ(k_rows + 7, resp.fetch().data_size());
+
+   // The first cursor's rows come first, and the second cursor carries on
+   // where it stopped.
+   std::set<std::string> rows(resp.fetch().data().begin(),
+         resp.fetch().data().begin() + k_rows);
+   EXPECT_EQ(k_rows, rows.size());
+
+   msg->clear_cursors();
+   msg->clear_batch_size();
+   msg->clear_column_mask();
+   msg->add_cursors(resp.fetch().cursors(1));
+   msg->add_batch_size(k_rows);
+   msg->add_column_mask(0x1);
+
+   resp = router.process(fetch);
+   EXPECT_EQ(k_rows - 7, resp.fetch().batch_size(0));
+}
@@ -0,0 +1,156 @@
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <cell/cpp/compare_kernels.h>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+
+using namespace lattice::cell;
+
+template<typename T>
+bool expected(compare_op op, T x, T low, T high)
+{
+  switch (op)
+    {
+    case compare_op::EQUAL:
+      return x == low;
+    case compare_op::NOT_EQUAL:
+      return x != low;
+    case compare_op::LESS:
+      return x < low;
+    case compare_op::LESS_EQUAL:
+      return x <= low;
+    case compare_op::GREATER:
+      return x > low;
+    case compare_op::GREATER_EQUAL:
+      return x >= low;
+    case compare_op::BETWEEN:
+      return low <= x && x <= high;
+    }
+
+  return false;
+}
+
+/**
+ * Runs every comparison at every level over arrays of awkward lengths and
+ * offsets, and checks each bit against plain C++.
+ */
+template<typename T>
+void check_all(const std::vector<T>& values, T low, T high)
+{
+  const compare_op ops[] = { compare_op::EQUAL, compare_op::NOT_EQUAL,
+      compare_op::LESS, compare_op::LESS_EQUAL, compare_op::GREATER,
+      compare_op::GREATER_EQUAL, compare_op::BETWEEN };
+  const simd_level levels[] = { simd_level::SCALAR, simd_level::SSE2,
+      simd_level::AVX2 };
+
+  std::vector<std::uint8_t> references(values.size());
+  for (std::size_t i = 0; i < references.size(); ++i)
+    {
+      references[i] = i % 7 == 3 ? 0 : 1;
+    }
+
+  auto original = get_simd_level();
+
+  for (auto level : levels)
+    {
+      set_simd_level(level);
+
+      for (auto op : ops)
+        {
+          for (std::size_t offset : { 0, 1, 5 })
+            {
+              for (std::size_t n : { 0, 1, 63, 64, 65, 130, 1000 })
+                {
+                  if (offset + n > values.size())
+                    {
+                      continue;
+                    }
+
+                  std::vector<std::uint64_t> out((n + 63) / 64, ~0ull);
+                  compare_values(op, values.data() + offset,
+                      references.data() + offset, n, low, high, out.data());
+
+                  for (std::size_t i = 0; i < n; ++i)
+                    {
+                      bool bit = (out[i / 64] >> (i % 64)) & 1;
+                      bool want = references[offset + i] != 0
+                          && expected(op, values[offset + i], low, high);
+                      ASSERT_EQ(want, bit) << "level "
+                          << static_cast<int>(level) << " op "
+                          << static_cast<int>(op) << " n " << n << " i " << i;
+                    }
+
+                  // Bits past the end are cleared.
+                  if (n % 64 != 0)
+                    {
+                      EXPECT_EQ(0, out.back() >> (n % 64));
+                    }
+                }
+            }
+        }
+    }
+
+  set_simd_level(original);
+}
+
+template<typename T>
+std::vector<T> make_values()
+{
+  std::vector<T> values;
+  for (auto i = 0; i < 1100; ++i)
+    {
+      values.push_back(T((i * 37) % 101 - 50));
+    }
+
+  values[10] = std::numeric_limits<T>::max();
+  values[11] = std::numeric_limits<T>::lowest();
+  return values;
+}
+
+}
+
+TEST(CompareKernelsTest, CanCompareSmallint)
+{
+  check_all<std::int16_t>(make_values<std::int16_t>(), -3, 20);
+}
+
+TEST(CompareKernelsTest, CanCompareInteger)
+{
+  check_all<std::int32_t>(make_values<std::int32_t>(), -3, 20);
+}
+
+TEST(CompareKernelsTest, CanCompareBigint)
+{
+  auto values = make_values<std::int64_t>();
+  values[20] = std::int64_t(1) << 40;
+  check_all<std::int64_t>(values, -3, std::int64_t(1) << 40);
+}
+
+TEST(CompareKernelsTest, CanCompareReal)
+{
+  auto values = make_values<float>();
+  values[30] = NAN;
+  check_all<float>(values, -3.5f, 20.0f);
+}
+
+TEST(CompareKernelsTest, CanCompareDoublePrecision)
+{
+  auto values = make_values<double>();
+  values[30] = NAN;
+  check_all<double>(values, -3.0, 20.5);
+}
+
+TEST(CompareKernelsTest, ClampsLevel)
+{
+  auto original = get_simd_level();
+
+  EXPECT_EQ(simd_level::SCALAR, set_simd_level(simd_level::SCALAR));
+  EXPECT_EQ(simd_level::SCALAR, get_simd_level());
+  EXPECT_EQ(original, set_simd_level(simd_level::AVX2));
+}
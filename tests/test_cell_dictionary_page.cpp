@@ -0,0 +1,126 @@
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <cell/cpp/dictionary_page.h>
+#include <cell/cpp/list_predicate.h>
+#include <cell/cpp/page_cursor.h>
+#include <cell/cpp/scalar_predicate.h>
+
+#include <gtest/gtest.h>
+
+TEST(DictionaryPageTest, CanCreate)
+{
+  std::unique_ptr<lattice::cell::dictionary_page> page;
+  ASSERT_NO_THROW(
+      page = std::unique_ptr<lattice::cell::dictionary_page>(
+          new lattice::cell::dictionary_page())
+      );
+}
+
+TEST(DictionaryPageTest, CanReadMany)
+{
+  lattice::cell::dictionary_page page;
+
+  const std::string states[] = { "new", "open", "closed" };
+
+  for (auto i = 1; i < 10000; ++i)
+    {
+      auto& s = states[i % 3];
+      EXPECT_EQ(s.size() + sizeof(std::uint32_t), page.insert_object(i, s));
+    }
+
+  for (auto i = 1; i < 10000; ++i)
+    {
+      std::string s;
+      EXPECT_TRUE(std::get<0>(page.fetch_object(i, s)));
+      EXPECT_EQ(states[i % 3], s);
+    }
+
+  // Every distinct value is only stored once.
+  EXPECT_EQ(3, page.get_dictionary_size());
+}
+
+TEST(DictionaryPageTest, SharesCodes)
+{
+  lattice::cell::dictionary_page page;
+
+  page.insert_object(1, std::string("open"));
+  page.insert_object(2, std::string("closed"));
+  page.insert_object(3, std::string("open"));
+
+  EXPECT_EQ(std::get<1>(page.get_code(1)), std::get<1>(page.get_code(3)));
+  EXPECT_NE(std::get<1>(page.get_code(1)), std::get<1>(page.get_code(2)));
+
+  EXPECT_TRUE(std::get<0>(page.find_code("closed")));
+  EXPECT_FALSE(std::get<0>(page.find_code("missing")));
+}
+
+TEST(DictionaryPageTest, ListPredicateUsesCodes)
+{
+  lattice::cell::dictionary_page page;
+
+  const std::string states[] = { "new", "open", "closed" };
+
+  for (auto i = 1; i < 10000; ++i)
+    {
+      page.insert_object(i, states[i % 3]);
+    }
+
+  lattice::cell::list_predicate pred;
+  pred.add_value(lattice::cell::column::data_type::varchar,
+      std::string("open"));
+  pred.add_value(lattice::cell::column::data_type::varchar,
+      std::string("missing"));
+
+  lattice::cell::page_cursor cursor(page);
+
+  int matches = 0;
+  while(!cursor.end_of_page()) {
+      EXPECT_EQ(cursor.oid() % 3 == 1, pred.contains(cursor));
+      matches += pred.contains(cursor) ? 1 : 0;
+
+      cursor.advance();
+  }
+
+  EXPECT_EQ(3333, matches);
+}
+
+TEST(DictionaryPageTest, PredicatesSelectCodes)
+{
+  using namespace lattice::cell;
+
+  dictionary_page page;
+
+  const std::string states[] = { "new", "open", "closed" };
+
+  for (auto i = 1; i < 10000; ++i)
+    {
+      page.insert_object(i, states[i % 3]);
+    }
+
+  list_predicate list;
+  list.add_value(column::data_type::varchar, std::string("open"));
+  list.add_value(column::data_type::varchar, std::string("closed"));
+
+  selection_bitmap in_list(10000);
+  list.select(page, 0, in_list);
+  EXPECT_EQ(6666, in_list.count());
+  EXPECT_FALSE(in_list.test(0));
+  EXPECT_FALSE(in_list.test(3));
+  EXPECT_TRUE(in_list.test(4));
+
+  scalar_predicate equal;
+  equal.set_value(column::data_type::varchar, std::string("new"));
+
+  selection_bitmap is_new(10000);
+  equal.select(page, 0, is_new);
+  EXPECT_EQ(3333, is_new.count());
+
+  is_new |= in_list;
+  EXPECT_EQ(9999, is_new.count());
+
+  equal.set_value(column::data_type::varchar, std::string("missing"));
+  equal.select(page, 0, is_new);
+  EXPECT_TRUE(is_new.none());
+}
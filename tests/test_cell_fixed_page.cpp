@@ -0,0 +1,451 @@
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <memory>
+#include <vector>
+
+#include <cell/cpp/fixed_page.h>
+#include <cell/cpp/list_predicate.h>
+#include <cell/cpp/page_cursor.h>
+#include <cell/cpp/scalar_predicate.h>
+
+#include <gtest/gtest.h>
+
+TEST(FixedPageTest, CanCreate)
+{
+  std::unique_ptr<lattice::cell::fixed_page<int>> page;
+  ASSERT_NO_THROW(
+      page = std::unique_ptr<lattice::cell::fixed_page<int>>(
+          new lattice::cell::fixed_page<int>())
+      );
+}
+
+TEST(FixedPageTest, CanReadMany)
+{
+  lattice::cell::fixed_page<std::int64_t> page;
+
+  std::int64_t a = 5, b = 0;
+
+  for (auto i = 1; i < 100000; ++i, ++a)
+    {
+      EXPECT_EQ(sizeof(a), page.insert_object(i, a));
+    }
+
+  a = 5;
+
+  for (auto i = 1; i < 100000; ++i, ++a)
+    {
+      b = 0;
+      EXPECT_TRUE(std::get<0>(page.fetch_object(i, b)));
+      EXPECT_EQ(a, b);
+    }
+
+  // Every atom but the last is sealed, and the values are consecutive.
+  EXPECT_GT(99999 * sizeof(a) / 4, page.size());
+}
+
+TEST(FixedPageTest, CanInsertValue)
+{
+  lattice::cell::fixed_page<int> page;
+
+  int a = 42, b = 0;
+  auto buffer = static_cast<const lattice::cell::page::byte_type*>(
+      static_cast<const void*>(&a));
+
+  EXPECT_EQ(0, page.insert_value(1, buffer, sizeof(a) - 1));
+  EXPECT_EQ(sizeof(a), page.insert_value(1, buffer, sizeof(a)));
+  EXPECT_TRUE(std::get<0>(page.fetch_object(1, b)));
+  EXPECT_EQ(a, b);
+}
+
+TEST(FixedPageTest, CanAcquireAndDelete)
+{
+  lattice::cell::fixed_page<int> page;
+
+  int a = 5;
+
+  page.insert_object(1, a);
+  page.acquire_object(1);
+  page.delete_object(1);
+
+  // Should be able to get it the first time (refcount=1)
+  EXPECT_TRUE(std::get<0>(page.fetch_object(1, a)));
+
+  page.delete_object(1);
+  // Should not be able to get it the second time (recount=0)
+  EXPECT_FALSE(std::get<0>(page.fetch_object(1, a)));
+  EXPECT_EQ(0, page.size());
+}
+
+TEST(FixedPageTest, CanScanAtoms)
+{
+  lattice::cell::fixed_page<int> page;
+
+  for (auto i = 1; i < 50000; ++i)
+    {
+      page.insert_object(i, i);
+    }
+
+  std::int64_t sum = 0, expected = 0;
+  for (auto i = 1; i < 50000; ++i)
+    {
+      expected += i;
+    }
+
+  std::unique_ptr<int[]> buffer(new int[page.k_slots_per_atom]);
+
+  for (auto i = 0; i < page.get_number_of_atoms(); ++i)
+    {
+      auto values = page.read_atom_values(i, buffer.get());
+      auto refs = page.get_atom_references(i);
+
+      for (auto slot = 0; slot < page.k_slots_per_atom; ++slot)
+        {
+          if (refs[slot] > 0)
+            {
+              sum += values[slot];
+            }
+        }
+    }
+
+  EXPECT_EQ(expected, sum);
+}
+
+TEST(FixedPageTest, CanIterateWithCursor)
+{
+  lattice::cell::fixed_page<int> page;
+
+  for (auto i = 1; i < 50000; ++i)
+    {
+      page.insert_object(i, i + 5);
+    }
+
+  lattice::cell::page_cursor cursor(page);
+
+  int i=1;
+  while(!cursor.end_of_page()) {
+      int b = 0;
+
+      EXPECT_EQ(sizeof(b), cursor.value(b));
+      EXPECT_EQ(i+5, b);
+      EXPECT_EQ(i, cursor.oid());
+
+      cursor.advance();
+      ++i;
+  }
+
+  EXPECT_EQ(50000, i);
+}
+
+TEST(FixedPageTest, SealsFullAtoms)
+{
+  lattice::cell::fixed_page<std::int64_t> page;
+  const std::int64_t k = page.k_slots_per_atom;
+
+  // Increasing ids, long runs and small random values.
+  std::mt19937 gen(7);
+  for (std::int64_t i = 0; i < 3 * k; ++i)
+    {
+      std::int64_t value = i + 1000000000;
+      if (i >= k)
+        {
+          value = i < 2 * k ? (i / 1000) * 1000000
+              : std::int64_t(gen() % 1000);
+        }
+
+      page.insert_object(i, value);
+    }
+
+  auto plain_size = 3 * k * sizeof(std::int64_t);
+
+  // Start the next atom so that the third one is sealed.
+  page.insert_object(3 * k, 0);
+
+  EXPECT_EQ(lattice::cell::integer_encoding::DELTA,
+      page.get_atom_encoding(0));
+  EXPECT_EQ(lattice::cell::integer_encoding::RUN_LENGTH,
+      page.get_atom_encoding(1));
+  EXPECT_EQ(lattice::cell::integer_encoding::FRAME_OF_REFERENCE,
+      page.get_atom_encoding(2));
+  EXPECT_EQ(lattice::cell::integer_encoding::NONE,
+      page.get_atom_encoding(3));
+  EXPECT_EQ(nullptr, page.get_atom_values(0));
+  EXPECT_GT(plain_size / 4, page.size());
+
+  gen.seed(7);
+  lattice::cell::page_cursor cursor(page);
+  for (std::int64_t i = 0; i < 3 * k; ++i)
+    {
+      std::int64_t expected = i + 1000000000;
+      if (i >= k)
+        {
+          expected = i < 2 * k ? (i / 1000) * 1000000
+              : std::int64_t(gen() % 1000);
+        }
+
+      std::int64_t value = -1;
+      ASSERT_TRUE(std::get<0>(page.fetch_object(i, value)));
+      EXPECT_EQ(expected, value);
+
+      ASSERT_FALSE(cursor.end_of_page());
+      EXPECT_EQ(i, cursor.oid());
+      EXPECT_EQ(0, cursor.cmp(expected));
+      cursor.advance();
+    }
+}
+
+TEST(FixedPageTest, CanReadRangesOfSealedAtoms)
+{
+  lattice::cell::fixed_page<std::int64_t> page;
+  const std::int64_t k = page.k_slots_per_atom;
+
+  // One atom each of delta, run length and frame of reference values.
+  std::vector<std::int64_t> expected;
+  std::mt19937 gen(11);
+  for (std::int64_t i = 0; i < 3 * k; ++i)
+    {
+      std::int64_t value = i * 7 + 1000000000;
+      if (i >= k)
+        {
+          value = i < 2 * k ? (i / 300) * 1000000
+              : std::int64_t(gen() % 1000);
+        }
+
+      expected.push_back(value);
+      page.insert_object(i, value);
+    }
+
+  // Start the next atom so that the third one is sealed.
+  page.insert_object(3 * k, 0);
+
+  EXPECT_EQ(lattice::cell::integer_encoding::DELTA,
+      page.get_atom_encoding(0));
+  EXPECT_EQ(lattice::cell::integer_encoding::RUN_LENGTH,
+      page.get_atom_encoding(1));
+  EXPECT_EQ(lattice::cell::integer_encoding::FRAME_OF_REFERENCE,
+      page.get_atom_encoding(2));
+
+  // Scan windows that start part way into a run and cross atoms.
+  for (auto first : { std::int64_t(0), std::int64_t(37), k - 100,
+      2 * k - 1, 3 * k - 500 })
+    {
+      std::int64_t seen = 0;
+      page.scan(first, 300, nullptr,
+          [&](std::int64_t position, const std::int64_t* values,
+              const lattice::cell::page::reference_count_type* references,
+              std::int64_t n)
+          {
+            for (std::int64_t i = 0; i < n; ++i)
+              {
+                ASSERT_EQ(1, references[i]);
+                EXPECT_EQ(expected[first + position + i], values[i]);
+                ++seen;
+              }
+          });
+
+      EXPECT_EQ(300, seen);
+    }
+
+  // Read blocks that do not line up with the decoded runs.
+  const std::size_t block = 250;
+  std::vector<lattice::cell::page::object_id_type> oids(block);
+  std::vector<const lattice::cell::page::byte_type*> data(block);
+  std::vector<lattice::cell::page::byte_type> scratch(
+      block * lattice::cell::page::k_scratch_size);
+
+  std::int64_t next = 0;
+  while (next < 3 * k)
+    {
+      auto n = page.read_block(next, block, oids.data(), data.data(),
+          scratch.data());
+      ASSERT_LT(0u, n);
+
+      for (std::size_t i = 0; i < n && next < 3 * k; ++i)
+        {
+          std::int64_t value = 0;
+          std::memcpy(&value, data[i], sizeof(value));
+          ASSERT_EQ(next, std::int64_t(oids[i]));
+          EXPECT_EQ(expected[next], value);
+          ++next;
+        }
+    }
+
+  EXPECT_EQ(3 * k, next);
+
+  // And single objects out of order.
+  for (auto i : { 5 * k / 2, std::int64_t(3), k + 129, std::int64_t(130) })
+    {
+      std::int64_t value = -1;
+      ASSERT_TRUE(std::get<0>(page.fetch_object(i, value)));
+      EXPECT_EQ(expected[i], value);
+    }
+}
+
+TEST(FixedPageTest, CanWriteToSealedAtom)
+{
+  lattice::cell::fixed_page<int> page;
+  const int k = page.k_slots_per_atom;
+
+  for (auto i = 0; i < 2 * k; ++i)
+    {
+      page.insert_object(i, i < k / 2 ? 5 : 1 << 30);
+    }
+
+  EXPECT_EQ(lattice::cell::integer_encoding::RUN_LENGTH,
+      page.get_atom_encoding(0));
+
+  page.delete_object(10);
+  page.insert_object(20, 6);
+  EXPECT_EQ(lattice::cell::integer_encoding::NONE,
+      page.get_atom_encoding(0));
+
+  page.seal();
+  EXPECT_EQ(lattice::cell::integer_encoding::RUN_LENGTH,
+      page.get_atom_encoding(0));
+
+  int value = 0;
+  EXPECT_FALSE(std::get<0>(page.fetch_object(10, value)));
+  EXPECT_TRUE(std::get<0>(page.fetch_object(20, value)));
+  EXPECT_EQ(6, value);
+  EXPECT_TRUE(std::get<0>(page.fetch_object(21, value)));
+  EXPECT_EQ(5, value);
+  EXPECT_TRUE(std::get<0>(page.fetch_object(k - 1, value)));
+  EXPECT_EQ(1 << 30, value);
+}
+
+TEST(FixedPageTest, TracksZoneMaps)
+{
+  lattice::cell::fixed_page<int> page;
+  const int k = page.k_slots_per_atom;
+
+  page.insert_object(1, 50);
+  page.insert_object(2, -7);
+
+  bool found;
+  int low, high;
+
+  std::tie(found, low, high) = page.get_atom_zone(0);
+  EXPECT_TRUE(found);
+  EXPECT_EQ(-7, low);
+  EXPECT_EQ(50, high);
+
+  // Sealing rebuilds the zone map from the live values.
+  page.delete_object(2);
+  page.insert_object(k, 3);
+  std::tie(found, low, high) = page.get_atom_zone(0);
+  EXPECT_EQ(50, low);
+  EXPECT_EQ(50, high);
+
+  std::tie(found, low, high) = page.get_atom_zone(1);
+  EXPECT_EQ(3, low);
+  EXPECT_EQ(3, high);
+}
+
+TEST(FixedPageTest, SkipsAtomsWithZoneMaps)
+{
+  using namespace lattice::cell;
+
+  // The list predicate reads values through the column definition.
+  fixed_page<std::int64_t> page(new column {
+      column::data_type::bigint, "ts", 8, 0, false
+    });
+
+  for (auto i = 1; i < 100000; ++i)
+    {
+      page.insert_object(i, i * 10);
+    }
+
+  scalar_predicate range;
+  range.set_value(column::data_type::bigint, 900000);
+  range.set_comparison(scalar_predicate::comparison::GREATER_EQUAL);
+
+  int visited = 0, matched = 0;
+  for (page_cursor cursor(page, range); !cursor.end_of_page();
+      cursor.advance(range))
+    {
+      ++visited;
+      if (range.contains(cursor))
+        {
+          EXPECT_LE(90000, cursor.oid());
+          ++matched;
+        }
+    }
+
+  EXPECT_EQ(10000, matched);
+  EXPECT_GE(2 * page.k_slots_per_atom, visited);
+
+  list_predicate list;
+  list.add_value(column::data_type::bigint, 550);
+  list.add_value(column::data_type::bigint, 500000);
+
+  visited = matched = 0;
+  for (page_cursor cursor(page, list); !cursor.end_of_page();
+      cursor.advance(list))
+    {
+      ++visited;
+      if (list.contains(cursor))
+        {
+          ++matched;
+        }
+    }
+
+  EXPECT_EQ(2, matched);
+  EXPECT_GE(2 * page.k_slots_per_atom, visited);
+
+  // Nothing can match a value past the end.
+  range.set_value(column::data_type::bigint, 5000000);
+  page_cursor cursor(page, range);
+  EXPECT_TRUE(cursor.end_of_page());
+}
+
+TEST(FixedPageTest, CanInsertValues)
+{
+  lattice::cell::fixed_page<std::int64_t> page;
+  const std::int64_t k = page.k_slots_per_atom;
+
+  // Start part way into the first atom and run into the second.
+  std::vector<std::int64_t> values;
+  for (std::int64_t i = 0; i < k + 100; ++i)
+    {
+      values.push_back(i * 3 - 50);
+    }
+
+  auto first = page.get_next_oids(values.size());
+  EXPECT_EQ(values.size() + first, page.get_next_oid());
+
+  auto buffer = static_cast<const lattice::cell::page::byte_type*>(
+      static_cast<const void*>(values.data()));
+  auto bytes = values.size() * sizeof(std::int64_t);
+
+  EXPECT_EQ(0, page.insert_values(first, values.size(), buffer, bytes - 1));
+  EXPECT_EQ(bytes, page.insert_values(first, values.size(), buffer, bytes));
+
+  lattice::cell::page_cursor cursor(page);
+  for (std::size_t i = 0; i < values.size(); ++i)
+    {
+      std::int64_t value = 0;
+      ASSERT_TRUE(std::get<0>(page.fetch_object(first + i, value)));
+      EXPECT_EQ(values[i], value);
+
+      ASSERT_FALSE(cursor.end_of_page());
+      EXPECT_EQ(first + i, cursor.oid());
+      cursor.advance();
+    }
+  EXPECT_TRUE(cursor.end_of_page());
+
+  // The zone maps cover the values copied in, and the first atom was
+  // sealed once the run moved past it.
+  bool found;
+  std::int64_t low, high;
+
+  std::tie(found, low, high) = page.get_atom_zone(0);
+  EXPECT_TRUE(found);
+  EXPECT_EQ(values[0], low);
+  EXPECT_EQ(values[k - 1 - first], high);
+  EXPECT_EQ(nullptr, page.get_atom_values(0));
+
+  std::tie(found, low, high) = page.get_atom_zone(1);
+  EXPECT_TRUE(found);
+  EXPECT_EQ(values[k - first], low);
+  EXPECT_EQ(values.back(), high);
+}
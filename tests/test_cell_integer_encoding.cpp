@@ -0,0 +1,66 @@
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <cell/cpp/integer_encoding.h>
+
+#include <gtest/gtest.h>
+
+typedef lattice::cell::encoded_integers<std::int64_t> encoded_type;
+
+static void check(const encoded_type& encoded,
+    const std::vector<std::int64_t>& values)
+{
+  std::vector<std::int64_t> decoded(values.size());
+  encoded.decode(decoded.data());
+
+  for (std::size_t i = 0; i < values.size(); ++i)
+    {
+      EXPECT_EQ(values[i], encoded.get(i));
+      EXPECT_EQ(values[i], decoded[i]);
+    }
+}
+
+TEST(IntegerEncodingTest, CanEncodeDeltas)
+{
+  std::vector<std::int64_t> values;
+  for (auto i = 0; i < 1000; ++i)
+    {
+      values.push_back(-500 + 3 * i + (i % 2));
+    }
+
+  encoded_type encoded;
+  ASSERT_TRUE(encoded.encode(values.data(), values.size()));
+  EXPECT_EQ(lattice::cell::integer_encoding::DELTA, encoded.get_encoding());
+  EXPECT_GT(values.size() * sizeof(std::int64_t) / 4, encoded.size());
+
+  check(encoded, values);
+}
+
+TEST(IntegerEncodingTest, CanEncodeExtremes)
+{
+  std::vector<std::int64_t> values;
+  for (auto i = 0; i < 1000; ++i)
+    {
+      values.push_back(std::numeric_limits<std::int64_t>::max() - (i % 7));
+    }
+
+  encoded_type encoded;
+  ASSERT_TRUE(encoded.encode(values.data(), values.size()));
+  EXPECT_EQ(lattice::cell::integer_encoding::FRAME_OF_REFERENCE,
+      encoded.get_encoding());
+
+  check(encoded, values);
+
+  // The full range does not fit any encoding.
+  values[0] = std::numeric_limits<std::int64_t>::min();
+  EXPECT_FALSE(encoded.encode(values.data(), values.size()));
+}
+
+TEST(IntegerEncodingTest, DoesNotEncodeReals)
+{
+  std::vector<double> values(1000, 1.5);
+
+  lattice::cell::encoded_integers<double> encoded;
+  EXPECT_FALSE(encoded.encode(values.data(), values.size()));
+}
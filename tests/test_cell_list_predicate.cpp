@@ -2,6 +2,7 @@
 #include <memory>
 #include <sstream>
 
+#include <cell/cpp/fixed_page.h>
 #include <cell/cpp/list_predicate.h>
 #include <cell/cpp/page_cursor.h>
 
@@ -62,3 +63,33 @@ TEST(ListPredicateTest, ContainsWorks)
    }
 }
 
+
+TEST(ListPredicateTest, CanSelect)
+{
+  using namespace lattice::cell;
+
+  fixed_page<std::int64_t> page;
+
+  for (auto i = 1; i < 40000; ++i)
+    {
+      page.insert_object(i, i);
+    }
+
+  list_predicate pred;
+  for (auto i = 100; i < 200; ++i)
+    {
+      pred.add_value(column::data_type::bigint, i);
+    }
+  pred.add_value(column::data_type::bigint, 30000);
+
+  selection_bitmap selection(40000);
+  pred.select(page, 0, selection);
+
+  selection_bitmap::selection_vector_type selected;
+  selection.to_vector(selected);
+
+  ASSERT_EQ(101, selected.size());
+  EXPECT_EQ(100, selected.front());
+  EXPECT_EQ(199, selected[99]);
+  EXPECT_EQ(30000, selected.back());
+}
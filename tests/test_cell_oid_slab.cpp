@@ -0,0 +1,68 @@
+#include <cstdint>
+#include <vector>
+
+#include <cell/cpp/oid_slab.h>
+#include <cell/cpp/row_value.h>
+
+#include <gtest/gtest.h>
+
+TEST(OidSlabTest, CanAllocate)
+{
+   lattice::cell::oid_slab slab(3);
+
+   std::vector<lattice::cell::oid_slab::value_type*> arrays;
+   for (auto i = 0; i < 5000; ++i)
+      {
+         auto array = slab.allocate();
+         array[0] = array[1] = array[2] = i;
+         arrays.push_back(array);
+      }
+
+   EXPECT_EQ(5000, slab.size());
+
+   // No array was overwritten by another.
+   for (auto i = 0; i < 5000; ++i)
+      {
+         EXPECT_EQ(i, arrays[i][0]);
+         EXPECT_EQ(i, arrays[i][2]);
+      }
+}
+
+TEST(OidSlabTest, ReusesReleasedArrays)
+{
+   lattice::cell::oid_slab slab(2);
+
+   auto a = slab.allocate();
+   auto b = slab.allocate();
+   slab.release(a);
+   EXPECT_EQ(1, slab.size());
+
+   EXPECT_EQ(a, slab.allocate());
+   EXPECT_NE(b, slab.allocate());
+   EXPECT_EQ(3, slab.size());
+}
+
+TEST(OidSlabTest, RowsUseTheSlab)
+{
+   using namespace lattice::cell;
+
+   oid_slab slab(2);
+   transaction_id tid;
+
+   {
+      row_value row(tid, { 5, 6 }, &slab);
+      EXPECT_EQ(1, slab.size());
+      EXPECT_EQ(6, row.column(1));
+
+      row_value copy(row);
+      EXPECT_EQ(2, slab.size());
+      EXPECT_EQ(5, copy.column(0));
+
+      row_value moved(std::move(copy));
+      EXPECT_EQ(2, slab.size());
+      EXPECT_EQ(5, moved.column(0));
+   }
+
+   // Every array was given back.
+   EXPECT_EQ(0, slab.size());
+}
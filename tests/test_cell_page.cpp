@@ -1,6 +1,7 @@
 #include <cstdint>
 #include <memory>
 #include <sstream>
+#include <string>
 
 #include <cell/cpp/page.h>
 
@@ -145,3 +146,138 @@ TEST(PageTest, CanAcquire)
 }
 
 
+
+TEST(PageTest, FreesEmptyAtoms)
+{
+  lattice::cell::page page;
+
+  page.set_max_atom_size(1024);
+
+  int a = 5;
+
+  for (auto i = 0; i < 10000; ++i, ++a)
+    {
+      page.insert_object(i, a);
+    }
+
+  auto full_size = page.size();
+
+  for (auto i = 0; i < 5000; ++i)
+    {
+      page.delete_object(i);
+    }
+
+  auto stats = page.get_fragmentation();
+  EXPECT_GT(full_size / 2 + 1100, page.size());
+  EXPECT_EQ(page.size(), stats.bytes);
+  EXPECT_EQ(5000 * sizeof(a), stats.live_bytes);
+  EXPECT_LT(0, stats.reclaimed_bytes);
+}
+
+TEST(PageTest, CanCompact)
+{
+  lattice::cell::page page;
+
+  page.set_max_atom_size(1024);
+
+  for (auto i = 0; i < 10000; ++i)
+    {
+      page.insert_object(i, std::to_string(i));
+    }
+
+  // Leave one object in four behind.
+  for (auto i = 0; i < 10000; ++i)
+    {
+      if (i % 4 != 0)
+        {
+          page.delete_object(i);
+        }
+    }
+
+  auto before = page.get_fragmentation();
+  EXPECT_LT(0, before.sparse_atoms);
+  EXPECT_EQ(0, before.reclaimed_bytes);
+
+  // A small budget only does part of the work.
+  auto moved = page.compact(1);
+  EXPECT_LT(0, moved);
+  EXPECT_GT(before.sparse_atoms, page.get_fragmentation().sparse_atoms);
+
+  while (page.compact(4096) > 0)
+    {
+    }
+
+  auto after = page.get_fragmentation();
+  EXPECT_EQ(0, after.sparse_atoms);
+  EXPECT_EQ(before.live_bytes, after.live_bytes);
+  EXPECT_GT(before.bytes / 2, after.bytes);
+  EXPECT_LT(0, after.reclaimed_bytes);
+
+  for (auto i = 0; i < 10000; ++i)
+    {
+      std::string s;
+      EXPECT_EQ(i % 4 == 0, std::get<0>(page.fetch_object(i, s)));
+      if (i % 4 == 0)
+        {
+          EXPECT_EQ(std::to_string(i), s);
+        }
+    }
+}
+
+TEST(PageTest, CanCompactSparseObjectIds)
+{
+  lattice::cell::page page;
+
+  page.set_max_atom_size(1024);
+
+  // Object ids far apart share atoms, so compaction must not walk the
+  // ids in between.
+  const lattice::cell::page::object_id_type k_stride = 10000;
+  for (auto i = 1; i <= 1000; ++i)
+    {
+      page.insert_object(i * k_stride, std::to_string(i));
+    }
+
+  for (auto i = 1; i <= 1000; ++i)
+    {
+      if (i % 4 != 0)
+        {
+          page.delete_object(i * k_stride);
+        }
+    }
+
+  EXPECT_LT(0, page.get_fragmentation().sparse_atoms);
+
+  while (page.compact(4096) > 0)
+    {
+    }
+
+  EXPECT_EQ(0, page.get_fragmentation().sparse_atoms);
+
+  for (auto i = 1; i <= 1000; ++i)
+    {
+      std::string s;
+      EXPECT_EQ(i % 4 == 0, std::get<0>(page.fetch_object(i * k_stride, s)));
+      if (i % 4 == 0)
+        {
+          EXPECT_EQ(std::to_string(i), s);
+        }
+    }
+}
+
+TEST(PageTest, OverwriteReleasesData)
+{
+  lattice::cell::page page;
+
+  std::string s("This is a test string.");
+
+  page.insert_object(0, s);
+  page.insert_object(0, s + s);
+
+  auto stats = page.get_fragmentation();
+  EXPECT_EQ(2 * s.size() + sizeof(std::uint32_t), stats.live_bytes);
+
+  std::string n;
+  EXPECT_TRUE(std::get<0>(page.fetch_object(0, n)));
+  EXPECT_EQ(s + s, n);
+}
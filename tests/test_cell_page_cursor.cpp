@@ -1,7 +1,10 @@
 #include <cstdint>
 #include <memory>
 #include <sstream>
+#include <string>
 
+#include <cell/cpp/dictionary_page.h>
+#include <cell/cpp/fixed_page.h>
 #include <cell/cpp/page_cursor.h>
 
 #include <gtest/gtest.h>
@@ -72,3 +75,141 @@ TEST(PageCursorTest, CanCompare)
   }
 }
 
+TEST(PageCursorTest, SkipsDeletedObjects)
+{
+  lattice::cell::page page;
+
+  int a = 5;
+
+  for (auto i = 0; i < 10000; ++i, ++a)
+    {
+      EXPECT_EQ(sizeof(a), page.insert_object(i, a));
+    }
+
+  // Delete every odd object.
+  for (auto i = 1; i < 10000; i += 2)
+    {
+      page.delete_object(i);
+    }
+
+  lattice::cell::page_cursor cursor(page);
+
+  int i=0;
+  while(!cursor.end_of_page()) {
+      int b = 0;
+
+      EXPECT_EQ(sizeof(b), cursor.value(b));
+      EXPECT_EQ(i+5, b);
+      EXPECT_EQ(i, cursor.oid());
+
+      // Go to the next record.
+      cursor.advance();
+      i+=2;
+  }
+
+  EXPECT_EQ(10000, i);
+}
+
+TEST(PageCursorTest, CanReadBlocks)
+{
+  lattice::cell::page page;
+
+  for (auto i = 0; i < 10000; ++i)
+    {
+      page.insert_object(i, i * 2);
+    }
+
+  // Leave gaps, including a run longer than a block.
+  for (auto i = 1; i < 10000; i += 3)
+    {
+      page.delete_object(i);
+    }
+  for (auto i = 5000; i < 5200; ++i)
+    {
+      page.delete_object(i);
+    }
+
+  lattice::cell::page_cursor cursor(page);
+
+  int values[100];
+  lattice::cell::page::object_id_type oids[100];
+  lattice::cell::page::object_id_type expected = 0;
+  std::size_t total = 0;
+
+  for (;;)
+    {
+      auto n = cursor.next_block(values, oids, 100);
+      for (std::size_t i = 0; i < n; ++i)
+        {
+          while (expected % 3 == 1 || (expected >= 5000 && expected < 5200))
+            {
+              ++expected;
+            }
+
+          EXPECT_EQ(expected, oids[i]);
+          EXPECT_EQ(expected * 2, values[i]);
+          ++expected;
+        }
+
+      total += n;
+      if (n < 100)
+        {
+          break;
+        }
+    }
+
+  EXPECT_TRUE(cursor.end_of_page());
+  EXPECT_EQ(6533, total);
+}
+
+TEST(PageCursorTest, CanReadBlocksFromFixedPages)
+{
+  lattice::cell::fixed_page<std::int64_t> fp;
+
+  for (auto i = 0; i < 40000; ++i)
+    {
+      fp.insert_object(i, (i / 1000) * 1000000);
+    }
+  fp.seal();
+
+  // Start part of the way in, then read step by step and in blocks.
+  lattice::cell::page_cursor cursor(fp, 100);
+  std::int64_t v = 0;
+  cursor.value(v);
+  EXPECT_EQ(0, v);
+  cursor.advance();
+
+  std::int64_t values[1000];
+  auto n = cursor.next_block(values, nullptr, 1000);
+  ASSERT_EQ(1000, n);
+  EXPECT_EQ(0, values[898]);
+  EXPECT_EQ(1000000, values[899]);
+
+  EXPECT_EQ(1101, cursor.oid());
+  std::size_t total = n;
+  while ((n = cursor.next_block(values, nullptr, 1000)) > 0)
+    {
+      total += n;
+    }
+  EXPECT_EQ(40000 - 101, total);
+}
+
+TEST(PageCursorTest, CanReadBlocksFromDictionaryPages)
+{
+  lattice::cell::dictionary_page page;
+
+  for (auto i = 0; i < 500; ++i)
+    {
+      std::ostringstream s;
+      s << "value " << i % 7;
+      page.insert_object(i, s.str());
+    }
+
+  lattice::cell::page_cursor cursor(page);
+  std::string values[500];
+
+  ASSERT_EQ(500, cursor.next_block(values, nullptr, 500));
+  EXPECT_EQ("value 0", values[0]);
+  EXPECT_EQ("value 2", values[499]);
+  EXPECT_TRUE(cursor.end_of_page());
+}
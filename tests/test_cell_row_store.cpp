@@ -0,0 +1,142 @@
+#include <cstdint>
+#include <vector>
+
+#include <cell/cpp/row_store.h>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+
+lattice::cell::row_value make_row(lattice::cell::page::object_id_type oid)
+{
+   lattice::cell::transaction_id tid;
+   return lattice::cell::row_value(tid, { oid });
+}
+
+}
+
+TEST(RowStoreTest, CanInsertAndFind)
+{
+   using namespace lattice::cell;
+
+   row_store rows;
+   row_id generator;
+
+   std::vector<row_id> ids;
+   for (auto i = 0; i < 5000; ++i)
+      {
+         auto rid = generator.next();
+         ids.push_back(rid);
+         ASSERT_TRUE(rows.insert(rid, make_row(i)).second);
+      }
+
+   EXPECT_EQ(5000, rows.size());
+   EXPECT_FALSE(rows.insert(ids[10], make_row(0)).second);
+
+   for (auto i = 0; i < 5000; ++i)
+      {
+         auto pos = rows.find(ids[i]);
+         ASSERT_TRUE(pos != rows.end());
+         EXPECT_TRUE(pos->first == ids[i]);
+         EXPECT_EQ(i, pos->second.column(0));
+      }
+
+   EXPECT_TRUE(rows.find(row_id::from_uint64(5001)) == rows.end());
+   EXPECT_TRUE(rows.find(row_id::from_uint64(1 << 20)) == rows.end());
+}
+
+TEST(RowStoreTest, ScansInInsertOrder)
+{
+   using namespace lattice::cell;
+
+   row_store rows;
+   row_id generator;
+
+   for (auto i = 0; i < 3000; ++i)
+      {
+         rows.insert(generator.next(), make_row(i));
+      }
+
+   page::object_id_type expected = 0;
+   for (auto& row : rows)
+      {
+         EXPECT_EQ(expected++, row.second.column(0));
+      }
+   EXPECT_EQ(3000, expected);
+}
+
+TEST(RowStoreTest, IteratorsSurviveInserts)
+{
+   using namespace lattice::cell;
+
+   row_store rows;
+   row_id generator;
+
+   rows.insert(generator.next(), make_row(0));
+
+   auto pos = rows.begin();
+   auto* row = &pos->second;
+
+   // Add enough rows to grow the directory many times.
+   for (auto i = 1; i < 100000; ++i)
+      {
+         rows.insert(generator.next(), make_row(i));
+      }
+
+   EXPECT_EQ(row, &pos->second);
+   EXPECT_EQ(0, pos->second.column(0));
+
+   // An iterator at the end sees rows added later.
+   auto last = rows.begin();
+   for (auto i = 1; i < 100000; ++i)
+      {
+         ++last;
+      }
+   ++last;
+   EXPECT_TRUE(last == rows.end());
+
+   rows.insert(generator.next(), make_row(100000));
+   ASSERT_TRUE(last != rows.end());
+   EXPECT_EQ(100000, last->second.column(0));
+}
+
+TEST(RowStoreTest, CanErase)
+{
+   using namespace lattice::cell;
+
+   row_store rows;
+   row_id generator;
+
+   std::vector<row_id> ids;
+   for (auto i = 0; i < 4096; ++i)
+      {
+         ids.push_back(generator.next());
+         rows.insert(ids.back(), make_row(i));
+      }
+
+   // Empty out the second chunk, and every other row of the rest.
+   for (auto i = 0; i < 4096; ++i)
+      {
+         if ((i >= 1024 && i < 2048) || i % 2 == 0)
+            {
+               EXPECT_TRUE(rows.erase(ids[i]));
+            }
+      }
+
+   EXPECT_FALSE(rows.erase(ids[0]));
+   EXPECT_TRUE(rows.find(ids[1500]) == rows.end());
+
+   std::size_t n = 0;
+   for (auto& row : rows)
+      {
+         EXPECT_EQ(1, row.second.column(0) % 2);
+         ++n;
+      }
+   EXPECT_EQ(rows.size(), n);
+   EXPECT_EQ(2048 - 512, n);
+
+   // The erased chunk can be filled again.
+   EXPECT_TRUE(rows.insert(ids[1500], make_row(1500)).second);
+   EXPECT_TRUE(rows.find(ids[1500]) != rows.end());
+}
@@ -56,3 +56,114 @@ TEST(ScalarPredicateTest, CanCompare)
    }
 }
 
+
+TEST(ScalarPredicateTest, ContainsUsesComparison)
+{
+  using namespace lattice::cell;
+
+  page page;
+  page.insert_object(0, 100);
+
+  scalar_predicate pred;
+  pred.set_value(column::data_type::integer, 100);
+
+  page_cursor cursor(page);
+  EXPECT_TRUE(pred.contains(cursor));
+
+  pred.set_comparison(scalar_predicate::comparison::NOT_EQUAL);
+  EXPECT_FALSE(pred.contains(cursor));
+
+  pred.set_comparison(scalar_predicate::comparison::LESS);
+  EXPECT_FALSE(pred.contains(cursor));
+
+  pred.set_comparison(scalar_predicate::comparison::GREATER_EQUAL);
+  EXPECT_TRUE(pred.contains(cursor));
+
+  pred.set_value(column::data_type::integer, 101);
+  pred.set_comparison(scalar_predicate::comparison::LESS);
+  EXPECT_TRUE(pred.contains(cursor));
+
+  data_value low, high;
+  low.set_value(column::data_type::integer, 0);
+  high.set_value(column::data_type::integer, 100);
+  EXPECT_TRUE(pred.may_match(low, high));
+
+  pred.set_comparison(scalar_predicate::comparison::GREATER);
+  EXPECT_FALSE(pred.may_match(low, high));
+}
+
+TEST(ScalarPredicateTest, CanSelect)
+{
+  using namespace lattice::cell;
+
+  fixed_page<int> fp;
+  page vp;
+
+  for (auto i = 1; i < 40000; ++i)
+    {
+      fp.insert_object(i, i % 1000);
+      vp.insert_object(i, i % 1000);
+    }
+  fp.delete_object(500);
+
+  scalar_predicate pred;
+  pred.set_value(column::data_type::integer, 500);
+  pred.set_comparison(scalar_predicate::comparison::LESS);
+
+  // The typed loops and the cursor loop agree.
+  selection_bitmap fast(40000), slow(40000);
+  pred.select(fp, 0, fast);
+  pred.predicate::select(fp, 0, slow);
+
+  EXPECT_EQ(slow.count(), fast.count());
+  fast.flip();
+  fast &= slow;
+  EXPECT_TRUE(fast.none());
+
+  pred.select(vp, 0, slow);
+  EXPECT_EQ(20000 - 1, slow.count());
+
+  // A block in the middle of an atom.
+  selection_bitmap block(1000);
+  pred.set_comparison(scalar_predicate::comparison::EQUAL);
+  pred.select(fp, 2000, block);
+  EXPECT_EQ(1, block.count());
+  EXPECT_TRUE(block.test(500));
+}
+
+TEST(ScalarPredicateTest, CanSelectBetween)
+{
+  using namespace lattice::cell;
+
+  fixed_page<double> fp;
+  for (auto i = 1; i < 20000; ++i)
+    {
+      fp.insert_object(i, (i % 100) * 0.5);
+    }
+
+  scalar_predicate pred;
+  pred.set_range(column::data_type::double_precision, 10.0, 12.0);
+
+  // Values 20 to 24 of every 100 are in range.
+  selection_bitmap fast(20000), slow(20000);
+  pred.select(fp, 0, fast);
+  pred.predicate::select(fp, 0, slow);
+
+  EXPECT_EQ(200 * 5, fast.count());
+  EXPECT_EQ(slow.count(), fast.count());
+  fast.flip();
+  fast &= slow;
+  EXPECT_TRUE(fast.none());
+
+  data_value low, high;
+  low.set_value(column::data_type::double_precision, 11.0);
+  high.set_value(column::data_type::double_precision, 50.0);
+  EXPECT_TRUE(pred.may_match(low, high));
+
+  low.set_value(column::data_type::double_precision, 12.5);
+  EXPECT_FALSE(pred.may_match(low, high));
+
+  low.set_value(column::data_type::double_precision, 0.0);
+  high.set_value(column::data_type::double_precision, 9.5);
+  EXPECT_FALSE(pred.may_match(low, high));
+}
@@ -0,0 +1,105 @@
+#include <cstdint>
+
+#include <cell/cpp/selection.h>
+
+#include <gtest/gtest.h>
+
+TEST(SelectionTest, CanSetAndTest)
+{
+  lattice::cell::selection_bitmap s(100);
+
+  EXPECT_EQ(100, s.size());
+  EXPECT_TRUE(s.none());
+
+  s.set(0);
+  s.set(63);
+  s.set(64);
+  s.set(99);
+
+  EXPECT_EQ(4, s.count());
+  EXPECT_TRUE(s.test(63));
+  EXPECT_FALSE(s.test(62));
+
+  s.reset(63);
+  EXPECT_FALSE(s.test(63));
+
+  lattice::cell::selection_bitmap::selection_vector_type v;
+  s.to_vector(v);
+  ASSERT_EQ(3, v.size());
+  EXPECT_EQ(0, v[0]);
+  EXPECT_EQ(64, v[1]);
+  EXPECT_EQ(99, v[2]);
+
+  s.flip();
+  EXPECT_EQ(97, s.count());
+
+  s.set_all();
+  EXPECT_EQ(100, s.count());
+}
+
+TEST(SelectionTest, CanCombine)
+{
+  lattice::cell::selection_bitmap even(200), small(200);
+
+  for (auto i = 0; i < 200; ++i)
+    {
+      if (i % 2 == 0)
+        {
+          even.set(i);
+        }
+
+      if (i < 50)
+        {
+          small.set(i);
+        }
+    }
+
+  auto both = even;
+  both &= small;
+  EXPECT_EQ(25, both.count());
+
+  auto either = even;
+  either |= small;
+  EXPECT_EQ(125, either.count());
+}
+
+TEST(SelectionTest, CanSelectValues)
+{
+  int values[100];
+  std::uint8_t references[100];
+
+  for (auto i = 0; i < 100; ++i)
+    {
+      values[i] = i;
+      references[i] = i % 10 == 0 ? 0 : 1;
+    }
+
+  // Start part way into a word.
+  lattice::cell::selection_bitmap s(130);
+  s.select(30, values, references, 100,
+      [](int x) { return x >= 50; });
+
+  EXPECT_EQ(45, s.count());
+  EXPECT_FALSE(s.test(30 + 49));
+  EXPECT_FALSE(s.test(30 + 50));
+  EXPECT_TRUE(s.test(30 + 51));
+  EXPECT_TRUE(s.test(129));
+}
+
+TEST(SelectionTest, CanMerge)
+{
+  lattice::cell::selection_bitmap s(200);
+
+  // Every other bit, merged at an offset that straddles words.
+  lattice::cell::selection_bitmap::word_type mask[2] =
+    { 0x5555555555555555ull, ~0ull };
+  s.merge(30, mask, 70);
+
+  EXPECT_EQ(32 + 6, s.count());
+  EXPECT_TRUE(s.test(30));
+  EXPECT_FALSE(s.test(31));
+  EXPECT_TRUE(s.test(92));
+  EXPECT_TRUE(s.test(99));
+  EXPECT_FALSE(s.test(100));
+  EXPECT_FALSE(s.test(29));
+}
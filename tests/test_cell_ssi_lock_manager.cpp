@@ -209,3 +209,113 @@ TEST(SsiLockManagerTest, CanCollectAllTransactions)
    ASSERT_EQ(0, lm.writer_graph_size());
 }
 
+
+TEST(SsiLockManagerTest, TracksConflictFlags)
+{
+   using namespace lattice::cell;
+
+   ssi_lock_manager lm;
+
+   transaction_id gen_tid;
+   row_id gen_rid;
+   page::object_id_type tbl_id = 1;
+
+   auto tid1 = gen_tid.next();
+   auto tid2 = gen_tid.next();
+
+   auto rid1 = gen_rid.next();
+
+   // T1 reads rid1, T2 writes it: T1 -rw-> T2.
+   lm.track_read(tid1, tbl_id, rid1);
+   lm.track_write(tid2, tbl_id, rid1);
+
+   EXPECT_TRUE(lm.has_out_conflict(tid1));
+   EXPECT_FALSE(lm.has_in_conflict(tid1));
+   EXPECT_TRUE(lm.has_in_conflict(tid2));
+   EXPECT_FALSE(lm.has_out_conflict(tid2));
+
+   // Once T2 aborts its write never happened.
+   lm.abort(tid2);
+
+   EXPECT_FALSE(lm.has_out_conflict(tid1));
+   EXPECT_FALSE(lm.has_in_conflict(tid2));
+   EXPECT_EQ(0, lm.writer_graph_size());
+}
+
+TEST(SsiLockManagerTest, ChecksEveryReader)
+{
+   using namespace lattice::cell;
+
+   ssi_lock_manager lm;
+
+   transaction_id gen_tid;
+   row_id gen_rid;
+   page::object_id_type tbl_id = 1;
+
+   auto tid1 = gen_tid.next();
+   auto tid2 = gen_tid.next();
+   auto tid3 = gen_tid.next();
+   auto tid4 = gen_tid.next();
+
+   auto rid1 = gen_rid.next();
+   auto rid2 = gen_rid.next();
+
+   // T2 and T4 both read rid1, which T3 writes, but only T2 is a pivot.
+   lm.track_read(tid4, tbl_id, rid1);
+   lm.track_read(tid2, tbl_id, rid1);
+   lm.track_write(tid3, tbl_id, rid1);
+
+   lm.track_read(tid1, tbl_id, rid2);
+   lm.track_write(tid2, tbl_id, rid2);
+
+   auto results = lm.check_for_conflicts(tid3);
+   ASSERT_TRUE(std::get<1>(results));
+   EXPECT_EQ(tid2, std::get<0>(results));
+}
+
+TEST(SsiLockManagerTest, TableReadConflictsWithAnyWrite)
+{
+   using namespace lattice::cell;
+
+   ssi_lock_manager lm;
+
+   transaction_id gen_tid;
+   row_id gen_rid;
+   page::object_id_type tbl_id = 1;
+
+   auto tid1 = gen_tid.next();
+   auto tid2 = gen_tid.next();
+
+   auto rid1 = gen_rid.next();
+
+   lm.track_table_read(tid1, tbl_id);
+
+   // Writes to other tables, or by the reader, do not conflict.
+   EXPECT_FALSE(lm.track_write(tid2, tbl_id + 1, rid1));
+   EXPECT_FALSE(lm.track_write(tid1, tbl_id, rid1));
+
+   EXPECT_TRUE(lm.track_write(tid2, tbl_id, rid1));
+   EXPECT_TRUE(lm.has_out_conflict(tid1));
+}
+
+TEST(SsiLockManagerTest, EscalatesRowLocks)
+{
+   using namespace lattice::cell;
+
+   ssi_lock_manager lm(4);
+
+   transaction_id gen_tid;
+   page::object_id_type tbl_id = 1;
+
+   auto tid1 = gen_tid.next();
+   auto tid2 = gen_tid.next();
+
+   // Every other row, so each is a segment of its own.
+   for (auto i = 1; i <= 9; i += 2)
+      {
+         lm.track_read(tid1, tbl_id, row_id::from_uint64(i));
+      }
+
+   // Row 100 was never read, but the table lock covers it.
+   EXPECT_TRUE(lm.track_write(tid2, tbl_id, row_id::from_uint64(100)));
+}
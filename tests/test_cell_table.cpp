@@ -4,6 +4,7 @@
 
 #include <cell/cpp/table.h>
 #include <cell/cpp/data_value.h>
+#include <cell/cpp/scalar_predicate.h>
 
 #include <gtest/gtest.h>
 
@@ -174,7 +175,7 @@ TEST(TableTest, CanFetchRow)
       true
       }, in_buffer);
 
-   t.commit_row(tid, rid);
+   t.commit_row(tid, rid, 1);
 
    ASSERT_EQ(table::fetch_code::SUCCESS,
          t.fetch_row(tid, rid, { true }, out_buffer ));
@@ -182,6 +183,60 @@ TEST(TableTest, CanFetchRow)
    ASSERT_EQ(in_buffer, out_buffer.str());
 }
 
+TEST(TableTest, CanFetchMixedRow)
+{
+   using namespace lattice::cell;
+
+   table t
+      {
+      0, 3
+      };
+
+   t.set_column_definition(0, new column
+      {
+      column::data_type::integer, "col1"
+      });
+   t.set_column_definition(1, new column
+      {
+      column::data_type::varchar, "col2"
+      });
+   t.set_column_definition(2, new column
+      {
+      column::data_type::double_precision, "col3"
+      });
+
+   transaction_id tid;
+   row_id rid;
+
+   std::string in_buffer;
+   std::stringstream out_buffer;
+
+   table::text_tuple_type text_data
+      {
+      "100", "a varchar value", "2.5"
+      };
+
+   t.to_binary(
+      {
+      true, true, true
+      }, text_data, in_buffer);
+
+   ASSERT_EQ(table::insert_code::SUCCESS,
+         t.insert_row(tid, rid, { true, true, true }, in_buffer));
+
+   t.commit_row(tid, rid, 1);
+
+   ASSERT_EQ(table::fetch_code::SUCCESS,
+         t.fetch_row(tid, rid, { true, true, true }, out_buffer ));
+
+   ASSERT_EQ(in_buffer, out_buffer.str());
+
+   // A truncated buffer must not be accepted.
+   ASSERT_EQ(table::insert_code::UNDER_FLOW,
+         t.insert_row(tid, rid, { true, true, true },
+               in_buffer.substr(0, in_buffer.size() - 1)));
+}
+
 TEST(TableTest, CanFetchManyRows)
 {
    using namespace lattice::cell;
@@ -219,7 +274,7 @@ TEST(TableTest, CanFetchManyRows)
             true
             }, in_buffer);
 
-         t.commit_row(tid, rid);
+         t.commit_row(tid, rid, 1);
 
          std::stringstream out_buffer;
 
@@ -276,7 +331,7 @@ TEST(TableTest, CanIsolateInsert)
                t.fetch_row(read_tid, rid, { true }, out_buffer));
 
          // Commit row
-         t.commit_row(write_tid, rid);
+         t.commit_row(write_tid, rid, i + 1);
 
          // Row has been committed, so it should be visible.
          ASSERT_EQ(table::fetch_code::SUCCESS,
@@ -354,6 +409,7 @@ TEST(TableTest, CanSerializeTransactions)
    t.set_ssi_lock_manager(&lm);
 
    transaction_id tid_generator;
+   commit_clock clock;
 
    std::vector<row_id> rows;
 
@@ -381,7 +437,7 @@ TEST(TableTest, CanSerializeTransactions)
             }, in_buffer);
 
          // Commit row
-         t.commit_row(tid1, rid);
+         t.commit_row(tid1, rid, clock.tick());
 
          // Save rid for later reading.
          rows.push_back(rid);
@@ -398,16 +454,17 @@ TEST(TableTest, CanSerializeTransactions)
 
          transaction_id tid2 = tid_generator.next();
          transaction_id tid3 = tid_generator.next();
+         auto snapshot = clock.now();
 
          t.fetch_row(tid2, rows[i],
             {
             true
-            }, b1, isolation_level::SERIALIZABLE);
+            }, b1, isolation_level::SERIALIZABLE, snapshot);
 
          t.fetch_row(tid3, rows[i],
             {
             true
-            }, b2, isolation_level::SERIALIZABLE);
+            }, b2, isolation_level::SERIALIZABLE, snapshot);
 
          data_value dv(column::data_type::integer);
 
@@ -439,20 +496,21 @@ TEST(TableTest, CanSerializeTransactions)
 
          row_id new_rid;
          ASSERT_EQ(table::update_code::SUCCESS,
-               t.update_row(tid2, rows[i], { true }, b1.str(), new_rid, isolation_level::SERIALIZABLE));
+               t.update_row(tid2, rows[i], { true }, b1.str(), new_rid, isolation_level::SERIALIZABLE, snapshot));
 
          // Before the commit we make sure that we have no conflicts.
          auto results = lm.check_for_conflicts(tid2);
          ASSERT_FALSE(std::get<1>(results));
 
-         t.commit_row(tid2, rows[i]);
-         t.commit_row(tid2, new_rid);
+         auto ts = clock.tick();
+         t.remove_row(tid2, rows[i], ts);
+         t.commit_row(tid2, new_rid, ts);
          lm.commit(tid2);
 
-         // T3 COMMIT
+         // T3 COMMIT, still seeing the version T2 replaced.
 
          ASSERT_EQ(table::update_code::SUCCESS,
-               t.update_row(tid3, rows[i], { true }, b2.str(), new_rid, isolation_level::SERIALIZABLE));
+               t.update_row(tid3, rows[i], { true }, b2.str(), new_rid, isolation_level::SERIALIZABLE, snapshot));
 
          // Before the commit we make sure that we have no conflicts.
          results = lm.check_for_conflicts(tid3);
@@ -465,3 +523,434 @@ TEST(TableTest, CanSerializeTransactions)
       }
 
 }
+
+TEST(TableTest, CanVacuum)
+{
+   using namespace lattice::cell;
+
+   table t
+      {
+      0, 2
+      };
+
+   t.set_column_definition(0, new column
+      {
+      column::data_type::integer, "col1"
+      });
+   t.set_column_definition(1, new column
+      {
+      column::data_type::integer, "col2"
+      });
+
+   auto tid1 = transaction_id::from_uint64(1);
+   auto tid2 = transaction_id::from_uint64(2);
+
+   std::string buffer;
+   t.to_binary({ true, true }, { "1", "2" }, buffer);
+
+   row_id rid;
+   t.insert_row(tid1, rid, { true, true }, buffer);
+   t.commit_row(tid1, rid, 1);
+
+   // Change only the first column, so the second is shared.
+   t.to_binary({ true, false }, { "10", "" }, buffer);
+
+   row_id new_rid;
+   ASSERT_EQ(table::update_code::SUCCESS,
+         t.update_row(tid2, rid, { true, false }, buffer, new_rid));
+   t.commit_row(tid2, new_rid, 2);
+
+   // Nothing goes before the old version is deleted at commit.
+   EXPECT_EQ(0, t.vacuum(2, 100));
+   EXPECT_TRUE(t.remove_row(tid2, rid, 2));
+
+   // A transaction that began before 2 may still be running, so nothing
+   // goes.
+   EXPECT_EQ(0, t.vacuum(1, 100));
+
+   // Once it is done, the old version does.
+   EXPECT_EQ(1, t.vacuum(2, 100));
+   EXPECT_EQ(0, t.vacuum(2, 100));
+
+   std::stringstream out;
+   EXPECT_EQ(table::fetch_code::DOES_NOT_EXIST,
+         t.fetch_row(tid2, rid, { true, true }, out));
+
+   ASSERT_EQ(table::fetch_code::SUCCESS,
+         t.fetch_row(tid2, new_rid, { true, true }, out));
+
+   std::string expected;
+   t.to_binary({ true, true }, { "10", "2" }, expected);
+   EXPECT_EQ(expected, out.str());
+}
+
+TEST(TableTest, CanShareValuesWithManyVersions)
+{
+   using namespace lattice::cell;
+
+   table t
+      {
+      0, 2
+      };
+
+   t.set_column_definition(0, new column
+      {
+      column::data_type::integer, "col1"
+      });
+   t.set_column_definition(1, new column
+      {
+      column::data_type::varchar, "col2"
+      });
+
+   auto tid = transaction_id::from_uint64(1);
+
+   std::string buffer;
+   t.to_binary({ true, true }, { "0", "shared" }, buffer);
+
+   row_id rid;
+   t.insert_row(tid, rid, { true, true }, buffer);
+   t.commit_row(tid, rid, 1);
+
+   // More versions share the second column than a reference count holds.
+   const auto k_updates = 300;
+   for (auto i = 1; i <= k_updates; ++i)
+      {
+         t.to_binary({ true, false }, { std::to_string(i), "" }, buffer);
+
+         row_id new_rid;
+         ASSERT_EQ(table::update_code::SUCCESS,
+               t.update_row(tid, rid, { true, false }, buffer, new_rid));
+         t.commit_row(tid, new_rid, i + 1);
+         t.remove_row(tid, rid, i + 1);
+         rid = new_rid;
+      }
+
+   // Vacuuming every old version leaves the value in place.
+   EXPECT_EQ(k_updates, t.vacuum(k_updates + 1, 2 * k_updates));
+
+   std::stringstream out;
+   ASSERT_EQ(table::fetch_code::SUCCESS,
+         t.fetch_row(tid, rid, { true, true }, out));
+
+   std::string expected;
+   t.to_binary({ true, true }, { std::to_string(k_updates), "shared" },
+         expected);
+   EXPECT_EQ(expected, out.str());
+}
+
+TEST(TableTest, VacuumsIncrementally)
+{
+   using namespace lattice::cell;
+
+   table t
+      {
+      0, 1
+      };
+
+   t.set_column_definition(0, new column
+      {
+      column::data_type::integer, "col1"
+      });
+
+   auto tid = transaction_id::from_uint64(1);
+
+   std::string buffer;
+   t.to_binary({ true }, { "5" }, buffer);
+
+   for (auto i = 0; i < 100; ++i)
+      {
+         row_id rid, new_rid;
+         t.insert_row(tid, rid, { true }, buffer);
+         t.commit_row(tid, rid, 2 * i + 1);
+         t.update_row(tid, rid, { true }, buffer, new_rid);
+         t.commit_row(tid, new_rid, 2 * i + 2);
+         t.remove_row(tid, rid, 2 * i + 2);
+      }
+
+   // 200 rows, 100 of them dead, looked at 30 at a time.
+   std::size_t removed = 0;
+   for (auto i = 0; i < 7; ++i)
+      {
+         removed += t.vacuum(200, 30);
+      }
+
+   EXPECT_EQ(100, removed);
+}
+
+TEST(TableTest, CanReadSnapshots)
+{
+   using namespace lattice::cell;
+
+   table t
+      {
+      0, 1
+      };
+
+   t.set_column_definition(0, new column
+      {
+      column::data_type::integer, "col1"
+      });
+
+   auto reader = transaction_id::from_uint64(1);
+   auto writer = transaction_id::from_uint64(2);
+
+   std::string buffer;
+   t.to_binary({ true }, { "1" }, buffer);
+
+   // The writer began after the reader, but committed before the reader
+   // took its snapshot, so the reader sees the row.
+   row_id first;
+   t.insert_row(writer, first, { true }, buffer);
+   t.commit_row(writer, first, 1);
+
+   commit_timestamp_type snapshot = 1;
+
+   std::stringstream out;
+   EXPECT_EQ(table::fetch_code::SUCCESS,
+         t.fetch_row(reader, first, { true }, out,
+               isolation_level::REPEATABLE_READ, snapshot));
+
+   // Rows committed after the snapshot are only seen at READ_COMMITTED.
+   row_id second;
+   t.insert_row(writer, second, { true }, buffer);
+   t.commit_row(writer, second, 2);
+
+   EXPECT_EQ(table::fetch_code::ISOLATED,
+         t.fetch_row(reader, second, { true }, out,
+               isolation_level::REPEATABLE_READ, snapshot));
+   EXPECT_EQ(table::fetch_code::SUCCESS,
+         t.fetch_row(reader, second, { true }, out));
+
+   // Rows deleted after the snapshot are still seen in it.
+   EXPECT_TRUE(t.remove_row(writer, first, 3));
+
+   EXPECT_EQ(table::fetch_code::SUCCESS,
+         t.fetch_row(reader, first, { true }, out,
+               isolation_level::REPEATABLE_READ, snapshot));
+   EXPECT_EQ(table::fetch_code::ISOLATED,
+         t.fetch_row(reader, first, { true }, out));
+}
+
+TEST(TableTest, CanCommitRows)
+{
+   using namespace lattice::cell;
+
+   table t
+      {
+      0, 1
+      };
+
+   t.set_column_definition(0, new column
+      {
+      column::data_type::integer, "col1"
+      });
+
+   auto tid = transaction_id::from_uint64(1);
+
+   std::string buffer;
+   t.to_binary({ true }, { "7" }, buffer);
+
+   std::vector<row_id> rids;
+   for (auto i = 0; i < 10; ++i)
+      {
+         row_id rid;
+         t.insert_row(tid, rid, { true }, buffer);
+         rids.push_back(rid);
+      }
+
+   // Leave a gap in the run, and a row that does not exist at the end.
+   rids.erase(rids.begin() + 4);
+   rids.push_back(rids.back() + 100);
+
+   EXPECT_EQ(9, t.commit_rows(tid, rids, 1));
+
+   auto reader = transaction_id::from_uint64(2);
+   std::size_t visible = 0;
+   for (auto pos = t.begin(); pos != t.end(); ++pos)
+      {
+         std::stringstream out;
+         if (t.fetch_row(reader, pos, { true }, out)
+               == table::fetch_code::SUCCESS)
+            {
+               ++visible;
+            }
+      }
+
+   EXPECT_EQ(9, visible);
+}
+
+TEST(TableTest, CanFilterRows)
+{
+   using namespace lattice::cell;
+
+   table t
+      {
+      0, 1
+      };
+
+   t.set_column_definition(0, new column
+      {
+      column::data_type::integer, "col1"
+      });
+
+   transaction_id tid_generator;
+   auto tid = tid_generator.next();
+
+   std::vector<row_id> rows;
+   for (auto i = 0; i < 10; ++i)
+      {
+         std::string in_buffer;
+         t.to_binary(
+            {
+            true
+            },
+            {
+            std::to_string(i)
+            }, in_buffer);
+
+         row_id rid;
+         t.insert_row(tid, rid,
+            {
+            true
+            }, in_buffer);
+         rows.push_back(rid);
+      }
+
+   auto pred = std::make_shared<scalar_predicate>();
+   pred->set_value(column::data_type::integer, 5);
+   pred->set_comparison(scalar_predicate::comparison::GREATER);
+
+   row_filter filter(0, pred);
+
+   for (auto i = 0; i < 10; ++i)
+      {
+         std::stringstream out;
+         auto code = t.fetch_row(tid, rows[i],
+            {
+            true
+            }, out, isolation_level::READ_COMMITTED, commit_clock::k_latest,
+               &filter);
+
+         if (i > 5)
+            {
+               EXPECT_EQ(table::fetch_code::SUCCESS, code);
+               EXPECT_FALSE(out.str().empty());
+            }
+         else
+            {
+               EXPECT_EQ(table::fetch_code::FILTERED, code);
+               EXPECT_TRUE(out.str().empty());
+            }
+      }
+
+   // An empty OR matches nothing, an empty AND everything.
+   row_filter none(row_filter::kind::OR, row_filter::children_type());
+   row_filter all;
+
+   std::stringstream out;
+   EXPECT_EQ(table::fetch_code::FILTERED, t.fetch_row(tid, rows[9],
+      {
+      true
+      }, out, isolation_level::READ_COMMITTED, commit_clock::k_latest, &none));
+   EXPECT_EQ(table::fetch_code::SUCCESS, t.fetch_row(tid, rows[0],
+      {
+      true
+      }, out, isolation_level::READ_COMMITTED, commit_clock::k_latest, &all));
+}
+
+TEST(TableTest, CanInsertRows)
+{
+   using namespace lattice::cell;
+
+   table t
+      {
+      0, 3
+      };
+
+   t.set_column_definition(0, new column
+      {
+      column::data_type::integer, "col1"
+      });
+   t.set_column_definition(1, new column
+      {
+      column::data_type::varchar, "col2"
+      });
+   t.set_column_definition(2, new column
+      {
+      column::data_type::double_precision, "col3"
+      });
+
+   transaction_id tid_generator;
+   auto tid = tid_generator.next();
+
+   // Row 1 has no col2, and col3 is left out altogether.
+   column_batch batch;
+   std::int32_t ids[] = { 10, 20, 30 };
+
+   auto& col1 = batch.add_column(0, column::data_type::integer);
+   col1.values.assign(static_cast<const char*>(
+         static_cast<const void*>(ids)), sizeof(ids));
+
+   auto& col2 = batch.add_column(1, column::data_type::varchar);
+   col2.values = "ab" "cde";
+   col2.offsets = { 0, 2, 2, 5 };
+   col2.nulls = std::string(1, '\x02');
+
+   batch.set_row_count(3);
+
+   std::vector<row_id> rids;
+   ASSERT_EQ(table::insert_code::SUCCESS, t.insert_rows(tid, batch, rids));
+   ASSERT_EQ(3, rids.size());
+   EXPECT_EQ(rids[0].to_uint64() + 2, rids[2].to_uint64());
+
+   table::text_tuple_type expected[] =
+      {
+         { "10", "ab" },
+         { "20", "" },
+         { "30", "cde" }
+      };
+
+   for (auto i = 0; i < 3; ++i)
+      {
+         std::vector<bool> present
+            {
+            true, i != 1
+            };
+
+         std::string in_buffer;
+         t.to_binary(present, expected[i], in_buffer);
+
+         std::stringstream out;
+         ASSERT_EQ(table::fetch_code::SUCCESS,
+               t.fetch_row(tid, rids[i], present, out));
+         EXPECT_EQ(in_buffer, out.str());
+      }
+
+   // Rows inserted one at a time carry on after the batch.
+   std::string in_buffer;
+   t.to_binary({ true }, { "40" }, in_buffer);
+
+   row_id rid;
+   ASSERT_EQ(table::insert_code::SUCCESS,
+         t.insert_row(tid, rid, { true }, in_buffer));
+   EXPECT_EQ(rids[2].to_uint64() + 1, rid.to_uint64());
+
+   // A batch that does not match the table inserts nothing.
+   column_batch short_batch;
+   short_batch.add_column(0, column::data_type::integer).values = "abc";
+   short_batch.set_row_count(1);
+   EXPECT_EQ(table::insert_code::UNDER_FLOW,
+         t.insert_rows(tid, short_batch, rids));
+
+   column_batch wrong_type;
+   wrong_type.add_column(2, column::data_type::integer).values = "abcd";
+   wrong_type.set_row_count(1);
+   EXPECT_EQ(table::insert_code::UNKNOWN_DATA_TYPE,
+         t.insert_rows(tid, wrong_type, rids));
+
+   // Nor does it use up any row ids.
+   row_id next_rid;
+   ASSERT_EQ(table::insert_code::SUCCESS,
+         t.insert_row(tid, next_rid, { true }, in_buffer));
+   EXPECT_EQ(rid.to_uint64() + 1, next_rid.to_uint64());
+}
@@ -0,0 +1,223 @@
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cell/cpp/ssi_lock_manager.h>
+#include <cell/cpp/table.h>
+#include <cell/cpp/transaction.h>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+/**
+ * Makes a one column table with a few committed rows, tracked by lm.
+ */
+std::shared_ptr<lattice::cell::table> make_table(
+      lattice::cell::ssi_lock_manager& lm, lattice::cell::commit_clock& clock)
+{
+   using namespace lattice::cell;
+
+   auto t = std::make_shared<table>(0, 1);
+
+   t->set_column_definition(0, new column
+      {
+      column::data_type::integer, "col1"
+      });
+   t->set_ssi_lock_manager(&lm);
+
+   transaction_id gen_tid;
+   auto tid = gen_tid.next();
+
+   for (auto i = 0; i < 3; ++i)
+      {
+         std::string data;
+         t->to_binary(
+            {
+            true
+            },
+            {
+            std::to_string(i)
+            }, data);
+
+         row_id rid;
+         t->insert_row(tid, rid,
+            {
+            true
+            }, data);
+         t->commit_row(tid, rid, clock.tick());
+      }
+
+   return t;
+}
+
+/**
+ * Reads every row a transaction can see from a fresh cursor.
+ */
+std::vector<std::int32_t> scan(lattice::cell::transaction& txn,
+      std::shared_ptr<lattice::cell::table> t)
+{
+   std::vector<std::int32_t> values;
+
+   std::string data;
+   auto& cursor = txn.get_cursor(txn.create_cursor(t));
+   while (txn.fetch_columns(cursor, data,
+      {
+      true
+      }))
+      {
+         std::int32_t value;
+         std::memcpy(&value, data.data(), sizeof(value));
+         values.push_back(value);
+      }
+
+   return values;
+}
+
+}
+
+TEST(TransactionTest, ReadOnlyCannotWrite)
+{
+   using namespace lattice::cell;
+
+   ssi_lock_manager lm;
+   commit_clock clock;
+   auto t = make_table(lm, clock);
+
+   transaction txn(transaction_id::from_uint64(100), clock.now());
+   txn.set_isolation_level(isolation_level::SERIALIZABLE);
+   txn.set_read_only(true);
+
+   EXPECT_TRUE(txn.is_read_only());
+
+   std::string data;
+   t->to_binary(
+      {
+      true
+      },
+      {
+      "7"
+      }, data);
+
+   EXPECT_FALSE(txn.insert_columns(t, data,
+      {
+      true
+      }));
+
+   auto& cursor = txn.get_cursor(txn.create_cursor(t));
+   EXPECT_FALSE(txn.update_columns(cursor, data,
+      {
+      true
+      }));
+}
+
+TEST(TransactionTest, SafeSnapshotSkipsTracking)
+{
+   using namespace lattice::cell;
+
+   ssi_lock_manager lm;
+   commit_clock clock;
+   auto t = make_table(lm, clock);
+
+   auto writer = transaction_id::from_uint64(200);
+   auto first_row = row_id::from_uint64(1);
+
+   transaction safe(transaction_id::from_uint64(100), clock.now());
+   safe.set_isolation_level(isolation_level::SERIALIZABLE);
+   safe.set_read_only(true);
+
+   EXPECT_EQ(isolation_level::REPEATABLE_READ, safe.get_read_level());
+
+   std::string data;
+   auto& cursor = safe.get_cursor(safe.create_cursor(t));
+   EXPECT_TRUE(safe.fetch_columns(cursor, data,
+      {
+      true
+      }));
+
+   // Nothing was recorded, so a write does not conflict.
+   EXPECT_FALSE(lm.track_write(writer, t->get_table_id(), first_row));
+
+   // An unsafe read only snapshot is tracked as usual.
+   transaction tracked(transaction_id::from_uint64(101), clock.now());
+   tracked.set_isolation_level(isolation_level::SERIALIZABLE);
+   tracked.set_read_only(false);
+
+   EXPECT_EQ(isolation_level::SERIALIZABLE, tracked.get_read_level());
+
+   auto& tracked_cursor = tracked.get_cursor(tracked.create_cursor(t));
+   EXPECT_TRUE(tracked.fetch_columns(tracked_cursor, data,
+      {
+      true
+      }));
+
+   EXPECT_TRUE(lm.track_write(writer, t->get_table_id(), first_row));
+}
+
+TEST(TransactionTest, CanUpdateThroughCursor)
+{
+   using namespace lattice::cell;
+
+   ssi_lock_manager lm;
+   commit_clock clock;
+   auto t = make_table(lm, clock);
+
+   std::string data;
+   t->to_binary(
+      {
+      true
+      },
+      {
+      "7"
+      }, data);
+
+   transaction writer(transaction_id::from_uint64(100), clock.now());
+
+   auto& cursor = writer.get_cursor(writer.create_cursor(t));
+   ASSERT_TRUE(writer.update_columns(cursor, data,
+      {
+      true
+      }));
+
+   // The writer sees its new version in place of the old one.
+   EXPECT_EQ((std::vector<std::int32_t> { 1, 2, 7 }), scan(writer, t));
+
+   writer.commit(clock.tick());
+
+   transaction reader(transaction_id::from_uint64(101), clock.now());
+   reader.set_isolation_level(isolation_level::REPEATABLE_READ);
+   EXPECT_EQ((std::vector<std::int32_t> { 1, 2, 7 }), scan(reader, t));
+
+   // The committed version can be updated again.
+   t->to_binary(
+      {
+      true
+      },
+      {
+      "8"
+      }, data);
+
+   transaction again(transaction_id::from_uint64(102), clock.now());
+   again.set_isolation_level(isolation_level::REPEATABLE_READ);
+
+   auto& again_cursor = again.get_cursor(again.create_cursor(t));
+   std::string skipped;
+   ASSERT_TRUE(again.fetch_columns(again_cursor, skipped,
+      {
+      true
+      }));
+   ASSERT_TRUE(again.fetch_columns(again_cursor, skipped,
+      {
+      true
+      }));
+   ASSERT_TRUE(again.update_columns(again_cursor, data,
+      {
+      true
+      }));
+   again.commit(clock.tick());
+
+   transaction last(transaction_id::from_uint64(103), clock.now());
+   EXPECT_EQ((std::vector<std::int32_t> { 1, 2, 8 }), scan(last, t));
+}
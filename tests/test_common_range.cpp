@@ -80,3 +80,60 @@ TEST(RangeTest, ContainsManySegments)
 
    ASSERT_EQ(num_segs, r.size());
 }
+
+TEST(RangeTest, MergesSegments)
+{
+   using namespace lattice::common;
+
+   range<int> r;
+
+   r.insert(10, 20);
+   r.insert(30, 40);
+   r.insert(50);
+   ASSERT_EQ(3, r.size());
+
+   // Already covered.
+   r.insert(12, 18);
+   ASSERT_EQ(3, r.size());
+
+   // Touching the end of a segment extends it.
+   r.insert(21, 25);
+   ASSERT_EQ(3, r.size());
+   EXPECT_EQ(25, r.front().second);
+
+   // Bridging segments merges them.
+   r.insert(24, 49);
+   ASSERT_EQ(1, r.size());
+   EXPECT_EQ(10, r.front().first);
+   EXPECT_EQ(50, r.front().second);
+
+   EXPECT_FALSE(r.contains(9));
+   EXPECT_TRUE(r.contains(10));
+   EXPECT_TRUE(r.contains(50));
+   EXPECT_FALSE(r.contains(51));
+}
+
+TEST(RangeTest, InsertsManyScatteredPoints)
+{
+   using namespace lattice::common;
+
+   range<int> r;
+
+   // Every other point, in reverse, then fill the gaps.
+   for (auto i = 200000; i > 0; i -= 2)
+      {
+         r.insert(i);
+      }
+
+   ASSERT_EQ(100000, r.size());
+
+   for (auto i = 1; i < 200000; i += 2)
+      {
+         r.insert(i);
+      }
+
+   ASSERT_EQ(1, r.size());
+   EXPECT_TRUE(r.contains(1));
+   EXPECT_TRUE(r.contains(200000));
+   EXPECT_FALSE(r.contains(200001));
+}
@@ -143,3 +143,52 @@ TEST_F(RowBufferTest, CanGetCurrentRow)
 		}
 }
 
+
+TEST_F(RowBufferTest, CanDequeueBatch)
+{
+	using namespace lattice::cell;
+	using namespace lattice::processor;
+
+	row_buffer rb(columns);
+
+	// Two rows, the second with no value for c1.
+	ColumnBatch batch;
+	batch.set_cursor(1);
+	batch.set_row_count(2);
+
+	std::int64_t ids[] = { 10, 11 };
+	std::int32_t c1[] = { 7, 0 };
+
+	auto* id_col = batch.add_columns();
+	id_col->set_column(0);
+	id_col->set_values(std::string(static_cast<const char*>(
+			static_cast<const void*>(ids)), sizeof(ids)));
+
+	auto* c1_col = batch.add_columns();
+	c1_col->set_column(1);
+	c1_col->set_values(std::string(static_cast<const char*>(
+			static_cast<const void*>(c1)), sizeof(c1)));
+	c1_col->set_nulls(std::string(1, '\x02'));
+
+	auto* c2_col = batch.add_columns();
+	c2_col->set_column(2);
+	c2_col->set_values("abcde");
+	c2_col->add_offsets(0);
+	c2_col->add_offsets(2);
+	c2_col->add_offsets(5);
+
+	rb.enqueue(batch);
+
+	rb.dequeue();
+	auto& row = rb.get_current_row();
+
+	ASSERT_EQ(columns.size(), row.size());
+	EXPECT_EQ(10, row[0].raw_int64_value());
+	EXPECT_EQ(7, row[1].raw_int32_value());
+	EXPECT_EQ("ab", *row[2].raw_string_value());
+
+	rb.dequeue();
+
+	EXPECT_EQ(11, rb.get_current_row()[0].raw_int64_value());
+	EXPECT_EQ("cde", *rb.get_current_row()[2].raw_string_value());
+}